@@ -0,0 +1,18 @@
+#version 330
+
+// Debug lines arrive in world space, see debug_draw.hpp
+in vec2 in_position;
+in vec3 in_color;
+
+out vec3 vcolor;
+
+// Application data
+uniform mat3 projection;
+uniform mat4 viewMatrix;
+
+void main()
+{
+	vcolor = in_color;
+	vec3 pos = projection * vec3(in_position, 1.0);
+	gl_Position = viewMatrix * vec4(pos.xy, 0.0, 1.0);
+}
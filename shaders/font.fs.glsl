@@ -1,13 +1,17 @@
 #version 330
 
 in vec2 TexCoords;
+flat in vec3 TextColor;
 out vec4 color;
 
+// Signed distance field, 0.5 on the glyph outline (see font_atlas.hpp)
 uniform sampler2D text;
-uniform vec3 textColor;
 
 void main() 
 {
- vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
- color = vec4(textColor, 1.0) * sampled;
-}
\ No newline at end of file
+	// Antialias over about one screen pixel whatever the text is scaled to
+	float distance = texture(text, TexCoords).r;
+	float width = max(0.7 * fwidth(distance), 1e-4);
+	float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+	color = vec4(TextColor, alpha);
+}
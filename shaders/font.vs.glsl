@@ -1,13 +1,23 @@
 #version 330
 
-layout (location = 0) in vec4 vertex;
+// Glyph quads arrive laid out around the string's origin, the string's slot
+// picks its placement and color for this flush
+layout (location = 0) in vec2 in_position;
+layout (location = 1) in vec2 in_texcoord;
+layout (location = 2) in float in_slot;
+
 out vec2 TexCoords;
+flat out vec3 TextColor;
 
+// Sized like TEXT_SLOTS in render_system.cpp
 uniform mat4 projection;
-uniform mat4 transform;
+uniform mat4 transforms[32];
+uniform vec3 colors[32];
 
 void main() 
 {
-	gl_Position = projection * transform * vec4(vertex.xy, 0.0, 1.0);
-	TexCoords = vertex.zw;
-}
\ No newline at end of file
+	int slot = int(in_slot);
+	gl_Position = projection * transforms[slot] * vec4(in_position, 0.0, 1.0);
+	TexCoords = in_texcoord;
+	TextColor = colors[slot];
+}
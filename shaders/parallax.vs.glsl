@@ -0,0 +1,23 @@
+#version 330
+
+// A screen space strip that repeats its texture horizontally. The quad is
+// generated from gl_VertexID, so no vertex buffer is bound.
+
+// Passed to fragment shader
+out vec2 texcoord;
+
+// Application data
+uniform vec4 rect;        // left, top, width, height in window pixels
+uniform vec2 tile_size;   // pixels covered by one repetition of the texture
+uniform float scroll;     // horizontal texture offset in pixels
+uniform int flip_y;
+uniform vec2 screen_size;
+
+void main()
+{
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 pixel = rect.xy + corner * rect.zw;
+	float v = corner.y * rect.w / tile_size.y;
+	texcoord = vec2((corner.x * rect.z + scroll) / tile_size.x, flip_y != 0 ? 1.0 - v : v);
+	gl_Position = vec4(pixel.x / screen_size.x * 2.0 - 1.0, 1.0 - pixel.y / screen_size.y * 2.0, 0.0, 1.0);
+}
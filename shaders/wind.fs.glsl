@@ -3,6 +3,7 @@
 uniform sampler2D screen_texture;
 uniform float time;
 uniform float darken_screen_factor;
+uniform float wind_strength;
 
 in vec2 texcoord;
 
@@ -11,7 +12,7 @@ layout(location = 0) out vec4 color;
 vec2 distort(vec2 uv) 
 {
 	// horizontal wind
-	//uv.x *= (0.005 * sin(time) + 1);
+	uv.x *= (wind_strength * sin(time) + 1);
 	return uv;
 }
 
@@ -0,0 +1,195 @@
+// internal
+#include "asset_pack.hpp"
+
+// stlib
+#include <cassert>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetPack asset_pack;
+
+uint64_t fnv1a(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER file_size;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	bytes = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (bytes == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_handle = file;
+	mapping_handle = mapping;
+	length = (size_t)file_size.QuadPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps the file alive
+	::close(fd);
+	if (mapping == MAP_FAILED)
+		return false;
+	bytes = (const unsigned char*)mapping;
+	length = (size_t)info.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes == nullptr)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(bytes);
+	CloseHandle((HANDLE)mapping_handle);
+	CloseHandle((HANDLE)file_handle);
+	file_handle = nullptr;
+	mapping_handle = nullptr;
+#else
+	munmap((void*)bytes, length);
+#endif
+	bytes = nullptr;
+	length = 0;
+}
+
+bool AssetPack::open(const std::string& path)
+{
+	close();
+	if (!file.open(path))
+		return false;
+
+	const PackHeader* header = (const PackHeader*)file.data();
+	if (file.size() < sizeof(PackHeader) || header->magic != pack_magic || header->version != pack_version ||
+		file.size() < sizeof(PackHeader) + header->entry_count * sizeof(PackEntry))
+	{
+		fprintf(stderr, "%s is not a version %u asset pack, cook it again\n", path.c_str(), pack_version);
+		file.close();
+		return false;
+	}
+
+	const PackEntry* entries = (const PackEntry*)(file.data() + sizeof(PackHeader));
+	for (uint32_t i = 0; i < header->entry_count; i++)
+	{
+		const PackEntry& entry = entries[i];
+		if (entry.offset + entry.size > file.size())
+		{
+			fprintf(stderr, "%s is truncated, cook it again\n", path.c_str());
+			close();
+			return false;
+		}
+		index[std::string(entry.name, strnlen(entry.name, sizeof(entry.name)))] = &entry;
+	}
+	return true;
+}
+
+void AssetPack::close()
+{
+	index.clear();
+	file.close();
+}
+
+const PackEntry* AssetPack::find(const std::string& path, PACK_ENTRY_TYPE type) const
+{
+	if (index.empty())
+		return nullptr;
+	const std::string prefix = data_path() + "/";
+	const std::string name = path.compare(0, prefix.size(), prefix) == 0 ? path.substr(prefix.size()) : path;
+	auto found = index.find(name);
+	if (found == index.end() || found->second->type != type)
+		return nullptr;
+	// Catches packs edited or damaged after cooking, too slow to do in release
+	assert(verify(*found->second));
+	return found->second;
+}
+
+bool AssetPack::texture(const std::string& path, const unsigned char*& rgba, ivec2& size) const
+{
+	const PackEntry* entry = find(path, PACK_ENTRY_TYPE::TEXTURE);
+	if (entry == nullptr)
+		return false;
+	rgba = data(*entry);
+	size = { (int)entry->params[0], (int)entry->params[1] };
+	return true;
+}
+
+bool AssetPack::mesh(const std::string& path, Mesh& out) const
+{
+	const PackEntry* entry = find(path, PACK_ENTRY_TYPE::MESH);
+	if (entry == nullptr)
+		return false;
+	const unsigned char* bytes = data(*entry);
+	memcpy(&out.original_size, bytes, sizeof(vec2));
+	const ColoredVertex* vertices = (const ColoredVertex*)(bytes + sizeof(vec2));
+	out.vertices.assign(vertices, vertices + entry->params[0]);
+	const uint16_t* indices = (const uint16_t*)(vertices + entry->params[0]);
+	out.vertex_indices.assign(indices, indices + entry->params[1]);
+	// The indices leave the samples unaligned
+	out.samples.resize(entry->params[2]);
+	memcpy(out.samples.data(), indices + entry->params[1], sizeof(vec2) * out.samples.size());
+	return true;
+}
+
+bool AssetPack::font(const std::string& path, unsigned int pixel_size, FontAtlas& out) const
+{
+	const PackEntry* entry = find(path, PACK_ENTRY_TYPE::FONT);
+	if (entry == nullptr || entry->params[2] != pixel_size)
+		return false;
+	const unsigned char* bytes = data(*entry);
+	memcpy(out.characters.data(), bytes, sizeof(Character) * out.characters.size());
+	out.size = { (int)entry->params[0], (int)entry->params[1] };
+	const unsigned char* pixels = bytes + sizeof(Character) * out.characters.size();
+	out.pixels.assign(pixels, pixels + out.size.x * out.size.y);
+	return true;
+}
+
+bool AssetPack::sound(const std::string& path, const unsigned char*& pcm, size_t& size, ivec3& spec) const
+{
+	const PackEntry* entry = find(path, PACK_ENTRY_TYPE::SOUND);
+	if (entry == nullptr)
+		return false;
+	pcm = data(*entry);
+	size = (size_t)entry->size;
+	spec = { (int)entry->params[0], (int)entry->params[1], (int)entry->params[2] };
+	return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "common.hpp"
+#include <glm/ext/vector_int3.hpp>
+#include "components.hpp"
+#include "font_atlas.hpp"
+
+// Cooked assets in a single file, written by tools/asset_cook.cpp and memory
+// mapped by the game. Every entry is stored exactly as it is uploaded or
+// played, so loading one is a lookup and a pointer into the mapping.
+//
+// Layout: PackHeader, then header.entry_count PackEntry records, then the
+// entry data, each blob 16 byte aligned. Structs are written as they are in
+// memory, a pack is cooked on and for the platform that runs it.
+const uint32_t pack_magic = 0x4B50484E; // "NHPK"
+// Bump whenever the layout or an entry's encoding changes
+const uint32_t pack_version = 3;
+
+enum class PACK_ENTRY_TYPE : uint32_t {
+	TEXTURE = 0, // RGBA8 rows top to bottom, params: width, height
+	MESH = 1,    // vec2 original size, ColoredVertex[], uint16_t[], vec2 samples[], params: vertex, index and sample count
+	FONT = 2,    // Character[128] then GL_RED distance field, params: atlas width, height, pixel size
+	SOUND = 3    // interleaved PCM, params: frequency, SDL audio format, channels
+};
+
+struct PackHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t reserved;
+};
+
+struct PackEntry
+{
+	char name[64];        // path relative to data/, e.g. "textures/bat_sheet.png"
+	PACK_ENTRY_TYPE type;
+	uint32_t params[3];
+	uint64_t offset;      // from the start of the file
+	uint64_t size;
+	uint64_t hash;        // FNV-1a of the entry data
+};
+
+uint64_t fnv1a(const void* data, size_t size);
+
+// Read only view of a whole file
+class MappedFile
+{
+public:
+	~MappedFile() { close(); }
+	bool open(const std::string& path);
+	void close();
+	const unsigned char* data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
+
+class AssetPack
+{
+public:
+	// Maps the pack, false if it is missing or was cooked for another version
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return !index.empty(); }
+
+	// Entry for a path under data/, absolute or relative to it, null if the
+	// pack does not have it
+	const PackEntry* find(const std::string& path, PACK_ENTRY_TYPE type) const;
+	const unsigned char* data(const PackEntry& entry) const { return file.data() + entry.offset; }
+	bool verify(const PackEntry& entry) const { return fnv1a(data(entry), (size_t)entry.size) == entry.hash; }
+
+	// Typed lookups, false if the entry is missing. Pixels and PCM point into
+	// the mapping and stay valid until close, meshes and fonts are copied out.
+	bool texture(const std::string& path, const unsigned char*& rgba, ivec2& size) const;
+	bool mesh(const std::string& path, Mesh& out) const;
+	bool font(const std::string& path, unsigned int pixel_size, FontAtlas& out) const;
+	bool sound(const std::string& path, const unsigned char*& pcm, size_t& size, ivec3& spec) const;
+
+private:
+	MappedFile file;
+	std::unordered_map<std::string, const PackEntry*> index;
+};
+
+inline std::string asset_pack_path() { return data_path() + "/assets.pack"; }
+
+// Opened at the top of main, everything falls back to data/ when it is not
+extern AssetPack asset_pack;
@@ -1,5 +1,24 @@
 #include "common.hpp"
 #include "tiny_ecs_registry.hpp"
+
+#include <cstring>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#include <cerrno>
+
+bool make_cache_dir()
+{
+	const std::string dir = data_path() + "/cache";
+#ifdef _WIN32
+	return _mkdir(dir.c_str()) == 0 || errno == EEXIST;
+#else
+	return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
 // Note, we could also use the functions from GLM but we write the transformations here to show the uderlying math
 void Transform::scale(vec2 scale)
 {
@@ -45,8 +64,50 @@ void Transform::mirrorYAxis(float radians) {
 	
 	
 }
+// Set once the KHR_debug callback reports errors for us
+static bool gl_debug_output_enabled = false;
+
+static void APIENTRY gl_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity,
+	GLsizei length, const GLchar* message, const void* user_param)
+{
+	(void)source; (void)id; (void)length; (void)user_param;
+	if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+		return;
+
+	// Only reported, the bench and headless paths hit harmless driver errors
+	fprintf(stderr, "OpenGL %s: %s\n", type == GL_DEBUG_TYPE_ERROR ? "error" : "warning", message);
+}
+
+bool gl_enable_debug_output()
+{
+	// KHR_debug is core since 4.3, but most drivers also expose it on our 3.3 context
+	bool has_khr_debug = gl3w_is_supported(4, 3) != 0;
+	GLint num_extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+	for (GLint i = 0; i < num_extensions && !has_khr_debug; i++)
+	{
+		const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		has_khr_debug = name != nullptr && strcmp(name, "GL_KHR_debug") == 0;
+	}
+	if (!has_khr_debug || glDebugMessageCallback == nullptr)
+		return false;
+
+	glEnable(GL_DEBUG_OUTPUT);
+#ifndef NDEBUG
+	// Report errors on the offending call, a breakpoint in gl_debug_message points at it
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+	glDebugMessageCallback(gl_debug_message, nullptr);
+	gl_debug_output_enabled = true;
+	return true;
+}
+
+#ifndef NDEBUG
 bool gl_has_errors()
 {
+	if (gl_debug_output_enabled)
+		return false;
+
 	GLenum error = glGetError();
 
 	if (error == GL_NO_ERROR) return false;
@@ -79,4 +140,5 @@ bool gl_has_errors()
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+#endif
@@ -30,6 +30,11 @@ inline std::string shader_path(const std::string& name) {return std::string(PROJ
 inline std::string textures_path(const std::string& name) {return data_path() + "/textures/" + std::string(name);};
 inline std::string audio_path(const std::string& name) {return data_path() + "/audio/" + std::string(name);};
 inline std::string mesh_path(const std::string& name) {return data_path() + "/meshes/" + std::string(name);};
+inline std::string level_path(const std::string& name) {return data_path() + "/levels/" + std::string(name);};
+// Files derived from data/ or the driver that can always be rebuilt, never committed
+inline std::string cache_path(const std::string& name) {return data_path() + "/cache/" + std::string(name);};
+// Creates the cache directory if it is missing, false if that fails
+bool make_cache_dir();
 
 // window size
 const int window_width_px = 1280;
@@ -68,7 +73,16 @@ struct Transform {
 	void rotateProjectile(float radians, Entity entity);
 };
 
+// Polling glGetError stalls the driver, so it is compiled out of release builds.
+// Debug builds also skip it once the KHR_debug callback has been installed.
+#ifdef NDEBUG
+inline bool gl_has_errors() { return false; }
+#else
 bool gl_has_errors();
+#endif
+
+// Installs the KHR_debug message callback if the context exposes it
+bool gl_enable_debug_output();
 
 enum GameState {
 	Intro,
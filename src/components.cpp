@@ -4,9 +4,13 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "../ext/stb_image/stb_image.h"
 
+#include "asset_pack.hpp" // for MappedFile
+
 // stlib
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 
 // json
 #include <json.hpp>
@@ -15,98 +19,166 @@ using json = nlohmann::json;
 Debug debugging;
 float death_timer_counter_ms = 3000;
 
-// Very, VERY simple OBJ loader from https://github.com/opengl-tutorials/ogl tutorial 7
-// (modified to also read vertex color and omit uv and normals)
-bool Mesh::loadFromOBJFile(std::string obj_path, std::vector<ColoredVertex>& out_vertices, std::vector<uint16_t>& out_vertex_indices, vec2& out_size)
+// Tokenizer for the OBJ subset our meshes use: "v x y z [r g b]" and
+// "f a b c ..." where each corner may carry /uv/normal indices, which are
+// ignored. The file is memory mapped and parsed in place.
+struct ObjTokenizer
 {
-	// disable warnings about fscanf and fopen on Windows
-#ifdef _MSC_VER
-#pragma warning(disable:4996)
-#endif
-
-	printf("Loading OBJ file %s...\n", obj_path.c_str());
-	// Note, normal and UV indices are not loaded/used, but code is commented to do so
-	std::vector<uint16_t> out_uv_indices, out_normal_indices;
-	std::vector<glm::vec2> out_uvs;
-	std::vector<glm::vec3> out_normals;
-
-	FILE* file = fopen(obj_path.c_str(), "r");
-	if (file == NULL) {
-		printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
-		getchar();
+	const char* p;
+	const char* end;
+
+	void skipSpaces() { while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++; }
+	void skipLine() { while (p < end && *p++ != '\n'); }
+	bool atLineEnd() { skipSpaces(); return p >= end || *p == '\n' || *p == '#'; }
+
+	// Decimal floats with an optional exponent, no inf or nan
+	bool parseFloat(float& out)
+	{
+		static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+			1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+		skipSpaces();
+		const char* start = p;
+		bool negative = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+'))
+			p++;
+		uint64_t mantissa = 0;
+		int digits = 0, exponent = 0;
+		for (; p < end && *p >= '0' && *p <= '9'; p++)
+			if (digits < 18) { mantissa = mantissa * 10 + (*p - '0'); digits++; }
+			else exponent++;
+		if (p < end && *p == '.')
+			for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+				if (digits < 18) { mantissa = mantissa * 10 + (*p - '0'); digits++; exponent--; }
+		if (p == start || (p == start + 1 && (*start == '-' || *start == '+')))
+			return false;
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			p++;
+			bool negative_exponent = p < end && *p == '-';
+			if (p < end && (*p == '-' || *p == '+'))
+				p++;
+			int value = 0;
+			for (; p < end && *p >= '0' && *p <= '9'; p++)
+				value = std::min(value * 10 + (*p - '0'), 1000);
+			exponent += negative_exponent ? -value : value;
+		}
+		double result = (double)mantissa;
+		for (; exponent > 18; exponent -= 18) result *= powers[18];
+		for (; exponent < -18; exponent += 18) result /= powers[18];
+		result = exponent >= 0 ? result * powers[exponent] : result / powers[-exponent];
+		out = (float)(negative ? -result : result);
+		return true;
+	}
+
+	// One face corner, returns the vertex index and skips "/uv/normal"
+	bool parseCorner(long& out)
+	{
+		skipSpaces();
+		bool negative = p < end && *p == '-';
+		if (negative)
+			p++;
+		if (p >= end || *p < '0' || *p > '9')
+			return false;
+		long value = 0;
+		for (; p < end && *p >= '0' && *p <= '9'; p++)
+			value = value * 10 + (*p - '0');
+		while (p < end && (*p == '/' || (*p >= '0' && *p <= '9') || *p == '-'))
+			p++;
+		out = negative ? -value : value;
+		return true;
+	}
+};
+
+bool Mesh::loadFromOBJFile(std::string obj_path, std::vector<ColoredVertex>& out_vertices, std::vector<uint16_t>& out_vertex_indices, vec2& out_size, std::vector<vec2>& out_samples)
+{
+	MappedFile file;
+	if (!file.open(obj_path))
+	{
+		fprintf(stderr, "Could not open OBJ file %s\n", obj_path.c_str());
 		return false;
 	}
 
-	while (1) {
-		char lineHeader[128];
-		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
+	std::vector<ColoredVertex> positions;
+	std::vector<long> corners; // 1 based as in the file, triangulated as a fan
+	ObjTokenizer tokens = { (const char*)file.data(), (const char*)file.data() + file.size() };
+	while (tokens.p < tokens.end)
+	{
+		tokens.skipSpaces();
+		const char* keyword = tokens.p;
+		while (tokens.p < tokens.end && *tokens.p != ' ' && *tokens.p != '\t' && *tokens.p != '\n' && *tokens.p != '\r')
+			tokens.p++;
+		const size_t keyword_length = tokens.p - keyword;
 
-		if (strcmp(lineHeader, "v") == 0) {
+		if (keyword_length == 1 && *keyword == 'v')
+		{
 			ColoredVertex vertex;
-			int matches = fscanf(file, "%f %f %f %f %f %f\n", &vertex.position.x, &vertex.position.y, &vertex.position.z,
-				&vertex.color.x, &vertex.color.y, &vertex.color.z);
-			if (matches == 3)
-				vertex.color = { 1,1,1 };
-			out_vertices.push_back(vertex);
-		}
-		else if (strcmp(lineHeader, "vt") == 0) {
-			glm::vec2 uv;
-			fscanf(file, "%f %f\n", &uv.x, &uv.y);
-			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
-			out_uvs.push_back(uv);
+			if (!tokens.parseFloat(vertex.position.x) || !tokens.parseFloat(vertex.position.y) || !tokens.parseFloat(vertex.position.z))
+			{
+				fprintf(stderr, "Malformed vertex in %s\n", obj_path.c_str());
+				return false;
+			}
+			if (tokens.atLineEnd() || !tokens.parseFloat(vertex.color.x) || !tokens.parseFloat(vertex.color.y) || !tokens.parseFloat(vertex.color.z))
+				vertex.color = { 1, 1, 1 };
+			positions.push_back(vertex);
 		}
-		else if (strcmp(lineHeader, "vn") == 0) {
-			glm::vec3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-			out_normals.push_back(normal);
+		else if (keyword_length == 1 && *keyword == 'f')
+		{
+			long first, previous, corner;
+			if (!tokens.parseCorner(first) || !tokens.parseCorner(previous))
+			{
+				fprintf(stderr, "Malformed face in %s\n", obj_path.c_str());
+				return false;
+			}
+			while (!tokens.atLineEnd() && tokens.parseCorner(corner))
+			{
+				corners.push_back(first);
+				corners.push_back(previous);
+				corners.push_back(corner);
+				previous = corner;
+			}
 		}
-		else if (strcmp(lineHeader, "f") == 0) {
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], normalIndex[3], uvIndex[3];
+		// Normals, uvs, comments and anything else are not used
+		tokens.skipLine();
+	}
 
-			int matches = fscanf(file, "%d %d %d\n", &vertexIndex[0], &vertexIndex[1], &vertexIndex[2]);
-			if (matches == 1) // try again
+	// Identical position and colour pairs share one output vertex
+	std::vector<int> remap(positions.size(), -1);
+	std::unordered_map<std::string, uint16_t> unique;
+	out_vertices.reserve(out_vertices.size() + positions.size());
+	out_vertex_indices.reserve(out_vertex_indices.size() + corners.size());
+	for (long corner : corners)
+	{
+		const long i = corner < 0 ? (long)positions.size() + corner : corner - 1;
+		if (i < 0 || i >= (long)positions.size())
+		{
+			fprintf(stderr, "Face index %ld out of range in %s\n", corner, obj_path.c_str());
+			return false;
+		}
+		if (remap[i] < 0)
+		{
+			const std::string key((const char*)&positions[i], sizeof(ColoredVertex));
+			auto found = unique.find(key);
+			if (found != unique.end())
+				remap[i] = found->second;
+			else
 			{
-				// Note first vertex index is already consumed by the first fscanf call (match ==1) since it aborts on the first error
-				matches = fscanf(file, "//%d %d//%d %d//%d\n", &normalIndex[0], &vertexIndex[1], &normalIndex[1], &vertexIndex[2], &normalIndex[2]);
-				if (matches != 5) // try again
+				if (out_vertices.size() > UINT16_MAX)
 				{
-					matches = fscanf(file, "%d/%d %d/%d/%d %d/%d/%d\n", &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-					if (matches != 8)
-					{
-						printf("File can't be read by our simple parser :-( Try exporting with other options\n");
-						fclose(file);
-						return false;
-					}
+					fprintf(stderr, "%s has more vertices than uint16_t indices can address\n", obj_path.c_str());
+					return false;
 				}
+				remap[i] = (int)out_vertices.size();
+				unique.emplace(key, (uint16_t)out_vertices.size());
+				out_vertices.push_back(positions[i]);
 			}
-
-			// -1 since .obj starts counting at 1 and OpenGL starts at 0
-			out_vertex_indices.push_back((uint16_t)vertexIndex[0] - 1);
-			out_vertex_indices.push_back((uint16_t)vertexIndex[1] - 1);
-			out_vertex_indices.push_back((uint16_t)vertexIndex[2] - 1);
-			//out_uv_indices.push_back(uvIndex[0] - 1);
-			//out_uv_indices.push_back(uvIndex[1] - 1);
-			//out_uv_indices.push_back(uvIndex[2] - 1);
-			out_normal_indices.push_back((uint16_t)normalIndex[0] - 1);
-			out_normal_indices.push_back((uint16_t)normalIndex[1] - 1);
-			out_normal_indices.push_back((uint16_t)normalIndex[2] - 1);
-		}
-		else {
-			// Probably a comment, eat up the rest of the line
-			char stupidBuffer[1000];
-			fgets(stupidBuffer, 1000, file);
 		}
+		out_vertex_indices.push_back((uint16_t)remap[i]);
 	}
-	fclose(file);
 
 	// Compute bounds of the mesh
 	vec3 max_position = { -99999,-99999,-99999 };
 	vec3 min_position = { 99999,99999,99999 };
-	for (ColoredVertex& pos : out_vertices)
+	for (ColoredVertex& pos : positions)
 	{
 		max_position = glm::max(max_position, pos.position);
 		min_position = glm::min(min_position, pos.position);
@@ -120,6 +192,8 @@ bool Mesh::loadFromOBJFile(std::string obj_path, std::vector<ColoredVertex>& out
 	// Normalize mesh to range -0.5 ... 0.5
 	for (ColoredVertex& pos : out_vertices)
 		pos.position = ((pos.position - min_position) / size3d) - vec3(0.5f, 0.5f, 0.5f);
+	for (size_t i = 0; i < positions.size(); i += mesh_sample_step)
+		out_samples.push_back(vec2(((positions[i].position - min_position) / size3d) - vec3(0.5f, 0.5f, 0.5f)));
 
 	return true;
 }
\ No newline at end of file
@@ -1175,12 +1175,11 @@ extern Debug debugging;
 struct ScreenState
 {
 	float darken_screen_factor = -1;
-};
+	// Horizontal wind distortion of the whole screen, 0 turns it off
+	float wind_strength = 0;
 
-// A struct to refer to debugging graphics in the ECS
-struct DebugComponent
-{
-	// Note, an empty struct has size 1
+	// The offscreen post-processing pass only runs while an effect is visible
+	bool needsPostProcess() const { return darken_screen_factor > 0 || wind_strength > 0; }
 };
 
 struct AttackPathTimer
@@ -1214,13 +1213,23 @@ struct Text {
 
 // Character for font
 struct Character {
-	unsigned int TextureID;  // ID handle of the glyph texture
-	glm::ivec2   Size;       // Size of glyph
-	glm::ivec2   Bearing;    // Offset from baseline to left/top of glyph
-	unsigned int Advance;    // Offset to advance to next glyph
+	vec2         UVMin;      // Top-left corner of the glyph in the font atlas
+	vec2         UVMax;      // Bottom-right corner of the glyph in the font atlas
+	vec2         Size;       // Size of the glyph quad in layout pixels, SDF border included
+	vec2         Bearing;    // Offset from baseline to left/top of the quad
+	unsigned int Advance;    // Offset to advance to next glyph, in 1/64 layout pixels
 	char character;
 };
 
+// Single Vertex Buffer element for cached text (font.vs.glsl), positions are
+// relative to the string's origin
+struct TextVertex
+{
+	vec2 position;
+	vec2 texcoord;
+	float slot; // index of the string's placement and color in the flush
+};
+
 
 // Single Vertex Buffer element for non-textured meshes (coloured.vs.glsl & player.vs.glsl)
 struct ColoredVertex
@@ -1237,12 +1246,18 @@ struct TexturedVertex
 };
 
 // Mesh datastructure for storing vertex and index buffers
+// Every this many OBJ vertices one is kept as a hit test sample
+const int mesh_sample_step = 25;
+
 struct Mesh
 {
-	static bool loadFromOBJFile(std::string obj_path, std::vector<ColoredVertex>& out_vertices, std::vector<uint16_t>& out_vertex_indices, vec2& out_size);
+	static bool loadFromOBJFile(std::string obj_path, std::vector<ColoredVertex>& out_vertices, std::vector<uint16_t>& out_vertex_indices, vec2& out_size, std::vector<vec2>& out_samples);
 	vec2 original_size = {1,1};
 	std::vector<ColoredVertex> vertices;
 	std::vector<uint16_t> vertex_indices;
+	// Normalized like vertices but taken in OBJ file order, which merging
+	// vertices does not keep, see collidesMeshBox
+	std::vector<vec2> samples;
 };
 
 /**
@@ -1329,7 +1344,9 @@ enum class EFFECT_ASSET_ID {
 	TEXTURED = PLAYER + 1,
 	TEXTUREDFIXED = TEXTURED + 1,
 	WIND = TEXTUREDFIXED + 1,
-	EFFECT_COUNT = WIND + 1
+	PARALLAX = WIND + 1,
+	DEBUG_LINES = PARALLAX + 1,
+	EFFECT_COUNT = DEBUG_LINES + 1
 };
 const int effect_count = (int)EFFECT_ASSET_ID::EFFECT_COUNT;
 
@@ -1339,8 +1356,7 @@ enum class GEOMETRY_BUFFER_ID {
 	PLAYER_ATTACK2 = PLAYER_ATTACK1 + 1,
 	SPRITE = PLAYER_ATTACK2 + 1,
 	EGG = SPRITE + 1,
-	DEBUG_LINE = EGG + 1,
-	PLAYER_HEART = DEBUG_LINE + 1,
+	PLAYER_HEART = EGG + 1,
 	PLAYER_SHIELD = PLAYER_HEART + 1,
 	SAW = PLAYER_SHIELD + 1,
 	MAGICBALL1 = SAW + 1,
@@ -1360,9 +1376,34 @@ enum class GEOMETRY_BUFFER_ID {
 };
 const int geometry_count = (int)GEOMETRY_BUFFER_ID::GEOMETRY_COUNT;
 
+// Layers are drawn back to front, within a layer draws are grouped by
+// effect, texture and geometry, so spawn order does not affect the result
+enum class RENDER_LAYER {
+	BACKGROUND = 0,
+	PARALLAX = BACKGROUND + 1,
+	STATIC = PARALLAX + 1,
+	ACTORS = STATIC + 1,
+	PROJECTILES = ACTORS + 1,
+	HUD = PROJECTILES + 1,
+	LAYER_COUNT = HUD + 1
+};
+const int render_layer_count = (int)RENDER_LAYER::LAYER_COUNT;
+
 struct RenderRequest {
 	TEXTURE_ASSET_ID used_texture = TEXTURE_ASSET_ID::TEXTURE_COUNT;
 	EFFECT_ASSET_ID used_effect = EFFECT_ASSET_ID::EFFECT_COUNT;
 	GEOMETRY_BUFFER_ID used_geometry = GEOMETRY_BUFFER_ID::GEOMETRY_COUNT;
+	RENDER_LAYER layer = RENDER_LAYER::ACTORS;
+};
+
+// A horizontally repeating strip of the screen drawn in the PARALLAX layer,
+// its texture scrolls by the camera position divided by speed_factor
+struct ParallaxLayer {
+	TEXTURE_ASSET_ID texture;
+	vec2 screen_pos;   // top left corner in window pixels
+	vec2 screen_size;
+	vec2 tile_size;    // pixels covered by one repetition of the texture
+	float speed_factor; // larger the factor, slower the movement
+	bool flip_y;
 };
 
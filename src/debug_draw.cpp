@@ -0,0 +1,41 @@
+#include "debug_draw.hpp"
+
+// Lines of the current world step
+static std::vector<DebugVertex> debug_vertices;
+
+void debug_line(vec2 from, vec2 to, vec3 color)
+{
+	if (debug_vertices.size() + 2 > max_debug_vertices)
+		return;
+	debug_vertices.push_back({ from, color });
+	debug_vertices.push_back({ to, color });
+}
+
+void debug_box(vec2 center, vec2 size, vec3 color)
+{
+	const vec2 half = abs(size) / 2.f;
+	const vec2 top_left = center - half;
+	const vec2 bottom_right = center + half;
+	debug_line(top_left, { bottom_right.x, top_left.y }, color);
+	debug_line({ bottom_right.x, top_left.y }, bottom_right, color);
+	debug_line(bottom_right, { top_left.x, bottom_right.y }, color);
+	debug_line({ top_left.x, bottom_right.y }, top_left, color);
+}
+
+void debug_point(vec2 position, vec3 color, float size)
+{
+	const float half = size / 2.f;
+	debug_line(position - vec2(half, 0.f), position + vec2(half, 0.f), color);
+	debug_line(position - vec2(0.f, half), position + vec2(0.f, half), color);
+}
+
+void clear_debug_lines()
+{
+	debug_vertices.clear();
+}
+
+void copy_debug_lines(std::vector<DebugVertex>& out)
+{
+	// The frame's vector keeps its capacity across frames
+	out.assign(debug_vertices.begin(), debug_vertices.end());
+}
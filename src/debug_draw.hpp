@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include "common.hpp"
+
+// Immediate mode debug lines, kept out of the ECS. Lines added from the main
+// thread during a world step are drawn by every RenderSystem::draw until the
+// next step starts, in one GL_LINES call on top of the sprites, so nothing
+// has to be cleaned up and they do not flicker when frames outpace steps.
+// Positions are in world space, the same as Motion::position.
+struct DebugVertex
+{
+	vec2 position;
+	vec3 color;
+};
+
+// Lines beyond this many vertices in one frame are dropped
+const size_t max_debug_vertices = 8192;
+
+void debug_line(vec2 from, vec2 to, vec3 color);
+// Outline of an axis aligned box, size may be negative as for mirrored motions
+void debug_box(vec2 center, vec2 size, vec3 color);
+// Small cross
+void debug_point(vec2 position, vec3 color, float size = 5.f);
+
+// Forgets the last step's lines, called at the top of WorldSystem::step
+void clear_debug_lines();
+// Copies the lines added since the last clear, see RenderSystem::buildFrame
+void copy_debug_lines(std::vector<DebugVertex>& out);
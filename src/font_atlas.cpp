@@ -0,0 +1,216 @@
+// internal
+#include "font_atlas.hpp"
+#include "startup_report.hpp"
+
+// fonts
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// stlib
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Glyphs are rasterized this many times larger than font_sdf_size and the
+// distance field is sampled down from that, which keeps curves smooth
+static const int sdf_oversample = 4;
+
+// 8-points signed sequential Euclidean distance transform (8SSEDT). Every
+// cell ends up holding the offset to the nearest seed cell.
+struct SdfGrid
+{
+	int width, height;
+	std::vector<ivec2> offsets;
+
+	SdfGrid(int w, int h) : width(w), height(h), offsets(w * h) {}
+
+	static int length2(ivec2 offset) { return offset.x * offset.x + offset.y * offset.y; }
+
+	void compare(ivec2& cell, int x, int y, int dx, int dy)
+	{
+		const int nx = x + dx, ny = y + dy;
+		if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+			return;
+		const ivec2 other = offsets[ny * width + nx] + ivec2(dx, dy);
+		if (length2(other) < length2(cell))
+			cell = other;
+	}
+
+	void propagate()
+	{
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				ivec2& cell = offsets[y * width + x];
+				compare(cell, x, y, -1, 0);
+				compare(cell, x, y, 0, -1);
+				compare(cell, x, y, -1, -1);
+				compare(cell, x, y, 1, -1);
+			}
+			for (int x = width - 1; x >= 0; x--)
+				compare(offsets[y * width + x], x, y, 1, 0);
+		}
+		for (int y = height - 1; y >= 0; y--)
+		{
+			for (int x = width - 1; x >= 0; x--)
+			{
+				ivec2& cell = offsets[y * width + x];
+				compare(cell, x, y, 1, 0);
+				compare(cell, x, y, 0, 1);
+				compare(cell, x, y, -1, 1);
+				compare(cell, x, y, 1, 1);
+			}
+			for (int x = 0; x < width; x++)
+				compare(offsets[y * width + x], x, y, -1, 0);
+		}
+	}
+};
+
+// Distance field of a coverage bitmap, padded by spread pixels on every side
+// and sampled down by sdf_oversample. out_size is the size of the result.
+static std::vector<unsigned char> distance_field(const FT_Bitmap& bitmap, int spread, ivec2& out_size)
+{
+	const int pad = spread * sdf_oversample;
+	const int width = bitmap.width + 2 * pad;
+	const int height = bitmap.rows + 2 * pad;
+	const ivec2 far_away = { 9999, 9999 };
+
+	// One grid seeded with the glyph, one with the space around it
+	SdfGrid outside(width, height), inside(width, height);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+		{
+			const int bx = x - pad, by = y - pad;
+			const bool covered = bx >= 0 && by >= 0 && bx < (int)bitmap.width && by < (int)bitmap.rows &&
+				bitmap.buffer[by * bitmap.pitch + bx] >= 128;
+			outside.offsets[y * width + x] = covered ? ivec2(0) : far_away;
+			inside.offsets[y * width + x] = covered ? far_away : ivec2(0);
+		}
+	outside.propagate();
+	inside.propagate();
+
+	out_size = { (width + sdf_oversample - 1) / sdf_oversample, (height + sdf_oversample - 1) / sdf_oversample };
+	std::vector<unsigned char> field(out_size.x * out_size.y);
+	for (int y = 0; y < out_size.y; y++)
+		for (int x = 0; x < out_size.x; x++)
+		{
+			const int sx = std::min(x * sdf_oversample + sdf_oversample / 2, width - 1);
+			const int sy = std::min(y * sdf_oversample + sdf_oversample / 2, height - 1);
+			// Positive outside the glyph, in oversampled pixels
+			const float distance = sqrtf((float)SdfGrid::length2(outside.offsets[sy * width + sx])) -
+				sqrtf((float)SdfGrid::length2(inside.offsets[sy * width + sx]));
+			const float value = 0.5f - distance / (2.f * pad);
+			field[y * out_size.x + x] = (unsigned char)(glm::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+		}
+	return field;
+}
+
+bool rasterize_font(const std::string& font_filename, unsigned int font_default_size, FontAtlas& out)
+{
+	StartupTimer timer("font", font_filename);
+
+	// init FreeType fonts
+	FT_Library ft;
+	if (FT_Init_FreeType(&ft))
+	{
+		std::cerr << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+		return false;
+	}
+
+	FT_Face face;
+	if (FT_New_Face(ft, font_filename.c_str(), 0, &face))
+	{
+		std::cerr << "ERROR::FREETYPE: Failed to load font: " << font_filename << std::endl;
+		FT_Done_FreeType(ft);
+		return false;
+	}
+
+	// Glyphs are rasterized large and stored at font_sdf_size, their metrics
+	// are scaled to what a font_default_size font would have
+	FT_Set_Pixel_Sizes(face, 0, font_sdf_size * sdf_oversample);
+	const float layout_scale = (float)font_default_size / (float)(font_sdf_size * sdf_oversample);
+
+	// Turn the first 128 ASCII chars into distance fields and shelf-pack them
+	// into one atlas so that a whole frame of text shares a single texture
+	const int atlas_width = 512;
+	const int glyph_padding = 1;
+	std::array<std::vector<unsigned char>, 128> fields;
+	std::array<ivec2, 128> field_sizes;
+	std::array<ivec2, 128> offsets;
+	int pen_x = glyph_padding;
+	int pen_y = glyph_padding;
+	int row_height = 0;
+	for (unsigned char c = 0; c < 128; c++)
+	{
+		out.characters[c] = Character();
+		offsets[c] = { 0, 0 };
+		field_sizes[c] = { 0, 0 };
+		// Control characters are never drawn, they would only be notdef boxes
+		if (c < 32 || c == 127)
+			continue;
+
+		// load character glyph 
+		if (FT_Load_Char(face, c, FT_LOAD_RENDER))
+		{
+			std::cerr << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+			continue;
+		}
+
+		// Blank glyphs such as space only advance the pen
+		const FT_Bitmap& bitmap = face->glyph->bitmap;
+		const unsigned int advance = (unsigned int)(face->glyph->advance.x * layout_scale);
+		if (bitmap.width == 0 || bitmap.rows == 0)
+		{
+			out.characters[c].Advance = advance;
+			out.characters[c].character = (char)c;
+			continue;
+		}
+
+		fields[c] = distance_field(bitmap, font_sdf_spread, field_sizes[c]);
+		const ivec2 size = field_sizes[c];
+		if (pen_x + size.x + glyph_padding > atlas_width)
+		{
+			pen_x = glyph_padding;
+			pen_y += row_height + glyph_padding;
+			row_height = 0;
+		}
+		offsets[c] = { pen_x, pen_y };
+		pen_x += size.x + glyph_padding;
+		row_height = std::max(row_height, size.y);
+
+		// now store character for later use, UVs are filled in once the atlas size is known
+		const float pad = (float)(font_sdf_spread * sdf_oversample);
+		out.characters[c] = {
+			vec2(0.f),
+			vec2(0.f),
+			vec2(size * sdf_oversample) * layout_scale,
+			vec2(face->glyph->bitmap_left - pad, face->glyph->bitmap_top + pad) * layout_scale,
+			advance,
+			(char)c
+		};
+	}
+
+	int atlas_height = 1;
+	while (atlas_height < pen_y + row_height + glyph_padding)
+		atlas_height *= 2;
+
+	out.size = { atlas_width, atlas_height };
+	out.pixels.assign(atlas_width * atlas_height, 0);
+	for (unsigned char c = 0; c < 128; c++)
+	{
+		Character& ch = out.characters[c];
+		const ivec2 size = field_sizes[c];
+		for (int row = 0; row < size.y; row++)
+			memcpy(out.pixels.data() + (offsets[c].y + row) * atlas_width + offsets[c].x, fields[c].data() + row * size.x, size.x);
+		ch.UVMin = vec2(offsets[c]) / vec2(atlas_width, atlas_height);
+		ch.UVMax = vec2(offsets[c] + size) / vec2(atlas_width, atlas_height);
+	}
+
+	// clean up
+	FT_Done_Face(face);
+	FT_Done_FreeType(ft);
+
+	return true;
+}
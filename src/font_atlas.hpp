@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "components.hpp"
+
+// Glyphs of the first 128 ASCII chars as signed distance fields packed into
+// one GL_RED texture. 0.5 is the glyph outline, higher values are inside, and
+// the field fades to 0 or 1 over font_sdf_spread atlas pixels. The atlas is
+// rasterized at font_sdf_size whatever size the text is laid out at, the font
+// shader keeps the outline sharp at any scale.
+const unsigned int font_sdf_size = 32;
+const int font_sdf_spread = 4;
+
+struct FontAtlas
+{
+	std::array<Character, 128> characters;
+	std::vector<unsigned char> pixels;
+	ivec2 size;
+};
+
+// Rasterizes a font with FreeType, touches no GL so it can run on any thread.
+// Character metrics are in pixels of a font_default_size font.
+bool rasterize_font(const std::string& font_filename, unsigned int font_default_size, FontAtlas& out);
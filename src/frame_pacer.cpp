@@ -0,0 +1,110 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+void FramePacer::init(PACING_MODE mode_arg, float target_hz)
+{
+	mode = mode_arg;
+	period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(target_hz, 1.f)));
+	deadline = Clock::now();
+	has_last_frame = false;
+	histogram.fill(0);
+	frames = 0;
+	mean = 0;
+	m2 = 0;
+	min_ms = 0;
+	max_ms = 0;
+}
+
+void FramePacer::wait()
+{
+	if (mode != PACING_MODE::FIXED)
+	{
+		record(Clock::now());
+		return;
+	}
+
+	deadline += period;
+	Clock::time_point now = Clock::now();
+	// After a long stall (loading, window drag) start over rather than
+	// rushing out the missed frames
+	if (now > deadline + period)
+		deadline = now;
+
+	// Sleep while the deadline is further away than a sleep may overshoot
+	const Clock::duration slice = std::chrono::milliseconds(1);
+	while (deadline - now > spin_margin)
+	{
+		std::this_thread::sleep_for(slice);
+		Clock::time_point woke = Clock::now();
+		// Track the worst recent oversleep, decaying slowly so one bad
+		// wake up does not make us spin for long
+		Clock::duration oversleep = (woke - now) - slice;
+		spin_margin = std::max(oversleep + oversleep / 2, spin_margin - spin_margin / 64);
+		now = woke;
+	}
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+
+	record(Clock::now());
+}
+
+void FramePacer::record(Clock::time_point now)
+{
+	if (!has_last_frame)
+	{
+		has_last_frame = true;
+		last_frame = now;
+		return;
+	}
+	const float ms = (float)(std::chrono::duration_cast<std::chrono::microseconds>(now - last_frame)).count() / 1000;
+	last_frame = now;
+	last_ms = ms;
+
+	const int bin = std::min((int)(ms * 10), histogram_bins - 1);
+	histogram[bin]++;
+
+	frames++;
+	const double delta = ms - mean;
+	mean += delta / frames;
+	m2 += delta * (ms - mean);
+	min_ms = frames == 1 ? ms : std::min(min_ms, ms);
+	max_ms = frames == 1 ? ms : std::max(max_ms, ms);
+}
+
+FramePacer::Stats FramePacer::getStats() const
+{
+	Stats stats = { frames, (float)mean, 0.f, min_ms, max_ms, 0.f, 0.f };
+	if (frames == 0)
+		return stats;
+	stats.jitter_ms = (float)std::sqrt(m2 / frames);
+
+	// Percentiles from the histogram, to the upper edge of their bin
+	const unsigned int p50 = (frames + 1) / 2;
+	const unsigned int p99 = frames - frames / 100;
+	unsigned int seen = 0;
+	for (int i = 0; i < histogram_bins; i++)
+	{
+		const unsigned int before = seen;
+		seen += histogram[i];
+		if (before < p50 && seen >= p50)
+			stats.p50_ms = (i + 1) / 10.f;
+		if (before < p99 && seen >= p99)
+		{
+			stats.p99_ms = (i + 1) / 10.f;
+			break;
+		}
+	}
+	return stats;
+}
+
+void FramePacer::printStats() const
+{
+	static const char* mode_names[] = { "vsync", "fixed", "uncapped" };
+	const Stats stats = getStats();
+	printf("Frame pacing (%s): %u frames, mean %.2fms, jitter %.2fms, min %.2fms, p50 %.1fms, p99 %.1fms, max %.2fms\n",
+		mode_names[(int)mode], stats.frames, stats.mean_ms, stats.jitter_ms, stats.min_ms, stats.p50_ms, stats.p99_ms, stats.max_ms);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+
+// How the main loop is paced
+enum class PACING_MODE {
+	VSYNC,    // the buffer swap blocks until the display's refresh
+	FIXED,    // the loop sleeps until the next tick of a fixed rate
+	UNCAPPED  // as fast as possible
+};
+
+// Caps the main loop's frame rate without burning a core and keeps frame time
+// statistics for tuning. Waits sleep in short slices while comfortably ahead
+// of the deadline and spin only for the last stretch, whose length adapts to
+// how much the OS oversleeps.
+class FramePacer
+{
+public:
+	using Clock = std::chrono::high_resolution_clock;
+
+	void init(PACING_MODE mode, float target_hz);
+	PACING_MODE getMode() const { return mode; }
+
+	// Blocks until the next frame is due, call once at the end of every
+	// iteration. Also records the time since the previous call.
+	void wait();
+
+	// Frame time distribution since init, in milliseconds
+	struct Stats
+	{
+		unsigned int frames;
+		float mean_ms;
+		float jitter_ms; // standard deviation
+		float min_ms;
+		float max_ms;
+		float p50_ms;
+		float p99_ms;
+	};
+	Stats getStats() const;
+	void printStats() const;
+	// Length of the frame the last wait() closed, 0 before the second one
+	float lastFrameMs() const { return last_ms; }
+
+private:
+	void record(Clock::time_point now);
+
+	PACING_MODE mode = PACING_MODE::UNCAPPED;
+	Clock::duration period = Clock::duration::zero();
+	Clock::time_point deadline;
+	Clock::time_point last_frame;
+	bool has_last_frame = false;
+	// Expected oversleep of a 1ms sleep, the spin covers this much
+	Clock::duration spin_margin = std::chrono::milliseconds(2);
+
+	// Frame times binned at 0.1ms up to 100ms, the last bin holds everything longer
+	static const int histogram_bins = 1000;
+	std::array<unsigned int, histogram_bins> histogram = {};
+	unsigned int frames = 0;
+	double mean = 0;
+	double m2 = 0; // running sum of squared deviations, Welford's method
+	float min_ms = 0;
+	float max_ms = 0;
+	float last_ms = 0;
+};
@@ -0,0 +1,108 @@
+#include "gpu_profiler.hpp"
+
+void GpuProfiler::init()
+{
+	for (auto& set : queries)
+		glGenQueries(gpu_pass_count, set.data());
+	for (auto& set : issued)
+		set.fill(false);
+	set_frame.fill(0);
+	current_set = 0;
+	frame_number = 0;
+	for (std::atomic<float>& ms : pass_ms)
+		ms.store(0.f);
+	gl_has_errors();
+}
+
+void GpuProfiler::destroy()
+{
+	for (auto& set : queries)
+		glDeleteQueries(gpu_pass_count, set.data());
+	if (log != nullptr)
+		fclose(log);
+	log = nullptr;
+}
+
+bool GpuProfiler::openLog(const std::string& path)
+{
+	log = fopen(path.c_str(), "w");
+	if (log == nullptr)
+	{
+		fprintf(stderr, "Failed to open GPU profile log %s\n", path.c_str());
+		return false;
+	}
+	fprintf(log, "frame,sprites_ms,text_ms,screen_ms,total_ms\n");
+	return true;
+}
+
+void GpuProfiler::beginFrame(bool enabled)
+{
+	// This set was issued frames_in_flight - 1 frames ago
+	resolve(current_set);
+	active = enabled;
+}
+
+void GpuProfiler::beginPass(GPU_PASS pass)
+{
+	if (!active)
+		return;
+	assert(!in_pass);
+	glBeginQuery(GL_TIME_ELAPSED, queries[current_set][(int)pass]);
+	issued[current_set][(int)pass] = true;
+	in_pass = true;
+}
+
+void GpuProfiler::endPass()
+{
+	if (!active)
+		return;
+	assert(in_pass);
+	glEndQuery(GL_TIME_ELAPSED);
+	in_pass = false;
+}
+
+void GpuProfiler::endFrame()
+{
+	set_frame[current_set] = frame_number++;
+	current_set = (current_set + 1) % frames_in_flight;
+}
+
+void GpuProfiler::resolve(int set)
+{
+	bool any = false;
+	for (bool was_issued : issued[set])
+		any = any || was_issued;
+	if (!any)
+		return;
+
+	// Should long be done, if not drop the sample rather than wait for it
+	for (int pass = 0; pass < gpu_pass_count; pass++)
+	{
+		if (!issued[set][pass])
+			continue;
+		GLuint available = 0;
+		glGetQueryObjectuiv(queries[set][pass], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			issued[set].fill(false);
+			return;
+		}
+	}
+
+	std::array<float, gpu_pass_count> ms;
+	float total = 0.f;
+	for (int pass = 0; pass < gpu_pass_count; pass++)
+	{
+		GLuint64 ns = 0;
+		if (issued[set][pass])
+			glGetQueryObjectui64v(queries[set][pass], GL_QUERY_RESULT, &ns);
+		ms[pass] = (float)(ns / 1e6);
+		total += ms[pass];
+		pass_ms[pass].store(ms[pass], std::memory_order_relaxed);
+	}
+	issued[set].fill(false);
+	gl_has_errors();
+
+	if (log != nullptr)
+		fprintf(log, "%u,%.4f,%.4f,%.4f,%.4f\n", set_frame[set], ms[0], ms[1], ms[2], total);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#include "common.hpp"
+
+// Render passes timed by GpuProfiler, in the order they are submitted
+enum class GPU_PASS {
+	SPRITES = 0,
+	TEXT = SPRITES + 1,
+	SCREEN = TEXT + 1,
+	PASS_COUNT = SCREEN + 1
+};
+const int gpu_pass_count = (int)GPU_PASS::PASS_COUNT;
+
+// Measures the GPU time of each render pass with GL_TIME_ELAPSED queries.
+// There is one set of queries per frame in flight and a set is only read back
+// right before it is reused, by which point the GPU has long finished with it,
+// so the readback never stalls the pipeline. Results lag a few frames behind.
+class GpuProfiler
+{
+public:
+	static const int frames_in_flight = 3;
+
+	void init();
+	void destroy();
+
+	// Appends one line per measured frame to a CSV file
+	bool openLog(const std::string& path);
+	bool isLogging() const { return log != nullptr; }
+
+	// Resolves the oldest set of queries and starts a new frame, passes are
+	// only timed when enabled
+	void beginFrame(bool enabled);
+	void beginPass(GPU_PASS pass);
+	void endPass();
+	void endFrame();
+
+	// Latest resolved time of a pass, safe to read from any thread
+	float getPassMs(GPU_PASS pass) const { return pass_ms[(int)pass].load(std::memory_order_relaxed); }
+
+private:
+	void resolve(int set);
+
+	std::array<std::array<GLuint, gpu_pass_count>, frames_in_flight> queries;
+	// Passes skipped in a frame, such as the screen pass without post effects, are not issued
+	std::array<std::array<bool, gpu_pass_count>, frames_in_flight> issued;
+	std::array<unsigned int, frames_in_flight> set_frame;
+	int current_set = 0;
+	unsigned int frame_number = 0;
+	bool active = false;
+	bool in_pass = false;
+
+	std::array<std::atomic<float>, gpu_pass_count> pass_ms;
+	FILE* log = nullptr;
+};
@@ -0,0 +1,102 @@
+#include "headless_context.hpp"
+
+#ifdef NIGHTHOOD_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+bool HeadlessContext::create()
+{
+	if (createEGL())
+		return true;
+
+	// Fall back to a window that is never shown, this still needs a display
+	if (!glfwInit())
+	{
+		fprintf(stderr, "Failed to initialize GLFW for an offscreen context\n");
+		return false;
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	hidden_window = glfwCreateWindow(16, 16, "Nighthood offscreen", nullptr, nullptr);
+	if (hidden_window == nullptr)
+	{
+		fprintf(stderr, "Failed to create a hidden window for an offscreen context\n");
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(hidden_window);
+	return true;
+}
+
+bool HeadlessContext::createEGL()
+{
+#ifdef NIGHTHOOD_EGL
+	EGLDisplay display = EGL_NO_DISPLAY;
+	// Prefer Mesa's surfaceless platform, the default display may want X11
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (get_platform_display != nullptr)
+		display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+		return false;
+
+	const EGLint config_attribs[] = {
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE };
+	EGLConfig config;
+	EGLint config_count = 0;
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE };
+	EGLContext context = EGL_NO_CONTEXT;
+	if (eglBindAPI(EGL_OPENGL_API) &&
+		eglChooseConfig(display, config_attribs, &config, 1, &config_count) && config_count > 0)
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+
+	// The renderer draws into its own frame buffer, so no surface is needed
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		if (context != EGL_NO_CONTEXT)
+			eglDestroyContext(display, context);
+		eglTerminate(display);
+		return false;
+	}
+	printf("Offscreen context: EGL %d.%d\n", major, minor);
+	egl_display = display;
+	egl_context = context;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void HeadlessContext::destroy()
+{
+#ifdef NIGHTHOOD_EGL
+	if (egl_context != nullptr)
+	{
+		eglMakeCurrent((EGLDisplay)egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext((EGLDisplay)egl_display, (EGLContext)egl_context);
+		eglTerminate((EGLDisplay)egl_display);
+	}
+	egl_display = nullptr;
+	egl_context = nullptr;
+#endif
+	if (hidden_window != nullptr)
+	{
+		glfwDestroyWindow(hidden_window);
+		glfwTerminate();
+	}
+	hidden_window = nullptr;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common.hpp"
+
+// OpenGL 3.3 core context without a visible window, for running the renderer
+// on machines with no display such as CI runners with Mesa's llvmpipe.
+// Builds with EGL use a surfaceless EGL context, which needs neither a
+// display server nor a GPU. Otherwise, or if EGL fails, a hidden GLFW window
+// provides the context.
+class HeadlessContext
+{
+public:
+	// Creates the context and makes it current on the calling thread
+	bool create();
+	void destroy();
+
+private:
+	bool createEGL();
+
+	// EGLDisplay and EGLContext, kept opaque so EGL headers stay out of here
+	void* egl_display = nullptr;
+	void* egl_context = nullptr;
+	GLFWwindow* hidden_window = nullptr;
+};
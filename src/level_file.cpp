@@ -0,0 +1,378 @@
+// internal
+#include "level_file.hpp"
+#include "asset_pack.hpp"
+
+// stlib
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+struct LevelFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t source_hash;  // FNV-1a of the .level text this was cooked from
+	uint64_t checksum;     // FNV-1a of everything after the header
+	uint32_t motion_size;  // sizes of the structs the level was cooked with
+	uint32_t request_size;
+	LevelSettings settings;
+	uint32_t kind_count[level_static_kinds];
+	vec2 grid_origin;
+	float grid_cell_size;
+	ivec2 grid_dims;
+	uint32_t grid_items;
+	uint32_t spawn_count;
+	uint32_t line_bytes;   // sign lines, each one ended by '\n'
+};
+
+// Keywords of static entities in a .level file, followed by x y w h, or by
+// x y alone for the ones with a fixed size. Kinds before DOOR get color.
+struct StaticSyntax
+{
+	const char* keyword;
+	LEVEL_STATIC kind;
+	TEXTURE_ASSET_ID texture;
+	vec2 fixed_scale;
+	vec3 color;
+};
+static const StaticSyntax static_syntax[] = {
+	{ "tile", LEVEL_STATIC::TILE, TEXTURE_ASSET_ID::TILE, { 0.f, 0.f }, { 0.3f, 0.3f, 0.3f } },
+	{ "vtile", LEVEL_STATIC::TILE, TEXTURE_ASSET_ID::TILE_VERT, { 0.f, 0.f }, { 0.3f, 0.3f, 0.3f } },
+	{ "vlongtile", LEVEL_STATIC::TILE, TEXTURE_ASSET_ID::TILE_VERT_LONG, { 0.f, 0.f }, { 0.3f, 0.3f, 0.3f } },
+	{ "next_level", LEVEL_STATIC::NEXT_LEVEL, TEXTURE_ASSET_ID::TILE, { 0.f, 0.f }, { 0.3f, 0.3f, 0.3f } },
+	{ "deathbox", LEVEL_STATIC::DEATHBOX, TEXTURE_ASSET_ID::TILE, { 0.f, 0.f }, { 0.f, 0.f, 0.f } },
+	{ "door", LEVEL_STATIC::DOOR, TEXTURE_ASSET_ID::DOOR, { 0.f, 0.f }, { 0.f, 0.f, 0.f } },
+	{ "pedestal", LEVEL_STATIC::PROP, TEXTURE_ASSET_ID::PEDESTAL, { 40.f, 50.f }, { 0.f, 0.f, 0.f } }
+};
+
+// Keywords of spawns, followed by x y and then params values
+struct SpawnSyntax
+{
+	const char* keyword;
+	LEVEL_SPAWN type;
+	int params;
+};
+static const SpawnSyntax spawn_syntax[] = {
+	{ "potion", LEVEL_SPAWN::POTION, 0 },
+	{ "bat", LEVEL_SPAWN::BAT, 1 },           // fly range
+	{ "skeleton", LEVEL_SPAWN::SKELETON, 2 }, // attack range, roam range
+	{ "wolf", LEVEL_SPAWN::WOLF, 2 },         // roam range, jump cooldown
+	{ "ranged", LEVEL_SPAWN::RANGED, 3 },     // attack range, roam range, stationary
+	{ "wizard", LEVEL_SPAWN::WIZARD, 3 },     // attack range, roam range, stationary
+	{ "saw", LEVEL_SPAWN::SAW, 0 },
+	{ "demon", LEVEL_SPAWN::DEMON, 2 },       // left bound, right bound
+	{ "golem", LEVEL_SPAWN::GOLEM, 0 },
+	{ "sign", LEVEL_SPAWN::SIGN, 0 }          // text from the line entries after it
+};
+
+struct ParsedStatic
+{
+	LEVEL_STATIC kind;
+	Motion motion;
+	RenderRequest request;
+	vec3 color;
+};
+
+// Numbers up to the end of the line or a comment, false on anything else
+static bool read_numbers(std::istringstream& words, std::vector<float>& values)
+{
+	values.clear();
+	std::string word;
+	while (words >> word)
+	{
+		if (word[0] == '#')
+			break;
+		char* end = nullptr;
+		values.push_back(strtof(word.c_str(), &end));
+		if (*end != '\0')
+			return false;
+	}
+	return true;
+}
+
+bool cook_level(const std::string& text, const std::string& name, LevelData& out)
+{
+	out = LevelData();
+	std::vector<ParsedStatic> statics;
+	bool has_player = false;
+
+	std::istringstream input(text);
+	std::string line;
+	int line_number = 0;
+	auto fail = [&](const char* message) {
+		fprintf(stderr, "%s.level:%d: %s\n", name.c_str(), line_number, message);
+		return false;
+	};
+	while (std::getline(input, line))
+	{
+		line_number++;
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		std::istringstream words(line);
+		std::string keyword;
+		if (!(words >> keyword) || keyword[0] == '#')
+			continue;
+
+		// Sign text is taken as written, # included
+		if (keyword == "line")
+		{
+			if (out.spawns.empty() || out.spawns.back().type != LEVEL_SPAWN::SIGN)
+				return fail("line without a sign before it");
+			std::string sign_line;
+			std::getline(words >> std::ws, sign_line);
+			out.lines.push_back(sign_line);
+			out.spawns.back().line_count++;
+			continue;
+		}
+
+		std::vector<float> values;
+		if (!read_numbers(words, values))
+			return fail("expected numbers");
+
+		if (keyword == "background" || keyword == "ghosts" || keyword == "parallax" || keyword == "player")
+		{
+			LevelSettings& settings = out.settings;
+			if (keyword == "background" && values.size() == 1)
+				settings.background = (int32_t)values[0];
+			else if (keyword == "ghosts" && values.size() == 2)
+			{
+				settings.ghost_spawn_limit = (int32_t)values[0];
+				settings.ghost_spawn_cd = values[1];
+			}
+			else if (keyword == "parallax" && values.empty())
+				settings.parallax = 1;
+			else if (keyword == "player" && (values.size() == 2 || values.size() == 3))
+			{
+				settings.player = { values[0], values[1] };
+				settings.player_health = values.size() == 3 ? (int32_t)values[2] : 0;
+				has_player = true;
+			}
+			else
+				return fail("wrong number of values");
+			continue;
+		}
+
+		auto is_keyword = [&](const auto& syntax) { return keyword == syntax.keyword; };
+		const StaticSyntax* static_entry = std::find_if(std::begin(static_syntax), std::end(static_syntax), is_keyword);
+		if (static_entry != std::end(static_syntax))
+		{
+			const bool fixed = static_entry->fixed_scale.x != 0.f;
+			if (values.size() != (fixed ? 2u : 4u))
+				return fail(fixed ? "expected x y" : "expected x y width height");
+			ParsedStatic entry;
+			entry.kind = static_entry->kind;
+			entry.motion.interactable = static_entry->kind < LEVEL_STATIC::DOOR;
+			entry.motion.position = { values[0], values[1] };
+			entry.motion.angle = 0.f;
+			entry.motion.velocity = { 0.f, 0.f };
+			entry.motion.scale = fixed ? static_entry->fixed_scale : vec2(values[2], values[3]);
+			entry.request = { static_entry->texture, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE, RENDER_LAYER::STATIC };
+			entry.color = static_entry->color;
+			statics.push_back(entry);
+			continue;
+		}
+
+		const SpawnSyntax* spawn_entry = std::find_if(std::begin(spawn_syntax), std::end(spawn_syntax), is_keyword);
+		if (spawn_entry != std::end(spawn_syntax))
+		{
+			if (values.size() != (size_t)(2 + spawn_entry->params))
+				return fail("wrong number of values");
+			LevelSpawn spawn = { spawn_entry->type, { values[0], values[1] }, { 0.f, 0.f, 0.f }, 0 };
+			for (int i = 0; i < spawn_entry->params; i++)
+				spawn.params[i] = values[2 + i];
+			out.spawns.push_back(spawn);
+			continue;
+		}
+
+		return fail("unknown keyword");
+	}
+	if (!has_player)
+		return fail("no player position");
+
+	// Kinds become runs of entities, within a kind the tiles sharing a
+	// texture end up next to each other and are drawn as one batch
+	auto draw_order = [](const ParsedStatic& a, const ParsedStatic& b) {
+		if (a.kind != b.kind)
+			return a.kind < b.kind;
+		if (a.request.layer != b.request.layer)
+			return a.request.layer < b.request.layer;
+		if (a.request.used_effect != b.request.used_effect)
+			return a.request.used_effect < b.request.used_effect;
+		if (a.request.used_texture != b.request.used_texture)
+			return a.request.used_texture < b.request.used_texture;
+		return a.request.used_geometry < b.request.used_geometry;
+	};
+	std::stable_sort(statics.begin(), statics.end(), draw_order);
+
+	for (const ParsedStatic& entry : statics)
+	{
+		out.motions.push_back(entry.motion);
+		out.requests.push_back(entry.request);
+		if (entry.kind < LEVEL_STATIC::DOOR)
+			out.colors.push_back(entry.color);
+		out.kind_count[(int)entry.kind]++;
+	}
+	for (uint32_t i = 0; i < out.kind_count[(int)LEVEL_STATIC::TILE]; i++)
+	{
+		vec2 bounds_min, bounds_max;
+		static_tile_bounds(out.motions[i].position, out.motions[i].scale, bounds_min, bounds_max);
+		out.tile_mins.push_back(bounds_min);
+		out.tile_maxs.push_back(bounds_max);
+	}
+	out.grid.build(out.tile_mins, out.tile_maxs, STATIC_CELL_SIZE);
+	return true;
+}
+
+template <class T>
+static void append(std::vector<unsigned char>& out, const std::vector<T>& values)
+{
+	const unsigned char* bytes = (const unsigned char*)values.data();
+	out.insert(out.end(), bytes, bytes + sizeof(T) * values.size());
+}
+
+std::vector<unsigned char> write_cooked_level(const LevelData& level, uint64_t source_hash)
+{
+	// Every field is 4 or 8 bytes on its own alignment, no padding is left unset
+	LevelFileHeader header = {};
+	header.magic = level_magic;
+	header.version = level_version;
+	header.source_hash = source_hash;
+	header.motion_size = sizeof(Motion);
+	header.request_size = sizeof(RenderRequest);
+	header.settings = level.settings;
+	memcpy(header.kind_count, level.kind_count, sizeof(header.kind_count));
+	header.grid_origin = level.grid.origin;
+	header.grid_cell_size = level.grid.cell_size;
+	header.grid_dims = level.grid.dims;
+	header.grid_items = (uint32_t)level.grid.items.size();
+	header.spawn_count = (uint32_t)level.spawns.size();
+
+	std::string text;
+	for (const std::string& line : level.lines)
+		text += line + '\n';
+	header.line_bytes = (uint32_t)text.size();
+
+	std::vector<unsigned char> bytes(sizeof(header));
+	append(bytes, level.motions);
+	append(bytes, level.requests);
+	append(bytes, level.colors);
+	append(bytes, level.tile_mins);
+	append(bytes, level.tile_maxs);
+	append(bytes, level.grid.cell_start);
+	append(bytes, level.grid.items);
+	append(bytes, level.spawns);
+	bytes.insert(bytes.end(), text.begin(), text.end());
+
+	header.checksum = fnv1a(bytes.data() + sizeof(header), bytes.size() - sizeof(header));
+	memcpy(bytes.data(), &header, sizeof(header));
+	return bytes;
+}
+
+// Copies count values out of the cooked data, false if that runs past the end
+template <class T>
+static bool take(const unsigned char*& cursor, const unsigned char* end, size_t count, std::vector<T>& out)
+{
+	if ((size_t)(end - cursor) / sizeof(T) < count)
+		return false;
+	out.resize(count);
+	if (count > 0)
+		memcpy((void*)out.data(), cursor, sizeof(T) * count);
+	cursor += sizeof(T) * count;
+	return true;
+}
+
+bool read_cooked_level(const unsigned char* data, size_t size, uint64_t source_hash, LevelData& out)
+{
+	LevelFileHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != level_magic || header.version != level_version ||
+		header.motion_size != sizeof(Motion) || header.request_size != sizeof(RenderRequest) ||
+		(source_hash != 0 && header.source_hash != source_hash) ||
+		header.checksum != fnv1a(data + sizeof(header), size - sizeof(header)))
+		return false;
+
+	out = LevelData();
+	out.settings = header.settings;
+	uint32_t static_count = 0;
+	uint32_t colored_count = 0;
+	for (int kind = 0; kind < level_static_kinds; kind++)
+	{
+		out.kind_count[kind] = header.kind_count[kind];
+		static_count += header.kind_count[kind];
+		if (kind < (int)LEVEL_STATIC::DOOR)
+			colored_count += header.kind_count[kind];
+	}
+	const uint32_t tile_count = header.kind_count[(int)LEVEL_STATIC::TILE];
+	if (header.grid_dims.x < 0 || header.grid_dims.y < 0)
+		return false;
+	const size_t cells = (size_t)header.grid_dims.x * header.grid_dims.y;
+	out.grid.origin = header.grid_origin;
+	out.grid.cell_size = header.grid_cell_size;
+	out.grid.dims = header.grid_dims;
+
+	const unsigned char* cursor = data + sizeof(header);
+	const unsigned char* end = data + size;
+	std::vector<char> text;
+	if (!take(cursor, end, static_count, out.motions) ||
+		!take(cursor, end, static_count, out.requests) ||
+		!take(cursor, end, colored_count, out.colors) ||
+		!take(cursor, end, tile_count, out.tile_mins) ||
+		!take(cursor, end, tile_count, out.tile_maxs) ||
+		!take(cursor, end, cells > 0 ? cells + 1 : 0, out.grid.cell_start) ||
+		!take(cursor, end, header.grid_items, out.grid.items) ||
+		!take(cursor, end, header.spawn_count, out.spawns) ||
+		!take(cursor, end, header.line_bytes, text) ||
+		cursor != end)
+		return false;
+
+	// The grid is indexed without checks at runtime
+	if (cells > 0 && out.grid.cell_start.back() != header.grid_items)
+		return false;
+	for (size_t c = 1; c < out.grid.cell_start.size(); c++)
+		if (out.grid.cell_start[c] < out.grid.cell_start[c - 1])
+			return false;
+	for (uint32_t item : out.grid.items)
+		if (item >= tile_count)
+			return false;
+
+	size_t line_count = 0;
+	for (const LevelSpawn& spawn : out.spawns)
+	{
+		if (spawn.type >= LEVEL_SPAWN::SPAWN_COUNT)
+			return false;
+		line_count += spawn.line_count;
+	}
+	std::istringstream lines(std::string(text.begin(), text.end()));
+	std::string line;
+	while (std::getline(lines, line))
+		out.lines.push_back(line);
+	return out.lines.size() == line_count;
+}
+
+bool read_level(const std::string& name, LevelData& out)
+{
+	std::string text;
+	std::ifstream file(level_path(name + ".level"), std::ios::binary);
+	const bool has_text = file.good();
+	if (has_text)
+		text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	const uint64_t source_hash = has_text ? fnv1a(text.data(), text.size()) : 0;
+
+	MappedFile cooked;
+	if (cooked.open(level_path(name + ".lvl")) && read_cooked_level(cooked.data(), cooked.size(), source_hash, out))
+		return true;
+	if (!has_text)
+	{
+		fprintf(stderr, "Level %s not found in %s\n", name.c_str(), level_path("").c_str());
+		return false;
+	}
+	printf("%s.lvl is missing or older than %s.level, cooking it in memory (build cook_levels to skip this)\n",
+		name.c_str(), name.c_str());
+	return cook_level(text, name, out);
+}
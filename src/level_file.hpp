@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "components.hpp"
+#include "static_grid.hpp"
+
+// Levels are authored as text in data/levels/<name>.level, see the files
+// there for the syntax, and cooked by tools/level_cook.cpp into <name>.lvl.
+// Cooking sorts the static entities into blocks by kind and draw order and
+// bins the tiles into a StaticGrid, so a cooked level is read with one copy
+// per array and handed to the registry and the static tile index as is.
+//
+// Layout: LevelFileHeader, then motions, render requests, colors, tile
+// bounds min and max, grid cell starts and items, spawns and the sign text.
+// Structs are written as they are in memory, like the asset pack.
+const uint32_t level_magic = 0x564C484E; // "NHLV"
+// Bump whenever the layout or one of the stored structs changes
+const uint32_t level_version = 1;
+
+// Entities that never move or change. A level keeps them in this order so
+// every kind is one run of entities, the kinds before DOOR have a color.
+enum class LEVEL_STATIC : uint32_t {
+	TILE = 0,
+	NEXT_LEVEL = TILE + 1,
+	DEATHBOX = NEXT_LEVEL + 1,
+	DOOR = DEATHBOX + 1,
+	PROP = DOOR + 1,
+	KIND_COUNT = PROP + 1
+};
+const int level_static_kinds = (int)LEVEL_STATIC::KIND_COUNT;
+
+// Everything else is made by its create function in world_init.cpp
+enum class LEVEL_SPAWN : uint32_t {
+	POTION = 0,
+	BAT = POTION + 1,
+	SKELETON = BAT + 1,
+	WOLF = SKELETON + 1,
+	RANGED = WOLF + 1,
+	WIZARD = RANGED + 1,
+	SAW = WIZARD + 1,
+	DEMON = SAW + 1,
+	GOLEM = DEMON + 1,
+	SIGN = GOLEM + 1,
+	SPAWN_COUNT = SIGN + 1
+};
+
+struct LevelSpawn
+{
+	LEVEL_SPAWN type;
+	vec2 position;
+	float params[3];     // as passed to the create function, in order
+	uint32_t line_count; // SIGN, takes the next line_count lines of LevelData::lines
+};
+
+struct LevelSettings
+{
+	int32_t background = 1;
+	int32_t ghost_spawn_limit = 0;
+	float ghost_spawn_cd = 4000.f;
+	int32_t parallax = 0;
+	vec2 player = { 0.f, 0.f };
+	int32_t player_health = 0; // 0 keeps the health carried over from the last level
+};
+
+struct LevelData
+{
+	LevelSettings settings;
+	// Static block, kinds in LEVEL_STATIC order and each sorted by draw order
+	std::vector<Motion> motions;
+	std::vector<RenderRequest> requests;
+	std::vector<vec3> colors;
+	uint32_t kind_count[level_static_kinds] = { 0 };
+	// Bounds and grid of the tiles, the first kind_count[TILE] statics
+	std::vector<vec2> tile_mins;
+	std::vector<vec2> tile_maxs;
+	StaticGrid grid;
+	std::vector<LevelSpawn> spawns;
+	std::vector<std::string> lines;
+};
+
+// Parses a .level file and cooks it, name is only used in error messages
+bool cook_level(const std::string& text, const std::string& name, LevelData& out);
+// source_hash is the FNV-1a of the .level text, a later read compares it
+std::vector<unsigned char> write_cooked_level(const LevelData& level, uint64_t source_hash);
+// False if data is damaged, of another version, or was cooked from other text.
+// A source_hash of 0 skips that last check.
+bool read_cooked_level(const unsigned char* data, size_t size, uint64_t source_hash, LevelData& out);
+
+// The cooked data/levels/<name>.lvl if it is up to date, else the .level is
+// cooked in memory. False if neither exists or both are broken.
+bool read_level(const std::string& name, LevelData& out);
@@ -4,21 +4,88 @@
 
 // stlib
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 
 // internal
+#include "asset_pack.hpp"
+#include "frame_pacer.hpp"
 #include "physics_system.hpp"
+#include "render_bench.hpp"
 #include "render_system.hpp"
+#include "startup_report.hpp"
+#include "thread_pool.hpp"
 #include "world_system.hpp"
 
-using Clock = std::chrono::high_resolution_clock;
+using Clock = FramePacer::Clock;
 
 // Entry point
-int main()
+int main(int argc, char* argv[])
 {
+	startup_report.begin();
+	thread_pool.start();
+	// Assets come from the cooked pack when there is one, see tools/asset_cook.cpp
+	if (asset_pack.open(asset_pack_path()))
+		printf("Loading cooked assets from %s\n", asset_pack_path().c_str());
+
+	// --no-render-thread draws every frame on the main thread instead
+	bool render_thread = true;
+	// Frames are capped by vsync unless --fps <hz> or --uncapped is given
+	PACING_MODE pacing = PACING_MODE::VSYNC;
+	float target_fps = 60.f;
+	// --gpu-log <file> writes per pass GPU times as CSV
+	const char* gpu_log = nullptr;
+	// --bench-render <frames> [--bench-png <file>] renders a fixed scene offscreen and exits
+	int bench_frames = 0;
+	const char* bench_png = nullptr;
+	// --texture-budget <MB> sets how much texture memory is kept before evicting
+	size_t texture_budget = TextureResidency::default_budget_bytes;
+	// --startup-report prints where the time to the first frame went
+	bool print_startup_report = false;
+	// --binary-save also writes game_save.bin, which is loaded instead of game_save.json
+	bool binary_save = false;
+	// --transition-budget <ms> sets the longest frame a level transition may take
+	// before it is reported, by default one dropped frame at 60Hz
+	float transition_budget_ms = 1000.f / 30.f;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--no-render-thread") == 0)
+			render_thread = false;
+		else if (strcmp(argv[i], "--vsync") == 0)
+			pacing = PACING_MODE::VSYNC;
+		else if (strcmp(argv[i], "--uncapped") == 0)
+			pacing = PACING_MODE::UNCAPPED;
+		else if (strcmp(argv[i], "--bench-render") == 0 && i + 1 < argc)
+			bench_frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--bench-png") == 0 && i + 1 < argc)
+			bench_png = argv[++i];
+		else if (strcmp(argv[i], "--gpu-log") == 0 && i + 1 < argc)
+			gpu_log = argv[++i];
+		else if (strcmp(argv[i], "--startup-report") == 0)
+			print_startup_report = true;
+		else if (strcmp(argv[i], "--binary-save") == 0)
+			binary_save = true;
+		else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+			texture_budget = (size_t)atoi(argv[++i]) * 1024 * 1024;
+		else if (strcmp(argv[i], "--transition-budget") == 0 && i + 1 < argc)
+			transition_budget_ms = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+			pacing = PACING_MODE::FIXED;
+			target_fps = (float)atof(argv[++i]);
+		}
+	}
+
+	if (bench_frames > 0) {
+		const int result = run_render_bench(bench_frames, bench_png);
+		thread_pool.stop();
+		return result;
+	}
+
 	// Global systems
 	WorldSystem world;
 	RenderSystem renderer;
 	PhysicsSystem physics;
+	world.set_binary_saves(binary_save);
+	world.set_transition_budget(transition_budget_ms);
 
 	// Initializing window
 	GLFWwindow* window = world.create_window();
@@ -26,12 +93,27 @@ int main()
 		// Time to read the error message
 		printf("Press any key to exit");
 		getchar();
+		thread_pool.stop();
 		return EXIT_FAILURE;
 	}
 
 	// initialize the main systems
 	renderer.init(window);
-	world.init(&renderer);
+	renderer.setTextureBudget(texture_budget);
+	if (gpu_log)
+		renderer.openGpuLog(gpu_log);
+	if (!world.init(&renderer)) {
+		// Exits right away, scripted and benchmark runs keep stdin open
+		fprintf(stderr, "Failed to load the game's sounds\n");
+		thread_pool.stop();
+		return EXIT_FAILURE;
+	}
+	renderer.setVSync(pacing == PACING_MODE::VSYNC);
+	FramePacer pacer;
+	pacer.init(pacing, target_fps);
+	// From here on GL calls are only made by the renderer
+	if (render_thread)
+		renderer.startRenderThread();
 
 	// World steps
 	const float step_value = 1000.f / 60.f;
@@ -46,6 +128,8 @@ int main()
 	while (!world.is_over()) {
 		// Processes system messages, if this wasn't present the window would become unresponsive
 		glfwPollEvents();
+		if (world.is_over())
+			break;
 
 		// Calculating elapsed times in milliseconds from the previous iteration
 		auto now = Clock::now();
@@ -72,7 +156,26 @@ int main()
 		}
 
 		renderer.draw();
+
+		// Startup is over once the intro is fully on screen
+		if (startup_report.isOpen() && !renderer.texturesLoading()) {
+			startup_report.finish();
+			if (print_startup_report)
+				startup_report.print();
+		}
+
+		// Sleep off the rest of the frame instead of rendering duplicates
+		pacer.wait();
+		world.record_frame(pacer.lastFrameMs());
 	}
+	pacer.printStats();
+
+	// Finish the frames in flight and bring the context back for cleanup
+	renderer.stopRenderThread();
+
+	// Pending saves and decodes finish while the systems and globals they
+	// touch are still alive, not during static destruction
+	thread_pool.stop();
 
 	return EXIT_SUCCESS;
 }
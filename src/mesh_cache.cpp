@@ -0,0 +1,150 @@
+#include "mesh_cache.hpp"
+#include "asset_pack.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const uint32_t mesh_cache_magic = 0x434D484E; // "NHMC"
+// Bump whenever MeshCacheHeader or the vertex layout changes
+static const uint32_t mesh_cache_version = 3;
+
+struct MeshCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t obj_mtime; // nanoseconds, see obj_file_time
+	uint64_t obj_size;
+	uint64_t obj_hash;
+	uint32_t vertex_count;
+	uint32_t index_count;
+	uint32_t sample_count;
+	vec2 original_size;
+};
+
+static std::string mesh_cache_path(const std::string& obj_path)
+{
+	return cache_path(obj_path.substr(obj_path.find_last_of("/\\") + 1) + ".mesh");
+}
+
+static uint64_t obj_hash(const std::string& obj_path)
+{
+	MappedFile file;
+	if (!file.open(obj_path))
+		return 0;
+	return fnv1a(file.data(), file.size());
+}
+
+static void write_mesh_cache(const std::string& path, const MeshCacheHeader& header, const Mesh& mesh)
+{
+	if (!make_cache_dir())
+		return;
+	// Written aside and renamed, another launch never reads half a cache
+	const std::string temp_path = path + ".tmp";
+	FILE* file = fopen(temp_path.c_str(), "wb");
+	if (file == nullptr)
+		return;
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(mesh.vertices.data(), sizeof(ColoredVertex), mesh.vertices.size(), file) == mesh.vertices.size() &&
+		fwrite(mesh.vertex_indices.data(), sizeof(uint16_t), mesh.vertex_indices.size(), file) == mesh.vertex_indices.size() &&
+		fwrite(mesh.samples.data(), sizeof(vec2), mesh.samples.size(), file) == mesh.samples.size();
+	written = fclose(file) == 0 && written;
+	std::remove(path.c_str());
+	if (!written || std::rename(temp_path.c_str(), path.c_str()) != 0)
+		std::remove(temp_path.c_str());
+}
+
+// Modification time as finely as the file system records it, whole seconds
+// would trust a cache across an edit that keeps the size within the second
+static bool obj_file_time(const std::string& obj_path, uint64_t& mtime, uint64_t& size)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(obj_path.c_str(), GetFileExInfoStandard, &attributes))
+		return false;
+	// 100ns ticks
+	mtime = (((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime) * 100;
+	size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+#else
+	struct stat obj_stat;
+	if (stat(obj_path.c_str(), &obj_stat) != 0)
+		return false;
+#ifdef __APPLE__
+	mtime = (uint64_t)obj_stat.st_mtimespec.tv_sec * 1000000000 + (uint64_t)obj_stat.st_mtimespec.tv_nsec;
+#else
+	mtime = (uint64_t)obj_stat.st_mtim.tv_sec * 1000000000 + (uint64_t)obj_stat.st_mtim.tv_nsec;
+#endif
+	size = (uint64_t)obj_stat.st_size;
+#endif
+	return true;
+}
+
+bool load_mesh_cached(const std::string& obj_path, Mesh& out)
+{
+	uint64_t obj_mtime, obj_size;
+	if (!obj_file_time(obj_path, obj_mtime, obj_size))
+		return false;
+
+	// The whole cache file in a single read
+	const std::string path = mesh_cache_path(obj_path);
+	std::vector<unsigned char> bytes;
+	if (FILE* file = fopen(path.c_str(), "rb"))
+	{
+		fseek(file, 0, SEEK_END);
+		const long length = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		if (length > 0)
+		{
+			bytes.resize((size_t)length);
+			if (fread(bytes.data(), 1, bytes.size(), file) != bytes.size())
+				bytes.clear();
+		}
+		fclose(file);
+	}
+
+	MeshCacheHeader header;
+	if (bytes.size() >= sizeof(header))
+	{
+		memcpy(&header, bytes.data(), sizeof(header));
+		const size_t expected = sizeof(header) + sizeof(ColoredVertex) * header.vertex_count +
+			sizeof(uint16_t) * header.index_count + sizeof(vec2) * header.sample_count;
+		bool valid = header.magic == mesh_cache_magic && header.version == mesh_cache_version &&
+			header.obj_size == obj_size && bytes.size() == expected;
+		const bool touched = valid && header.obj_mtime != obj_mtime;
+		if (touched)
+		{
+			valid = header.obj_hash == obj_hash(obj_path);
+			header.obj_mtime = obj_mtime;
+		}
+		if (valid)
+		{
+			const ColoredVertex* vertices = (const ColoredVertex*)(bytes.data() + sizeof(header));
+			const uint16_t* indices = (const uint16_t*)(vertices + header.vertex_count);
+			out.original_size = header.original_size;
+			out.vertices.assign(vertices, vertices + header.vertex_count);
+			out.vertex_indices.assign(indices, indices + header.index_count);
+			out.samples.resize(header.sample_count);
+			memcpy(out.samples.data(), indices + header.index_count, sizeof(vec2) * header.sample_count);
+			if (touched)
+				write_mesh_cache(path, header, out);
+			return true;
+		}
+	}
+
+	out.vertices.clear();
+	out.vertex_indices.clear();
+	out.samples.clear();
+	if (!Mesh::loadFromOBJFile(obj_path, out.vertices, out.vertex_indices, out.original_size, out.samples))
+		return false;
+	header = { mesh_cache_magic, mesh_cache_version, obj_mtime, obj_size, obj_hash(obj_path),
+		(uint32_t)out.vertices.size(), (uint32_t)out.vertex_indices.size(), (uint32_t)out.samples.size(), out.original_size };
+	write_mesh_cache(path, header, out);
+	return true;
+}
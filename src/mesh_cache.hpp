@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+#include "components.hpp"
+
+// Meshes parsed from OBJ are kept under data/cache/ in the layout Mesh uses in
+// memory. A cache file records the OBJ's modification time, to the
+// nanosecond where the file system keeps it, size and FNV-1a hash: a matching
+// time and size is trusted without touching the OBJ, a matching hash alone
+// (e.g. after a checkout touched the file) refreshes the recorded time.
+// Anything else reparses the OBJ and rewrites the cache.
+bool load_mesh_cached(const std::string& obj_path, Mesh& out);
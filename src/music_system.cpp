@@ -0,0 +1,125 @@
+#include "music_system.hpp"
+#include "thread_pool.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+struct MusicTrackInfo
+{
+	const char* name;
+	int volume;
+};
+
+// tools/asset_cook.cpp leaves these names out of the pack
+static const MusicTrackInfo music_tracks[(int)MUSIC_TRACK::MUSIC_COUNT] = {
+	{ nullptr, 0 },
+	{ "intro", MIX_MAX_VOLUME / 2 },
+	{ "background_music", MIX_MAX_VOLUME / 15 },
+	{ "boss_music", MIX_MAX_VOLUME / 10 }
+};
+
+static Mix_Music* open_music(const std::string& name)
+{
+	// Compressed if there is a compressed copy, Mix_Music decodes as it plays
+	for (const char* extension : { ".ogg", ".wav" })
+	{
+		const std::string path = audio_path(name + extension);
+		if (FILE* file = fopen(path.c_str(), "rb"))
+		{
+			fclose(file);
+			Mix_Music* music = Mix_LoadMUS(path.c_str());
+			if (music == nullptr)
+				fprintf(stderr, "Failed to open music %s: %s\n", path.c_str(), Mix_GetError());
+			return music;
+		}
+	}
+	fprintf(stderr, "Failed to find music %s, make sure the data directory is present\n", audio_path(name).c_str());
+	return nullptr;
+}
+
+void MusicSystem::play(MUSIC_TRACK track)
+{
+	wanted = track;
+}
+
+void MusicSystem::startLoading(MUSIC_TRACK track)
+{
+	const std::string name = music_tracks[(int)track].name;
+	loading_track = track;
+	loading = thread_pool.submit([name] { return open_music(name); });
+}
+
+void MusicSystem::update()
+{
+	// Pick up a finished load, dropping it if another track was asked for meanwhile
+	if (loading.valid() && loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		Mix_Music* music = loading.get();
+		if (music != nullptr && loading_track == wanted)
+		{
+			if (next != nullptr)
+				Mix_FreeMusic(next);
+			next = music;
+			next_track = loading_track;
+		}
+		else if (music != nullptr)
+			Mix_FreeMusic(music);
+		else if (loading_track == wanted)
+			wanted = MUSIC_TRACK::NONE; // missing, play silence rather than retry every step
+		loading_track = MUSIC_TRACK::NONE;
+	}
+
+	if (next != nullptr && next_track != wanted)
+	{
+		Mix_FreeMusic(next);
+		next = nullptr;
+		next_track = MUSIC_TRACK::NONE;
+	}
+	if (wanted != MUSIC_TRACK::NONE && wanted != playing && wanted != next_track && !loading.valid())
+		startLoading(wanted);
+
+	// Fade out anything that is not wanted, it is freed once silent since
+	// freeing playing music waits for the fade
+	if (current != nullptr && playing != wanted)
+	{
+		if (Mix_PlayingMusic() && Mix_FadingMusic() != MIX_FADING_OUT)
+			Mix_FadeOutMusic(fade_ms);
+		if (!Mix_PlayingMusic())
+		{
+			Mix_FreeMusic(current);
+			current = nullptr;
+			playing = MUSIC_TRACK::NONE;
+		}
+	}
+	else if (current != nullptr && !Mix_PlayingMusic())
+	{
+		// Asked for again after its fade out had already started
+		Mix_FadeInMusic(current, -1, fade_ms);
+	}
+
+	if (current == nullptr && next != nullptr && next_track == wanted)
+	{
+		current = next;
+		playing = next_track;
+		next = nullptr;
+		next_track = MUSIC_TRACK::NONE;
+		Mix_VolumeMusic(music_tracks[(int)playing].volume);
+		Mix_FadeInMusic(current, -1, fade_ms);
+	}
+}
+
+void MusicSystem::destroy()
+{
+	Mix_HaltMusic();
+	if (loading.valid())
+	{
+		Mix_Music* music = loading.get();
+		if (music != nullptr)
+			Mix_FreeMusic(music);
+	}
+	for (Mix_Music* music : { current, next })
+		if (music != nullptr)
+			Mix_FreeMusic(music);
+	current = next = nullptr;
+	playing = next_track = loading_track = wanted = MUSIC_TRACK::NONE;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <future>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include "common.hpp"
+
+enum class MUSIC_TRACK {
+	NONE = 0,
+	INTRO = NONE + 1,
+	BACKGROUND = INTRO + 1,
+	BOSS = BACKGROUND + 1,
+	MUSIC_COUNT = BOSS + 1
+};
+
+// Streams the background music from disk with Mix_Music instead of keeping
+// every track decoded in memory. Only the playing track is open, the next one
+// is opened on the thread pool and faded in once the old one has faded out,
+// so switching tracks never blocks the main thread. Tracks are looked up as
+// .ogg first and .wav second in data/audio/.
+class MusicSystem
+{
+public:
+	// Length of the fade out of the old track and the fade in of the new one
+	static const int fade_ms = 800;
+
+	// Main thread, switches to track, or fades to silence for NONE
+	void play(MUSIC_TRACK track);
+	// Main thread, once per step, advances fades and picks up loaded tracks
+	void update();
+	// Halts the music and waits for a track being opened, call before Mix_CloseAudio
+	void destroy();
+
+private:
+	void startLoading(MUSIC_TRACK track);
+
+	MUSIC_TRACK wanted = MUSIC_TRACK::NONE;
+	// Open and playing or fading out
+	MUSIC_TRACK playing = MUSIC_TRACK::NONE;
+	Mix_Music* current = nullptr;
+	// Opened and waiting for the current track to finish fading out
+	MUSIC_TRACK next_track = MUSIC_TRACK::NONE;
+	Mix_Music* next = nullptr;
+	// Being opened on the thread pool
+	MUSIC_TRACK loading_track = MUSIC_TRACK::NONE;
+	std::future<Mix_Music*> loading;
+};
@@ -1,5 +1,6 @@
 // internal
 #include "physics_system.hpp"
+#include "static_tiles.hpp"
 #include "world_init.hpp"
 // Returns the local bounding coordinates scaled by the current size of the entity
 vec2 get_bounding_box(const Motion& motion)
@@ -55,11 +56,11 @@ bool collidesMeshBox(const Motion& mesh, const Motion& box, Entity meshE)
 			return true;
 		return false;
 	};
-	for (uint i = 0; i < registry.meshPtrs.get(meshE)->vertices.size(); i += 25)
+	for (const vec2& sample : registry.meshPtrs.get(meshE)->samples)
 	{
 		vec2 curr = {
-			posX + registry.meshPtrs.get(meshE)->vertices[i].position.x * sizeOffset_x,
-			posY - registry.meshPtrs.get(meshE)->vertices[i].position.y * sizeOffset_y 
+			posX + sample.x * sizeOffset_x,
+			posY - sample.y * sizeOffset_y 
 		};
 		if (isPointInBox(box, curr.x, curr.y))
 			return true;
@@ -67,6 +68,26 @@ bool collidesMeshBox(const Motion& mesh, const Motion& box, Entity meshE)
 	return false;
 }
 
+// Records the collision both ways if the boxes overlap. The player's first
+// attack only hits what its mesh reaches into.
+static void test_collision(Entity entity_i, const Motion& motion_i, Entity entity_j, const Motion& motion_j)
+{
+	if (!collides(motion_i, motion_j))
+		return;
+	bool touching = true;
+	if (registry.player_attack1.has(entity_i))
+		touching = collidesMeshBox(motion_i, motion_j, entity_i);
+	else if (registry.player_attack1.has(entity_j))
+		touching = collidesMeshBox(motion_j, motion_i, entity_j);
+	if (touching)
+	{
+		// Create a collisions event
+		// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
+		registry.collisions.emplace_with_duplicates(entity_i, entity_j);
+		registry.collisions.emplace_with_duplicates(entity_j, entity_i);
+	}
+}
+
 void PhysicsSystem::step(float elapsed_ms)
 {
 	// having entities move at different speed based on the machine.
@@ -554,73 +575,31 @@ void PhysicsSystem::step(float elapsed_ms)
 				}
 			}
 		}
-		// Check for collisions between all moving entities
+		// Tiles never collide with each other. Everything else is tested in
+		// pairs, and against the tiles the static grid finds under its box.
+		static_tiles.sync();
 		ComponentContainer<Motion>& motion_container = registry.motions;
+		std::vector<unsigned int> movers;
 		for (uint i = 0; i < motion_container.components.size(); i++)
 		{
-			Motion& motion_i = motion_container.components[i];
-			Entity entity_i = motion_container.entities[i];
-			if (registry.background.has(entity_i)) continue;
-			bool mesh_i = false, mesh_j = false;
-			if (registry.player_attack1.has(entity_i))
-			{
-				mesh_i = true;
-			}
-
-			// state 0: i is non-mesh, j is non-mesh
-			// state 1: i is mesh, j is non-mesh
-			// state 2: i is non-mesh, j is mesh
-			// state 3: i is mesh, j is mesh ***Note: currently not possible
-
-			// note starting j at i+1 to compare all (i,j) pairs only once (and to not compare with itself)
-			for (uint j = i + 1; j < motion_container.components.size(); j++)
-			{
-				Motion& motion_j = motion_container.components[j];
-				Entity entity_j = motion_container.entities[j];
-				if (registry.background.has(entity_j)) continue;
-				if (registry.player_attack1.has(entity_j))
-				{
-					mesh_j = true;
-				}
-				if (mesh_i || mesh_j)
-				{
-					if (collides(motion_i, motion_j))
-					{
-						bool mesh_collide = false;
-						if (mesh_i)
-						{
-							if (collidesMeshBox(motion_i, motion_j, entity_i))
-							{
-								mesh_collide = true;
-							}
-						}
-						else if (mesh_j)
-						{
-							if (collidesMeshBox(motion_j, motion_i, entity_j))
-							{
-								mesh_collide = true;
-							}
-						}
-						if (mesh_collide)
-						{
-							// Create a collisions event
-							// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-							registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-							registry.collisions.emplace_with_duplicates(entity_j, entity_i);
-						}
-					}
-				}
-				else
-				{
-					if (collides(motion_i, motion_j))
-					{
-						// Create a collisions event
-						// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-						registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-						registry.collisions.emplace_with_duplicates(entity_j, entity_i);
-					}
-				}
-			}
+			Entity entity = motion_container.entities[i];
+			if (!registry.background.has(entity) && !registry.tiles.has(entity))
+				movers.push_back(i);
+		}
+		for (uint a = 0; a < movers.size(); a++)
+		{
+			Motion& motion_i = motion_container.components[movers[a]];
+			Entity entity_i = motion_container.entities[movers[a]];
+
+			// note starting b at a+1 to compare all (i,j) pairs only once (and to not compare with itself)
+			for (uint b = a + 1; b < movers.size(); b++)
+				test_collision(entity_i, motion_i, motion_container.entities[movers[b]], motion_container.components[movers[b]]);
+
+			const vec2 half_size = get_bounding_box(motion_i) / 2.f;
+			static_tiles.query(motion_i.position - half_size, motion_i.position + half_size, [&](uint32_t t) {
+				Entity tile = static_tiles.entities[t];
+				test_collision(entity_i, motion_i, tile, motion_container.get(tile));
+			});
 		}
 	}
 }
\ No newline at end of file
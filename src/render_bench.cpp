@@ -0,0 +1,224 @@
+// internal
+#include "render_bench.hpp"
+#include "headless_context.hpp"
+#include "render_system.hpp"
+#include "tiny_ecs_registry.hpp"
+#include "world_init.hpp"
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Frames drawn before timing starts, the first ones upload text and quads
+const int BENCH_WARMUP_FRAMES = 10;
+
+// A level-like scene around the player: parallax background, a floor, a
+// wall of platforms and one of every animated enemy, plus a field of tiles
+// far outside the camera that only the culling has to deal with
+static void create_bench_scene(RenderSystem* renderer)
+{
+	createBackground(renderer, { window_width_px / 2.f, window_height_px / 2.f }, 2);
+	createParallaxBackground(renderer);
+
+	createCustomTile(renderer, { 640, 1000 }, { 1280, 300 });
+	for (int i = 0; i < 6; i++)
+		createCustomTile(renderer, { 200.f + 180.f * i, 700.f - 60.f * i }, { 150, 40 });
+	createVerticalTile(renderer, { -150, 500 }, { 300, 1280 });
+	for (int y = 0; y < 20; y++)
+		for (int x = 0; x < 20; x++)
+			createTile(renderer, { 3000.f + 100.f * x, 3000.f + 100.f * y });
+
+	createPlayer(renderer, { 640, 700 }, 3);
+	createSkeleton(renderer, { 300, 770 }, 200, 100);
+	createBat(renderer, { 900, 400 }, 100);
+	createRangedEnemy(renderer, { 1000, 775 }, 400, 100, true);
+	createWizard(renderer, { 450, 500 }, 400, 100, true);
+	createWolf(renderer, { 800, 800 }, 200, 2000);
+	createSaw(renderer, { 1150, 810 });
+	createDoor(renderer, { 1200, 780 }, { 70, 120 });
+	createStatue(renderer, { 100, 800 });
+}
+
+static unsigned int png_crc(unsigned int crc, const unsigned char* data, size_t size)
+{
+	static unsigned int table[256];
+	if (table[1] == 0)
+	{
+		for (unsigned int n = 0; n < 256; n++)
+		{
+			unsigned int c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+	}
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void put_u32(std::vector<unsigned char>& out, unsigned int value)
+{
+	out.push_back((unsigned char)(value >> 24));
+	out.push_back((unsigned char)(value >> 16));
+	out.push_back((unsigned char)(value >> 8));
+	out.push_back((unsigned char)value);
+}
+
+static void put_chunk(FILE* file, const char* type, const std::vector<unsigned char>& data)
+{
+	std::vector<unsigned char> chunk;
+	put_u32(chunk, (unsigned int)data.size());
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	put_u32(chunk, png_crc(0, chunk.data() + 4, chunk.size() - 4));
+	fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+// Minimal RGBA8 PNG writer using stored (uncompressed) deflate blocks, the
+// images are only compared, never shipped
+static bool write_png(const char* path, const std::vector<unsigned char>& rgba, ivec2 size)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr)
+		return false;
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	fwrite(signature, 1, sizeof(signature), file);
+
+	std::vector<unsigned char> header;
+	put_u32(header, (unsigned int)size.x);
+	put_u32(header, (unsigned int)size.y);
+	header.push_back(8); // bit depth
+	header.push_back(6); // RGBA
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	put_chunk(file, "IHDR", header);
+
+	// Every row starts with filter type 0
+	const size_t row = (size_t)size.x * 4;
+	std::vector<unsigned char> raw;
+	raw.reserve((row + 1) * size.y);
+	for (int y = 0; y < size.y; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba.begin() + y * row, rgba.begin() + (y + 1) * row);
+	}
+
+	std::vector<unsigned char> zlib = { 0x78, 0x01 };
+	for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535)
+	{
+		const size_t length = std::min<size_t>(65535, raw.size() - offset);
+		zlib.push_back(offset + length == raw.size() ? 1 : 0);
+		zlib.push_back((unsigned char)length);
+		zlib.push_back((unsigned char)(length >> 8));
+		zlib.push_back((unsigned char)~length);
+		zlib.push_back((unsigned char)(~length >> 8));
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+	}
+	unsigned int a = 1, b = 0;
+	for (unsigned char byte : raw)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_u32(zlib, (b << 16) | a);
+	put_chunk(file, "IDAT", zlib);
+	put_chunk(file, "IEND", {});
+
+	const bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+static float percentile(const std::vector<float>& sorted, float p)
+{
+	const size_t index = (size_t)(p * (sorted.size() - 1) + 0.5f);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Draws the bench scene and times it, the renderer is fully initialized
+static int bench_renderer(RenderSystem& renderer, int frame_count, const char* png_path)
+{
+	renderer.fps_bool = false;
+	renderer.help_bool = false;
+	renderer.setGameState(LevelOne);
+	create_bench_scene(&renderer);
+
+	// Textures stream in, draw until the scene is complete so the timed
+	// frames and the image never see a placeholder
+	renderer.draw();
+	while (renderer.texturesLoading())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		renderer.draw();
+	}
+	for (int i = 0; i < BENCH_WARMUP_FRAMES; i++)
+		renderer.draw();
+	glFinish();
+
+	// Each sample includes the GPU finishing the frame
+	std::vector<float> frame_ms;
+	frame_ms.reserve(frame_count);
+	for (int i = 0; i < frame_count; i++)
+	{
+		auto start = Clock::now();
+		renderer.draw();
+		glFinish();
+		frame_ms.push_back((float)(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start)).count() / 1000);
+	}
+
+	if (!frame_ms.empty())
+	{
+		std::vector<float> sorted = frame_ms;
+		std::sort(sorted.begin(), sorted.end());
+		float total = 0.f;
+		for (float ms : frame_ms)
+			total += ms;
+		printf("Render bench: %d frames, mean %.3fms, p50 %.3fms, p90 %.3fms, p99 %.3fms, max %.3fms\n",
+			frame_count, total / frame_count, percentile(sorted, 0.5f), percentile(sorted, 0.9f),
+			percentile(sorted, 0.99f), sorted.back());
+	}
+
+	if (png_path != nullptr)
+	{
+		std::vector<unsigned char> rgba;
+		ivec2 size;
+		renderer.readPixels(rgba, size);
+		if (write_png(png_path, rgba, size))
+			printf("Render bench: final frame written to %s\n", png_path);
+		else
+		{
+			fprintf(stderr, "Failed to write %s\n", png_path);
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+int run_render_bench(int frame_count, const char* png_path)
+{
+	HeadlessContext context;
+	if (!context.create())
+		return EXIT_FAILURE;
+
+	int result = EXIT_FAILURE;
+	{
+		RenderSystem renderer;
+		// Timing a renderer without its shaders or textures measures nothing
+		if (renderer.init(nullptr))
+			result = bench_renderer(renderer, frame_count, png_path);
+		else
+			fprintf(stderr, "Failed to initialize the renderer\n");
+	}
+	registry.clear_all_components();
+	context.destroy();
+	return result;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Renders a fixed scene offscreen for frame_count frames and prints frame time
+// percentiles. When png_path is set the final frame is also written there for
+// golden image comparisons. Returns the process exit code.
+int run_render_bench(int frame_count, const char* png_path);
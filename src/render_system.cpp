@@ -5,46 +5,32 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "tiny_ecs_registry.hpp"
 
-void RenderSystem::drawTexturedMesh(Entity entity,
+void RenderSystem::drawTexturedMesh(const FrameSnapshot& frame, const DrawCommand& draw,
 									const mat3 &projection)
 {
-	Motion &motion = registry.motions.get(entity);
-	// Transformation code, see Rendering and Transformation in the template
-	// specification for more info Incrementally updates transformation matrix,
-	// thus ORDER IS IMPORTANT
-	Transform transform;
-	
-	transform.translate(motion.position);
-	transform.scale(motion.scale);
-	// Rotation to the chain of transformations, mind the order
-	// of transformations
-	//transform.rotate(registry.motions.get(entity).angle);
-	// Mirror across Y axis for moving left and right
-	transform.mirrorYAxis(registry.motions.get(entity).angle);
-	transform.rotateProjectile(motion.angle, entity);
-
-	assert(registry.renderRequests.has(entity));
-	const RenderRequest &render_request = registry.renderRequests.get(entity);
-
-	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
+	const GLuint used_effect_enum = (GLuint)draw.used_effect;
 	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
 
 	// Setting shaders
-	glUseProgram(program);
+	useProgram(program);
 	gl_has_errors();
 
-	assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-	const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
-	const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
+	assert(draw.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
+	const GLuint geometry = (GLuint)draw.used_geometry;
+	// Sprite sheet quads are streamed, the attribute pointers below then
+	// refer to the stream buffer and the draw picks its quad by base vertex
+	const bool streamed = draw.quad >= 0;
+	const GLuint vbo = streamed ? sprite_stream.buffer() : vertex_buffers[geometry];
+	const GLuint ibo = streamed ? quad_index_buffer : index_buffers[geometry];
 
 	// Setting vertex and index buffers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	bindArrayBuffer(vbo);
+	bindElementBuffer(ibo);
 	gl_has_errors();
 
 	// Input data location as in the vertex buffer
-	if (render_request.used_effect == EFFECT_ASSET_ID::TEXTURED)
+	if (draw.used_effect == EFFECT_ASSET_ID::TEXTURED)
 	{
 		GLint in_position_loc = glGetAttribLocation(program, "in_position");
 		GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
@@ -64,18 +50,13 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 			(void *)sizeof(
 				vec3)); // note the stride to skip the preceeding vertex position
 
-		// Enabling and binding texture to slot 0
-		glActiveTexture(GL_TEXTURE0);
-		gl_has_errors();
-
-		assert(registry.renderRequests.has(entity));
-		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
+		// Binding texture to slot 0, which stays the active unit
+		GLuint texture_id = textures.handle(draw.used_texture);
 
-		glBindTexture(GL_TEXTURE_2D, texture_id);
+		bindTexture(texture_id);
 		gl_has_errors();
 	}
-	else if (render_request.used_effect == EFFECT_ASSET_ID::TEXTUREDFIXED)
+	else if (draw.used_effect == EFFECT_ASSET_ID::TEXTUREDFIXED)
 	{
 		GLint in_position_loc = glGetAttribLocation(program, "in_position");
 		GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
@@ -95,71 +76,13 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 			(void *)sizeof(
 				vec3)); // note the stride to skip the preceeding vertex position
 
-		// Enabling and binding texture to slot 0
-		glActiveTexture(GL_TEXTURE0);
-		gl_has_errors();
-
-		assert(registry.renderRequests.has(entity));
-		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
+		// Binding texture to slot 0, which stays the active unit
+		GLuint texture_id = textures.handle(draw.used_texture);
 
-		glBindTexture(GL_TEXTURE_2D, texture_id);
+		bindTexture(texture_id);
 		gl_has_errors();
-		if (render_request.used_texture == TEXTURE_ASSET_ID::HEART_SHEET &&
-			render_request.used_effect == EFFECT_ASSET_ID::TEXTUREDFIXED &&
-			render_request.used_geometry == GEOMETRY_BUFFER_ID::PLAYER_HEART) {
-			registry.player_health.get(entity).stateChange = false;
-			std::string curr_state = registry.player_health.get(entity).getCurrState();
-			glm::uint& sIndex = registry.player_health.get(entity).state_index;
-			glm::uint col = registry.player_health.get(entity).state_map.at(curr_state).first;
-			glm::uint& RowMax = registry.player_health.get(entity).rowMax;
-			glm::uint& ColMax = registry.player_health.get(entity).colMax;
-			float& width = registry.player_health.get(entity).sheetsize.x;
-			float& height = registry.player_health.get(entity).sheetsize.y;
-
-			std::vector<TexturedVertex> textured_vertices(4);
-			// if the texture is off, change it here
-			textured_vertices[0].position = { -1.2f, 0.4f, 0.f };
-			textured_vertices[1].position = { +1.2f, 0.4f, 0.f };
-			textured_vertices[2].position = { +1.2f, -1.6f , 0.f };
-			textured_vertices[3].position = { -1.2f, -1.6f , 0.f };
-			// if the specific texture not loaded correctly, change it here
-			textured_vertices[0].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * (col + 1)) / height };
-			textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
-			textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
-			textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-			const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-			bindVBOandIBO(GEOMETRY_BUFFER_ID::PLAYER_HEART, textured_vertices, textured_indices);
-		}
-
-		if (render_request.used_texture == TEXTURE_ASSET_ID::SHIELD_SHEET &&
-			render_request.used_effect == EFFECT_ASSET_ID::TEXTUREDFIXED &&
-			render_request.used_geometry == GEOMETRY_BUFFER_ID::PLAYER_SHIELD) {
-			registry.shields.get(entity).stateChange = false;
-			std::string curr_state = registry.shields.get(entity).getCurrState();
-			glm::uint& sIndex = registry.shields.get(entity).state_index;
-			glm::uint col = registry.shields.get(entity).state_map.at(curr_state).first;
-			glm::uint& RowMax = registry.shields.get(entity).rowMax;
-			glm::uint& ColMax = registry.shields.get(entity).colMax;
-			float& width = registry.shields.get(entity).sheetsize.x;
-			float& height = registry.shields.get(entity).sheetsize.y;
-
-			std::vector<TexturedVertex> textured_vertices(4);
-			// if the texture is off, change it here
-			textured_vertices[0].position = { -1.2f, 0.4f, 0.f };
-			textured_vertices[1].position = { +1.2f, 0.4f, 0.f };
-			textured_vertices[2].position = { +1.2f, -1.6f , 0.f };
-			textured_vertices[3].position = { -1.2f, -1.6f , 0.f };
-			// if the specific texture not loaded correctly, change it here
-			textured_vertices[0].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * (col + 1)) / height };
-			textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
-			textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
-			textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-			const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-			bindVBOandIBO(GEOMETRY_BUFFER_ID::PLAYER_SHIELD, textured_vertices, textured_indices);
-		}
 	}
-	else if (render_request.used_effect == EFFECT_ASSET_ID::PLAYER || render_request.used_effect == EFFECT_ASSET_ID::EGG)
+	else if (draw.used_effect == EFFECT_ASSET_ID::PLAYER || draw.used_effect == EFFECT_ASSET_ID::EGG)
 	{
 		GLint in_position_loc = glGetAttribLocation(program, "in_position");
 		GLint in_color_loc = glGetAttribLocation(program, "in_color");
@@ -175,7 +98,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 							  sizeof(ColoredVertex), (void *)sizeof(vec3));
 		gl_has_errors();
 
-		if (render_request.used_effect == EFFECT_ASSET_ID::PLAYER)
+		if (draw.used_effect == EFFECT_ASSET_ID::PLAYER)
 		{
 			// Status glow
 			GLint status_glow_uloc = glGetUniformLocation(program, "status_glow");
@@ -194,25 +117,87 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 
 	// Getting uniform locations for glUniform* calls
 	GLint color_uloc = glGetUniformLocation(program, "fcolor");
-	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
-	glUniform3fv(color_uloc, 1, (float *)&color);
+	glUniform3fv(color_uloc, 1, (float *)&draw.color);
 	gl_has_errors();
 
-	// Get number of indices from index buffer, which has elements uint16_t
-	GLint size = 0;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+	// Setting uniform values to the currently bound program
+	GLuint transform_loc = glGetUniformLocation(program, "transform");
+	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&draw.transform);
+	GLuint projection_loc = glGetUniformLocation(program, "projection");
+	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float *)&projection);
+
 	gl_has_errors();
+	if (streamed)
+	{
+		// The frame's quads were written by renderFrame, four vertices each
+		const GLint base_vertex = (GLint)(quads_base_vertex + 4 * draw.quad);
+		glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, base_vertex);
+		gl_has_errors();
+		return;
+	}
 
-	GLsizei num_indices = size / sizeof(uint16_t);
-	// GLsizei num_triangles = num_indices / 3;
+	// Index count is tracked on upload
+	const GLsizei num_indices = index_counts[geometry];
+	// Drawing of num_indices/3 triangles specified in the index buffer
+	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+	gl_has_errors();
+}
 
-	GLint currProgram;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
-	// Setting uniform values to the currently bound program
-	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&transform.mat);
-	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
-	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float *)&projection);
+// Advances the shared quad of sprite sheet geometries whose animation state
+// changed, runs on the main thread since it clears the components' stateChange
+void RenderSystem::updateSpriteSheet(Entity entity, const RenderRequest& render_request)
+{
+	if (render_request.used_texture == TEXTURE_ASSET_ID::HEART_SHEET &&
+		render_request.used_effect == EFFECT_ASSET_ID::TEXTUREDFIXED &&
+		render_request.used_geometry == GEOMETRY_BUFFER_ID::PLAYER_HEART) {
+		registry.player_health.get(entity).stateChange = false;
+		std::string curr_state = registry.player_health.get(entity).getCurrState();
+		glm::uint& sIndex = registry.player_health.get(entity).state_index;
+		glm::uint col = registry.player_health.get(entity).state_map.at(curr_state).first;
+		glm::uint& RowMax = registry.player_health.get(entity).rowMax;
+		glm::uint& ColMax = registry.player_health.get(entity).colMax;
+		float& width = registry.player_health.get(entity).sheetsize.x;
+		float& height = registry.player_health.get(entity).sheetsize.y;
+
+		std::array<TexturedVertex, 4> textured_vertices;
+		// if the texture is off, change it here
+		textured_vertices[0].position = { -1.2f, 0.4f, 0.f };
+		textured_vertices[1].position = { +1.2f, 0.4f, 0.f };
+		textured_vertices[2].position = { +1.2f, -1.6f , 0.f };
+		textured_vertices[3].position = { -1.2f, -1.6f , 0.f };
+		// if the specific texture not loaded correctly, change it here
+		textured_vertices[0].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * (col + 1)) / height };
+		textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
+		textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
+		textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
+		updateSpriteQuad(GEOMETRY_BUFFER_ID::PLAYER_HEART, textured_vertices);
+	}
+
+	if (render_request.used_texture == TEXTURE_ASSET_ID::SHIELD_SHEET &&
+		render_request.used_effect == EFFECT_ASSET_ID::TEXTUREDFIXED &&
+		render_request.used_geometry == GEOMETRY_BUFFER_ID::PLAYER_SHIELD) {
+		registry.shields.get(entity).stateChange = false;
+		std::string curr_state = registry.shields.get(entity).getCurrState();
+		glm::uint& sIndex = registry.shields.get(entity).state_index;
+		glm::uint col = registry.shields.get(entity).state_map.at(curr_state).first;
+		glm::uint& RowMax = registry.shields.get(entity).rowMax;
+		glm::uint& ColMax = registry.shields.get(entity).colMax;
+		float& width = registry.shields.get(entity).sheetsize.x;
+		float& height = registry.shields.get(entity).sheetsize.y;
+
+		std::array<TexturedVertex, 4> textured_vertices;
+		// if the texture is off, change it here
+		textured_vertices[0].position = { -1.2f, 0.4f, 0.f };
+		textured_vertices[1].position = { +1.2f, 0.4f, 0.f };
+		textured_vertices[2].position = { +1.2f, -1.6f , 0.f };
+		textured_vertices[3].position = { -1.2f, -1.6f , 0.f };
+		// if the specific texture not loaded correctly, change it here
+		textured_vertices[0].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * (col + 1)) / height };
+		textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
+		textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
+		textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
+		updateSpriteQuad(GEOMETRY_BUFFER_ID::PLAYER_SHIELD, textured_vertices);
+	}
 
 	if (render_request.used_texture == TEXTURE_ASSET_ID::SKELETON_IDLE &&
 		render_request.used_effect == EFFECT_ASSET_ID::TEXTURED &&
@@ -231,7 +216,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.skeletonEnemy.get(entity).sheetsize.x;
 				float& height = registry.skeletonEnemy.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -1.5f, 1.4f, 0.f };
 				textured_vertices[1].position = { +1.5f, 1.4f, 0.f };
@@ -242,8 +227,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax)* col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::SKELETON_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::SKELETON_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -265,7 +249,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.batEnemy.get(entity).sheetsize.x;
 				float& height = registry.batEnemy.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -1.5f, 1.4f, 0.f };
 				textured_vertices[1].position = { +1.5f, 1.4f, 0.f };
@@ -276,8 +260,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax)* col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::BAT_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::BAT_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -299,7 +282,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.rangedEnemy.get(entity).sheetsize.x;
 				float& height = registry.rangedEnemy.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -2.0f, 1.8f, 0.f };
 				textured_vertices[1].position = { +2.0f, 1.8f, 0.f };
@@ -310,8 +293,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax)* col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::MUSHROOM_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::MUSHROOM_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -333,7 +315,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.wizards.get(entity).sheetsize.x;
 				float& height = registry.wizards.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -2.0f, 0.5f, 0.f };
 				textured_vertices[1].position = { +2.4f, 0.5f, 0.f };
@@ -344,8 +326,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::WIZARD_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::WIZARD_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -367,7 +348,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.magicBalls1.get(entity).sheetsize.x;
 				float& height = registry.magicBalls1.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -4.1f, 3.9f, 0.f };
 				textured_vertices[1].position = { +1.3f, 3.9f, 0.f };
@@ -378,8 +359,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::MAGICBALL1, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::MAGICBALL1, textured_vertices);
 			}
 		}
 	}
@@ -402,7 +382,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.magicBalls2.get(entity).sheetsize.x;
 				float& height = registry.magicBalls2.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -5.7f, 3.9f, 0.f };
 				textured_vertices[1].position = { +3.0f, 3.9f, 0.f };
@@ -413,8 +393,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::MAGICBALL2, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::MAGICBALL2, textured_vertices);
 			}
 		}
 	}
@@ -436,7 +415,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.saws.get(entity).sheetsize.x;
 				float& height = registry.saws.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -1.0f, 1.5f, 0.f };
 				textured_vertices[1].position = { +1.0f, 1.5f, 0.f };
@@ -447,8 +426,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax)* col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::SAW, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::SAW, textured_vertices);
 			}
 		}
 	}
@@ -470,7 +448,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.wolfEnemy.get(entity).sheetsize.x;
 				float& height = registry.wolfEnemy.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -1.0f, 0.5f, 0.f };
 				textured_vertices[1].position = { +1.0f, 0.5f, 0.f };
@@ -481,8 +459,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::WOLF_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::WOLF_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -504,7 +481,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.golem.get(entity).sheetsize.x;
 				float& height = registry.golem.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -1.1f, 1.2f, 0.f };
 				textured_vertices[1].position = { +1.1f, 1.2f, 0.f };
@@ -515,8 +492,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::GOLEM_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::GOLEM_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -538,7 +514,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.armProjectile.get(entity).sheetsize.x;
 				float& height = registry.armProjectile.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -0.5f, 1.5f, 0.f };
 				textured_vertices[1].position = { +0.5f, 1.5f, 0.f };
@@ -549,8 +525,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::ARMPROJECTILE_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::ARMPROJECTILE_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -572,7 +547,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.energyProjectile.get(entity).sheetsize.x;
 				float& height = registry.energyProjectile.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -1.1f, 0.9f, 0.f };
 				textured_vertices[1].position = { +0.9f, 0.9f, 0.f };
@@ -583,8 +558,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax) * col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax) * col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::ENERGYPROJECTILE_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::ENERGYPROJECTILE_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -606,7 +580,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.demonBoss.get(entity).sheetsize.x;
 				float& height = registry.demonBoss.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -2.1f, 0.5f, 0.f };
 				textured_vertices[1].position = { +2.1f, 0.5f, 0.f };
@@ -617,8 +591,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax)* col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::DEMON_ENEMY, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::DEMON_ENEMY, textured_vertices);
 			}
 		}
 	}
@@ -640,7 +613,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				float& width = registry.players.get(entity).sheetsize.x;
 				float& height = registry.players.get(entity).sheetsize.y;
 
-				std::vector<TexturedVertex> textured_vertices(4);
+				std::array<TexturedVertex, 4> textured_vertices;
 				// if the texture is off, change it here
 				textured_vertices[0].position = { -2.0f, 0.4f, 0.f };
 				textured_vertices[1].position = { +2.3f, 0.4f, 0.f };
@@ -651,115 +624,302 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 				textured_vertices[1].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* (col + 1)) / height };
 				textured_vertices[2].texcoord = { ((width / RowMax) * sIndex) / width, ((height / ColMax)* col) / height };
 				textured_vertices[3].texcoord = { ((width / RowMax) * (sIndex - 1)) / width, ((height / ColMax)* col) / height };
-				const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
-				bindVBOandIBO(GEOMETRY_BUFFER_ID::PLAYER, textured_vertices, textured_indices);
+				updateSpriteQuad(GEOMETRY_BUFFER_ID::PLAYER, textured_vertices);
 			}
 		}
+	}
+}
 
-		// camera
-		float x = registry.players.get(registry.players.entities[0]).camera_x;
-		float y = registry.players.get(registry.players.entities[0]).camera_y;
-		glm::vec3 playerPos = glm::vec3(
-			(2.0f * x - window_width_px) / window_width_px, ((window_height_px - y - 400.0f) * 2.0f) / window_height_px,
-			0.0f);
+void RenderSystem::updateSpriteQuad(GEOMETRY_BUFFER_ID gid, const std::array<TexturedVertex, 4>& vertices)
+{
+	assert(sprite_quad_streamed[(GLuint)gid]);
+	sprite_quads[(GLuint)gid] = vertices;
 
-		glm::mat4 viewMatrix = glm::lookAt(
-			playerPos + glm::vec3(0.0f, 0.0f, 1.0f),
-			playerPos,
-			glm::vec3(0.0f, 1.0f, 0.0f)
-		);
-		GLuint viewMatrixLocation = glGetUniformLocation(currProgram, "viewMatrix");
-		glUniformMatrix4fv(viewMatrixLocation, 1, GL_FALSE, (float *)&viewMatrix);
+	vec2 bounds_min = vec2(vertices[0].position);
+	vec2 bounds_max = bounds_min;
+	for (const TexturedVertex& vertex : vertices)
+	{
+		bounds_min = min(bounds_min, vec2(vertex.position));
+		bounds_max = max(bounds_max, vec2(vertex.position));
 	}
-
-	gl_has_errors();
-	// Drawing of num_indices/3 triangles specified in the index buffer
-	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
-	gl_has_errors();
+	geometry_bounds_min[(GLuint)gid] = bounds_min;
+	geometry_bounds_max[(GLuint)gid] = bounds_max;
 }
 
-void RenderSystem::drawText(std::string text, vec2 pos, vec2 scale, const glm::vec3& color, const glm::mat4& trans)
+// FNV-1a over raw bytes, used to key the text cache
+static size_t text_hash(size_t hash, const void* data, size_t size)
 {
-	// activate corresponding render state
-	glUseProgram(m_font_shaderProgram);
-	GLint textColor_location = glGetUniformLocation(m_font_shaderProgram, "textColor");
-	assert(textColor_location > -1);
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= (size_t)1099511628211ULL;
+	}
+	return hash;
+}
 
-	glUniform3f(textColor_location, color.x, color.y, color.z);
-	auto transformLoc = glGetUniformLocation(m_font_shaderProgram, "transform");
-	assert(transformLoc > -1);
+// Text that has not been drawn for this many frames is dropped on the next compaction
+const unsigned int TEXT_CACHE_FRAMES = 120;
+// Strings placed by one draw, the size of the uniform arrays in font.vs.glsl
+const size_t TEXT_SLOTS = 32;
+// Glyphs reserved after a counter's label, enough for "-2147483648/-2147483648"
+const size_t COUNTER_TAIL_GLYPHS = 23;
 
-	glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(trans));
+RenderSystem::TextCacheEntry& RenderSystem::findText(const std::string& text, bool is_counter, vec2 scale)
+{
+	// Moving or recolored text hits the same entry, and so does a counter
+	// whose numbers changed, only the label and size are hashed
+	size_t key = text_hash((size_t)14695981039346656037ULL, text.data(), text.size());
+	key = text_hash(key, &is_counter, sizeof(is_counter));
+	key = text_hash(key, &scale, sizeof(scale));
+
+	auto range = m_text_cache.equal_range(key);
+	for (auto it = range.first; it != range.second; it++)
+	{
+		TextCacheEntry& entry = it->second;
+		// Already queued this frame means the same string is drawn twice
+		if (entry.is_counter == is_counter && entry.scale == scale && entry.text == text &&
+			entry.last_used_frame != m_text_frame)
+			return entry;
+	}
 
-	glBindVertexArray(m_font_VAO);
+	TextCacheEntry& entry = m_text_cache.emplace(key, TextCacheEntry())->second;
+	entry.text = text;
+	entry.is_counter = is_counter;
+	entry.counter_value = ivec2(0);
+	entry.scale = scale;
+	entry.first = -1;
+	entry.slot = -1;
+	entry.dirty_begin = 0;
+	entry.dirty_end = 0;
+	entry.last_used_frame = m_text_frame;
+	entry.tail_x = layoutText(entry.vertices, text, 0.f, scale, 0.f);
+	entry.tail_first = entry.vertices.size();
+	if (is_counter)
+	{
+		// The digits are filled in when the counter is queued, unused
+		// quads past count are never drawn
+		entry.vertices.resize(entry.tail_first + COUNTER_TAIL_GLYPHS * 6, TextVertex());
+	}
+	entry.count = entry.tail_first;
+	return entry;
+}
 
-	// iterate through all characters
-	std::string::const_iterator c;
-	for (c = text.begin(); c != text.end(); c++)
+float RenderSystem::layoutText(std::vector<TextVertex>& vertices, const std::string& text, float x, vec2 scale, float slot)
+{
+	// Lay out every glyph on the CPU around the string's origin, its
+	// placement is applied when it is drawn
+	vec2 pos = vec2(x, 0.f);
+	for (char c : text)
 	{
-		Character ch = m_ftCharacters[*c];
+		const Character& ch = m_ftCharacters[(unsigned char)c & 127];
 		float xpos = pos.x + ch.Bearing.x * scale.x;
 		float ypos = pos.y - (ch.Size.y - ch.Bearing.y) * scale.y;
 		float w = ch.Size.x * scale.x;
 		float h = ch.Size.y * scale.y;
 
-		// update VBO for each character
-		float vertices[6][4] = {
-		{ xpos, ypos + h, 0.0f, 0.0f },
-		{ xpos, ypos, 0.0f, 1.0f },
-		{ xpos + w, ypos, 1.0f, 1.0f },
-		{ xpos, ypos + h, 0.0f, 0.0f },
-		{ xpos + w, ypos, 1.0f, 1.0f },
-		{ xpos + w, ypos + h, 1.0f, 0.0f }
-		};
-		// render glyph texture over quad
-		glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-
-		// update content of VBO memory
-		glBindBuffer(GL_ARRAY_BUFFER, m_font_VBO);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // ERROR HERE INVALID VALUE
+		vec2 top_left = vec2(xpos, ypos + h);
+		vec2 bottom_left = vec2(xpos, ypos);
+		vec2 bottom_right = vec2(xpos + w, ypos);
+		vec2 top_right = vec2(xpos + w, ypos + h);
+
+		vertices.push_back({ top_left, { ch.UVMin.x, ch.UVMin.y }, slot });
+		vertices.push_back({ bottom_left, { ch.UVMin.x, ch.UVMax.y }, slot });
+		vertices.push_back({ bottom_right, { ch.UVMax.x, ch.UVMax.y }, slot });
+		vertices.push_back({ top_left, { ch.UVMin.x, ch.UVMin.y }, slot });
+		vertices.push_back({ bottom_right, { ch.UVMax.x, ch.UVMax.y }, slot });
+		vertices.push_back({ top_right, { ch.UVMax.x, ch.UVMin.y }, slot });
 
-		gl_has_errors();
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		// render quad
-		glDrawArrays(GL_TRIANGLES, 0, 6);
 		// now advance cursors for next glyph (note that advance is number of 1/64 pixels)
 		pos.x += (ch.Advance >> 6) * scale.x; // bitshift by 6 to get value in pixels (2^6 = 64)
 	}
-	// Unbind text VAO
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	return pos.x;
+}
+
+void RenderSystem::setCounterValue(TextCacheEntry& entry, ivec2 value)
+{
+	std::string digits = std::to_string(value.x);
+	if (value.y >= 0)
+		digits += "/" + std::to_string(value.y);
+
+	// The label's quads stay as they are, the new digits overwrite the
+	// start of the tail and only that range is uploaded again
+	m_text_digits.clear();
+	layoutText(m_text_digits, digits, entry.tail_x, entry.scale, (float)entry.slot);
+	std::copy(m_text_digits.begin(), m_text_digits.end(), entry.vertices.begin() + entry.tail_first);
+	entry.counter_value = value;
+	entry.count = entry.tail_first + m_text_digits.size();
+	entry.markDirty(entry.tail_first, entry.count);
+}
+
+void RenderSystem::drawText(const std::string& text, vec2 pos, vec2 scale, const glm::vec3& color, const glm::mat4& trans)
+{
+	frames[build_slot].texts.push_back({ text, false, ivec2(0), pos, scale, color, trans });
+}
+
+void RenderSystem::drawCounter(const std::string& label, int value, vec2 pos, vec2 scale, const glm::vec3& color, const glm::mat4& trans)
+{
+	drawCounter(label, value, -1, pos, scale, color, trans);
+}
+
+// A negative total only shows the value
+void RenderSystem::drawCounter(const std::string& label, int value, int total, vec2 pos, vec2 scale, const glm::vec3& color, const glm::mat4& trans)
+{
+	frames[build_slot].texts.push_back({ label, true, ivec2(value, total), pos, scale, color, trans });
+}
+
+void RenderSystem::queueText(const TextCommand& command)
+{
+	TextCacheEntry& entry = findText(command.text, command.is_counter, command.scale);
+	entry.last_used_frame = m_text_frame;
+
+	// Strings take the slots in draw order, the HUD draws the same strings in
+	// the same order every frame so the vertices rarely need the new slot
+	const int slot = (int)(m_text_queue.size() % TEXT_SLOTS);
+	if (entry.slot != slot)
+	{
+		entry.slot = slot;
+		for (TextVertex& vertex : entry.vertices)
+			vertex.slot = (float)slot;
+		entry.markDirty(0, entry.vertices.size());
+	}
+	// A new counter has no digits yet
+	if (entry.is_counter && (entry.count == entry.tail_first || entry.counter_value != command.counter_value))
+		setCounterValue(entry, command.counter_value);
+
+	const mat4 transform = glm::translate(command.trans, vec3(command.pos, 0.f));
+	m_text_queue.push_back({ &entry, transform, command.color });
+}
+
+void RenderSystem::compactTextBuffer(size_t needed)
+{
+	size_t total = 0;
+	for (auto it = m_text_cache.begin(); it != m_text_cache.end();)
+	{
+		if (m_text_frame - it->second.last_used_frame > TEXT_CACHE_FRAMES)
+		{
+			it = m_text_cache.erase(it);
+			continue;
+		}
+		total += it->second.vertices.size();
+		it++;
+	}
+
+	// Orphan the old storage and repack everything that is still alive
+	while (total + needed > m_text_vbo_capacity)
+		m_text_vbo_capacity *= 2;
+	glBufferData(GL_ARRAY_BUFFER, sizeof(TextVertex) * m_text_vbo_capacity, nullptr, GL_DYNAMIC_DRAW);
+	m_text_vbo_used = 0;
+	for (auto& it : m_text_cache)
+	{
+		TextCacheEntry& entry = it.second;
+		entry.first = (GLint)m_text_vbo_used;
+		entry.dirty_begin = entry.dirty_end = 0;
+		glBufferSubData(GL_ARRAY_BUFFER, sizeof(TextVertex) * m_text_vbo_used, sizeof(TextVertex) * entry.vertices.size(), entry.vertices.data());
+		m_text_vbo_used += entry.vertices.size();
+	}
+	gl_has_errors();
+}
+
+void RenderSystem::flushText()
+{
+	if (m_text_queue.empty())
+	{
+		m_text_frame++;
+		return;
+	}
+
+	useProgram(m_font_shaderProgram);
+	bindVertexArray(m_font_VAO);
+	bindTexture(m_font_atlas);
+	bindArrayBuffer(m_font_VBO);
+
+	// Upload strings that are new or changed since they were last drawn
+	size_t needed = 0;
+	for (const TextDraw& draw : m_text_queue)
+		if (draw.entry->first < 0)
+			needed += draw.entry->vertices.size();
+	if (m_text_vbo_used + needed > m_text_vbo_capacity)
+		compactTextBuffer(needed);
+	// New strings land back to back after the bump pointer, one upload covers
+	// them. Resident strings whose vertices changed are patched in place.
+	m_text_upload.clear();
+	for (const TextDraw& draw : m_text_queue)
+	{
+		TextCacheEntry* entry = draw.entry;
+		if (entry->first < 0)
+		{
+			entry->first = (GLint)(m_text_vbo_used + m_text_upload.size());
+			m_text_upload.insert(m_text_upload.end(), entry->vertices.begin(), entry->vertices.end());
+		}
+		else if (entry->dirty_begin < entry->dirty_end)
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, sizeof(TextVertex) * (entry->first + entry->dirty_begin),
+				sizeof(TextVertex) * (entry->dirty_end - entry->dirty_begin), entry->vertices.data() + entry->dirty_begin);
+		}
+		entry->dirty_begin = entry->dirty_end = 0;
+	}
+	if (!m_text_upload.empty())
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, sizeof(TextVertex) * m_text_vbo_used, sizeof(TextVertex) * m_text_upload.size(), m_text_upload.data());
+		m_text_vbo_used += m_text_upload.size();
+	}
+	gl_has_errors();
+
+	// Every string is one range of a single draw, its vertices pick their
+	// placement and color by slot. Only more than TEXT_SLOTS strings need
+	// another draw for the next slots.
+	for (size_t batch = 0; batch < m_text_queue.size(); batch += TEXT_SLOTS)
+	{
+		m_text_transforms.clear();
+		m_text_colors.clear();
+		m_text_firsts.clear();
+		m_text_counts.clear();
+		for (size_t i = batch; i < m_text_queue.size() && i < batch + TEXT_SLOTS; i++)
+		{
+			const TextDraw& draw = m_text_queue[i];
+			m_text_transforms.push_back(draw.transform);
+			m_text_colors.push_back(draw.color);
+			if (draw.entry->count == 0)
+				continue;
+			m_text_firsts.push_back(draw.entry->first);
+			m_text_counts.push_back((GLsizei)draw.entry->count);
+		}
+		glUniformMatrix4fv(m_font_transforms_loc, (GLsizei)m_text_transforms.size(), GL_FALSE, (float*)m_text_transforms.data());
+		glUniform3fv(m_font_colors_loc, (GLsizei)m_text_colors.size(), (float*)m_text_colors.data());
+		glMultiDrawArrays(GL_TRIANGLES, m_text_firsts.data(), m_text_counts.data(), (GLsizei)m_text_firsts.size());
+	}
+	gl_has_errors();
+	m_text_queue.clear();
+	m_text_frame++;
 
-	resetVAO();
+	// Sprites are drawn with the dummy VAO
+	bindVertexArray(m_vao);
 }
 
 // draw the intermediate texture to the screen, with some distortion to simulate
 // wind
-void RenderSystem::drawToScreen()
+void RenderSystem::drawToScreen(const FrameSnapshot& frame)
 {
 	// Setting shaders
 	// get the wind texture, sprite mesh, and program
-	glUseProgram(effects[(GLuint)EFFECT_ASSET_ID::WIND]);
+	useProgram(effects[(GLuint)EFFECT_ASSET_ID::WIND]);
 	gl_has_errors();
 	// Clearing backbuffer
-	int w, h;
-	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glViewport(0, 0, w, h);
+	glViewport(0, 0, frame.framebuffer_size.x, frame.framebuffer_size.y);
 	glDepthRange(0, 10);
 	glClearColor(1.f, 0, 0, 1.0);
 	glClearDepth(1.f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	gl_has_errors();
 	// Enabling alpha channel for textures
-	glDisable(GL_BLEND);
-	// glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	setBlend(false);
 	glDisable(GL_DEPTH_TEST);
 
 	// Draw the screen texture on the quad geometry
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
-	glBindBuffer(
-		GL_ELEMENT_ARRAY_BUFFER,
+	bindArrayBuffer(vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
+	bindElementBuffer(
 		index_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]); // Note, GL_ELEMENT_ARRAY_BUFFER associates
 																	 // indices to the bound GL_ARRAY_BUFFER
 	gl_has_errors();
@@ -767,9 +927,10 @@ void RenderSystem::drawToScreen()
 	// Set clock
 	GLuint time_uloc = glGetUniformLocation(wind_program, "time");
 	GLuint dead_timer_uloc = glGetUniformLocation(wind_program, "darken_screen_factor");
-	glUniform1f(time_uloc, (float)(glfwGetTime() * 10.0f));
-	ScreenState &screen = registry.screenStates.get(screen_state_entity);
-	glUniform1f(dead_timer_uloc, screen.darken_screen_factor);
+	GLuint wind_strength_uloc = glGetUniformLocation(wind_program, "wind_strength");
+	glUniform1f(time_uloc, frame.time);
+	glUniform1f(dead_timer_uloc, frame.darken_screen_factor);
+	glUniform1f(wind_strength_uloc, frame.wind_strength);
 	gl_has_errors();
 	// Set the vertex position and vertex texture coordinates (both stored in the
 	// same VBO)
@@ -779,9 +940,7 @@ void RenderSystem::drawToScreen()
 	gl_has_errors();
 
 	// Bind our texture in Texture Unit 0
-	glActiveTexture(GL_TEXTURE0);
-
-	glBindTexture(GL_TEXTURE_2D, off_screen_render_buffer_color);
+	bindTexture(off_screen_render_buffer_color);
 	gl_has_errors();
 	// Draw
 	glDrawElements(
@@ -791,51 +950,217 @@ void RenderSystem::drawToScreen()
 	gl_has_errors();
 }
 
-void RenderSystem::resetVAO() {
-	// Rebind Dummy VAO
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
+// Every parallax strip is a single quad with a wrapping texture
+void RenderSystem::drawParallax(const FrameSnapshot& frame)
+{
+	if (frame.parallax.empty())
+		return;
+
+	const GLuint program = effects[(GLuint)EFFECT_ASSET_ID::PARALLAX];
+	useProgram(program);
+	bindVertexArray(m_empty_vao);
+	GLint rect_uloc = glGetUniformLocation(program, "rect");
+	GLint tile_size_uloc = glGetUniformLocation(program, "tile_size");
+	GLint scroll_uloc = glGetUniformLocation(program, "scroll");
+	GLint flip_y_uloc = glGetUniformLocation(program, "flip_y");
+	GLint screen_size_uloc = glGetUniformLocation(program, "screen_size");
+	glUniform2f(screen_size_uloc, (float)window_width_px, (float)window_height_px);
+	gl_has_errors();
+
+	for (const ParallaxCommand& layer : frame.parallax)
+	{
+		bindTexture(textures.handle(layer.texture));
+		glUniform4fv(rect_uloc, 1, (float*)&layer.rect);
+		glUniform2fv(tile_size_uloc, 1, (float*)&layer.tile_size);
+		glUniform1f(scroll_uloc, layer.scroll);
+		glUniform1i(flip_y_uloc, layer.flip_y ? 1 : 0);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	}
+	gl_has_errors();
+
+	// Sprites are drawn with the dummy VAO
+	bindVertexArray(m_vao);
+}
+
+// Every debug line of the frame in one draw, in the world space of the sprites
+void RenderSystem::drawDebugLines(const FrameSnapshot& frame, const mat3& projection)
+{
+	if (frame.debug_lines.empty())
+		return;
+
+	const GLuint program = effects[(GLuint)EFFECT_ASSET_ID::DEBUG_LINES];
+	useProgram(program);
+	GLint projection_uloc = glGetUniformLocation(program, "projection");
+	GLint view_uloc = glGetUniformLocation(program, "viewMatrix");
+	const mat4 view = frame.camera_valid ? frame.camera_view : mat4(1.f);
+	glUniformMatrix3fv(projection_uloc, 1, GL_FALSE, (float*)&projection);
+	glUniformMatrix4fv(view_uloc, 1, GL_FALSE, (float*)&view);
+
+	bindVertexArray(m_debug_vao);
+	bindArrayBuffer(sprite_stream.buffer());
+	const size_t offset = sprite_stream.write(frame.debug_lines.data(), sizeof(DebugVertex) * frame.debug_lines.size(), sizeof(DebugVertex));
+	glDrawArrays(GL_LINES, (GLint)(offset / sizeof(DebugVertex)), (GLsizei)frame.debug_lines.size());
 	gl_has_errors();
+
+	bindVertexArray(m_vao);
+}
+
+// Forget everything we know about the bound state, the next bind of each kind
+// always reaches the driver
+void RenderSystem::invalidateGLState()
+{
+	const GLuint unknown = (GLuint)-1;
+	gl_state.program = unknown;
+	gl_state.texture = unknown;
+	gl_state.array_buffer = unknown;
+	gl_state.element_buffer = unknown;
+	gl_state.vertex_array = unknown;
+	gl_state.blend = -1;
+}
+
+void RenderSystem::useProgram(GLuint program)
+{
+	if (gl_state.program == program)
+		return;
+	glUseProgram(program);
+	gl_state.program = program;
+}
+
+void RenderSystem::bindTexture(GLuint texture)
+{
+	if (gl_state.texture == texture)
+		return;
+	glBindTexture(GL_TEXTURE_2D, texture);
+	gl_state.texture = texture;
+}
+
+void RenderSystem::bindArrayBuffer(GLuint buffer)
+{
+	if (gl_state.array_buffer == buffer)
+		return;
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	gl_state.array_buffer = buffer;
+}
+
+void RenderSystem::bindElementBuffer(GLuint buffer)
+{
+	if (gl_state.element_buffer == buffer)
+		return;
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+	gl_state.element_buffer = buffer;
+}
+
+void RenderSystem::bindVertexArray(GLuint vao)
+{
+	if (gl_state.vertex_array == vao)
+		return;
+	glBindVertexArray(vao);
+	gl_state.vertex_array = vao;
+	// The element buffer binding is part of the VAO state
+	gl_state.element_buffer = (GLuint)-1;
+}
+
+void RenderSystem::setBlend(bool enabled)
+{
+	if (gl_state.blend == (GLint)enabled)
+		return;
+	if (enabled)
+		glEnable(GL_BLEND);
+	else
+		glDisable(GL_BLEND);
+	gl_state.blend = (GLint)enabled;
 }
 
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
 void RenderSystem::draw()
 {
-	// Getting size of window
-	int w, h;
-	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
-	
-	// First render to the custom framebuffer
-	glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
-	gl_has_errors();
-	// Clearing backbuffer
-	glViewport(0, 0, w, h);
-	glDepthRange(0.00001, 10);
+	FrameSnapshot& frame = beginFrame();
+	buildFrame(frame);
+	submitFrame();
+}
 
-	glClearColor(0.674, 0.847, 0.0 , 1.0);
-	glClearDepth(10.f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_DEPTH_TEST); // native OpenGL does not work with a depth buffer
-							  // and alpha blending, one would have to sort
-							  // sprites back to front
-	gl_has_errors();
-	mat3 projection_2D = createProjectionMatrix();
-	// Draw all textured meshes that have a position and size component
-	for (Entity entity : registry.renderRequests.entities)
+// Copies everything the frame needs out of the registry, runs on the main
+// thread between simulation steps
+void RenderSystem::buildFrame(FrameSnapshot& frame)
+{
+	// Getting size of window
+	frame.framebuffer_size = getFramebufferSize();
+
+	// Render to the custom framebuffer only when a post effect needs the
+	// frame as a texture, otherwise straight into the backbuffer
+	frame.post_process = false;
+	frame.darken_screen_factor = 0.f;
+	frame.wind_strength = 0.f;
+	if (registry.screenStates.has(screen_state_entity))
 	{
-		if (!registry.motions.has(entity))
-			continue;
-		// Note, its not very efficient to access elements indirectly via the entity
-		// albeit iterating through all Sprites in sequence. A good point to optimize
-
-		// do not render attack obj
-		if (registry.player_attack1.has(entity) || registry.player_attack2.has(entity))
-			continue;
-
-		drawTexturedMesh(entity, projection_2D);
+		const ScreenState& screen = registry.screenStates.get(screen_state_entity);
+		frame.post_process = screen.needsPostProcess();
+		frame.darken_screen_factor = screen.darken_screen_factor;
+		frame.wind_strength = screen.wind_strength;
+	}
+	// Offscreen frames do not animate so benchmark output is reproducible
+	frame.time = window != nullptr ? (float)(glfwGetTime() * 10.0f) : 0.f;
+	frame.profile_gpu = fps_bool || gpu_profiler.isLogging();
+
+	updateCamera();
+	collectVisible();
+	frame.camera_valid = camera_valid;
+	frame.camera_view = camera_view;
+
+	frame.draws.clear();
+	frame.quads.clear();
+	frame.texts.clear();
+	copy_debug_lines(frame.debug_lines);
+
+	// Parallax strips scroll with the camera, slower for larger factors
+	frame.parallax.clear();
+	const float camera_x = camera_valid ? (camera_min.x + camera_max.x) / 2.f : 0.f;
+	for (const ParallaxLayer& layer : parallax_layers)
+	{
+		frame.parallax.push_back({ layer.texture, vec4(layer.screen_pos, layer.screen_size),
+			layer.tile_size, camera_x / layer.speed_factor, layer.flip_y });
+	}
+	frame.first_after_parallax = 0;
+	while (frame.first_after_parallax < visible_draws.size() &&
+		(visible_draws[frame.first_after_parallax].key >> 56) <= (uint64_t)RENDER_LAYER::PARALLAX)
+		frame.first_after_parallax++;
+
+	// Draw all textured meshes that have a position and size component and
+	// overlap the camera, layer by layer
+	for (const DrawItem& item : visible_draws)
+	{
+		const Entity entity = item.entity;
+		const RenderRequest& render_request = registry.renderRequests.get(entity);
+		updateSpriteSheet(entity, render_request);
+
+		Motion &motion = registry.motions.get(entity);
+		// Transformation code, see Rendering and Transformation in the template
+		// specification for more info Incrementally updates transformation matrix,
+		// thus ORDER IS IMPORTANT
+		Transform transform;
+		transform.translate(motion.position);
+		transform.scale(motion.scale);
+		// Mirror across Y axis for moving left and right
+		transform.mirrorYAxis(motion.angle);
+		transform.rotateProjectile(motion.angle, entity);
+
+		DrawCommand draw;
+		draw.transform = transform.mat;
+		draw.color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
+		draw.used_effect = render_request.used_effect;
+		draw.used_texture = render_request.used_texture;
+		draw.used_geometry = render_request.used_geometry;
+		draw.quad = -1;
+		// Later entities of the same geometry may advance the shared quad, so
+		// each draw keeps the quad as it is now
+		const GLuint geometry = (GLuint)render_request.used_geometry;
+		if (sprite_quad_streamed[geometry])
+		{
+			draw.quad = (int)frame.quads.size();
+			frame.quads.push_back(sprite_quads[geometry]);
+		}
+		frame.draws.push_back(draw);
 	}
 
 	mat4 trans = mat4(1.0f);
@@ -844,13 +1169,13 @@ void RenderSystem::draw()
 	honor_trans = glm::scale(honor_trans, vec3(0.5, 0.5, 1));
 	if (gameStarted && !inCutscene && displayHonor) {
 		if (honorGained > 20) {
-			drawText("Honor level: " + std::to_string(honorGained), { 5.f, window_height_px * 2 - 45 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 0.0f, 0.0f), honor_trans);
+			drawCounter("Honor level: ", honorGained, { 5.f, window_height_px * 2 - 45 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 0.0f, 0.0f), honor_trans);
 		}
 		else if (honorGained > 10) {
-			drawText("Honor level: " + std::to_string(honorGained), { 5.f, window_height_px * 2 - 45 }, { 1.25f, 1.25f }, glm::vec3(0.0f, 0.0f, 1.0f), honor_trans);
+			drawCounter("Honor level: ", honorGained, { 5.f, window_height_px * 2 - 45 }, { 1.25f, 1.25f }, glm::vec3(0.0f, 0.0f, 1.0f), honor_trans);
 		}
 		else {
-			drawText("Honor level: " + std::to_string(honorGained), { 5.f, window_height_px * 2 - 45 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 1.0f, 1.0f), honor_trans);
+			drawCounter("Honor level: ", honorGained, { 5.f, window_height_px * 2 - 45 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 1.0f, 1.0f), honor_trans);
 		}
 	}
 
@@ -858,7 +1183,12 @@ void RenderSystem::draw()
 	if (fps_bool) {
 		mat4 fps_trans = mat4(1.0f);
 		fps_trans = glm::scale(fps_trans, vec3(0.5, 0.5, 1));
-		drawText("FPS: " + std::to_string(m_fps), { 5.f, window_height_px * 2 - 90 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 1.0f, 1.0f), fps_trans);
+		drawCounter("FPS: ", m_fps, { 5.f, window_height_px * 2 - 90 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 1.0f, 1.0f), fps_trans);
+		drawCounter("Sprites: ", visible_count, drawable_count, { 5.f, window_height_px * 2 - 135 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 1.0f, 1.0f), fps_trans);
+		// GPU times lag a few frames behind, shown in microseconds
+		drawCounter("GPU sprites (us): ", (int)(gpu_profiler.getPassMs(GPU_PASS::SPRITES) * 1000), { 5.f, window_height_px * 2 - 180 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 1.0f, 1.0f), fps_trans);
+		drawCounter("GPU text (us): ", (int)(gpu_profiler.getPassMs(GPU_PASS::TEXT) * 1000), { 5.f, window_height_px * 2 - 225 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 1.0f, 1.0f), fps_trans);
+		drawCounter("GPU screen (us): ", (int)(gpu_profiler.getPassMs(GPU_PASS::SCREEN) * 1000), { 5.f, window_height_px * 2 - 270 }, { 1.25f, 1.25f }, glm::vec3(1.0f, 1.0f, 1.0f), fps_trans);
 	}
 
 	// Tutorial text
@@ -908,12 +1238,85 @@ void RenderSystem::draw()
 		drawText("Sentinel Golem", { 1170, 260 }, { 1.5f, 1.5f }, glm::vec3(1.0f, 0.851f, 0.4f), trans);
 		drawText(healthBar, { 800, 200 }, { 3.0f, 1.0f }, glm::vec3(1.0f, 0.267f, 0.267f), trans);
 	}
+}
+
+// Submits a snapshot to the GPU, only GL and the snapshot are touched here so
+// it can run on the render thread while the next frame is simulated
+void RenderSystem::renderFrame(const FrameSnapshot& frame)
+{
+	// Uploads bind textures behind the state cache's back
+	if (textures.update())
+		gl_state.texture = (GLuint)-1;
+	gpu_profiler.beginFrame(frame.profile_gpu);
+	gpu_profiler.beginPass(GPU_PASS::SPRITES);
+	// Offscreen there is no backbuffer, everything stays in frame_buffer
+	glBindFramebuffer(GL_FRAMEBUFFER, frame.post_process || window == nullptr ? frame_buffer : 0);
+	gl_has_errors();
+	// Clearing backbuffer
+	glViewport(0, 0, frame.framebuffer_size.x, frame.framebuffer_size.y);
+	glDepthRange(0.00001, 10);
+
+	glClearColor(0.674, 0.847, 0.0 , 1.0);
+	glClearDepth(10.f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	setBlend(true);
+	glDisable(GL_DEPTH_TEST); // native OpenGL does not work with a depth buffer
+							  // and alpha blending, one would have to sort
+							  // sprites back to front
+	gl_has_errors();
+
+	// Only the TEXTURED shader is in world space, upload its view once per frame
+	if (frame.camera_valid)
+	{
+		const GLuint program = effects[(GLuint)EFFECT_ASSET_ID::TEXTURED];
+		useProgram(program);
+		GLint viewMatrixLocation = glGetUniformLocation(program, "viewMatrix");
+		glUniformMatrix4fv(viewMatrixLocation, 1, GL_FALSE, (float*)&frame.camera_view);
+		gl_has_errors();
+	}
+
+	// Every streamed quad of the frame goes into the stream buffer with one map
+	if (!frame.quads.empty())
+	{
+		bindArrayBuffer(sprite_stream.buffer());
+		const size_t offset = sprite_stream.write(frame.quads.data(), sizeof(frame.quads[0]) * frame.quads.size(), sizeof(TexturedVertex));
+		quads_base_vertex = offset / sizeof(TexturedVertex);
+	}
+
+	mat3 projection_2D = createProjectionMatrix();
+	for (size_t i = 0; i < frame.draws.size(); i++)
+	{
+		if (i == frame.first_after_parallax)
+			drawParallax(frame);
+		drawTexturedMesh(frame, frame.draws[i], projection_2D);
+	}
+	if (frame.first_after_parallax == frame.draws.size())
+		drawParallax(frame);
+	drawDebugLines(frame, projection_2D);
+	gpu_profiler.endPass();
+
+	// The GPU may still be reading older partitions, fence this frame's sprites
+	sprite_stream.endFrame();
+
+	// The frame's text, strings new this frame are uploaded together
+	gpu_profiler.beginPass(GPU_PASS::TEXT);
+	for (const TextCommand& text : frame.texts)
+		queueText(text);
+	flushText();
+	gpu_profiler.endPass();
 	
 	// Truely render to the screen
-	drawToScreen();
+	if (frame.post_process && window != nullptr)
+	{
+		gpu_profiler.beginPass(GPU_PASS::SCREEN);
+		drawToScreen(frame);
+		gpu_profiler.endPass();
+	}
+	gpu_profiler.endFrame();
 
 	// flicker-free display with a double buffer
-	glfwSwapBuffers(window);
+	if (window != nullptr)
+		glfwSwapBuffers(window);
 	gl_has_errors();
 }
 
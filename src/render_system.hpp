@@ -1,13 +1,24 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <utility>
 
 #include "common.hpp"
 #include "components.hpp"
+#include "debug_draw.hpp"
+#include "font_atlas.hpp"
+#include "gpu_profiler.hpp"
+#include "stream_buffer.hpp"
+#include "texture_residency.hpp"
 #include "tiny_ecs.hpp"
 #include <glm/gtc/type_ptr.hpp>
 #include <map>
+#include <unordered_map>
 
 // System responsible for setting up OpenGL and for rendering all the
 // visual entities in the game
@@ -19,8 +30,8 @@ class RenderSystem {
 	 * Whenever possible, add to these lists instead of creating dynamic state
 	 * it is easier to debug and faster to execute for the computer.
 	 */
-	std::array<GLuint, texture_count> texture_gl_handles;
-	std::array<ivec2, texture_count> texture_dimensions;
+	// Textures are decoded and uploaded on demand, see texture_residency.hpp
+	TextureResidency textures;
 
 	// Make sure these paths remain in sync with the associated enumerators.
 	// Associated id with .obj path
@@ -91,71 +102,324 @@ class RenderSystem {
 		shader_path("player"),
 		shader_path("textured"),
 		shader_path("texturedfixed"),
-		shader_path("wind")};
+		shader_path("wind"),
+		shader_path("parallax"),
+		shader_path("debug_lines")};
 
 	std::array<GLuint, geometry_count> vertex_buffers;
 	std::array<GLuint, geometry_count> index_buffers;
+	// Number of uint16_t indices in each index buffer, kept on the CPU so the
+	// draw loop never has to query the driver for GL_BUFFER_SIZE
+	std::array<GLsizei, geometry_count> index_counts;
+	// Local space bounds of each geometry, recorded on upload for culling
+	std::array<vec2, geometry_count> geometry_bounds_min;
+	std::array<vec2, geometry_count> geometry_bounds_max;
 	std::array<Mesh, geometry_count> meshes;
 
-	// Map of character fonts
-	std::map<char, Character> m_ftCharacters;
+	// Geometries animated through a sprite sheet keep their current quad on the
+	// CPU and stream it into sprite_stream on every draw instead of
+	// re-specifying their own buffers, all of them share quad_index_buffer
+	std::array<std::array<TexturedVertex, 4>, geometry_count> sprite_quads;
+	std::array<bool, geometry_count> sprite_quad_streamed;
+	StreamBuffer sprite_stream;
+	GLuint quad_index_buffer;
+	// First vertex of the frame's quads in sprite_stream, they are all
+	// written with one map before the sprites are drawn
+	size_t quads_base_vertex;
+
+	// Glyph metrics for the first 128 ASCII chars, indexed by character
+	std::array<Character, 128> m_ftCharacters;
 
 	// Font handles
 	GLuint m_font_shaderProgram;
 	GLuint m_font_VAO;
 	GLuint m_font_VBO;
+	// Every glyph lives in this single GL_RED texture
+	GLuint m_font_atlas;
+	// Placement and color arrays indexed by each vertex's slot, see font.vs.glsl
+	GLint m_font_transforms_loc;
+	GLint m_font_colors_loc;
+
+	// Laid-out strings stay resident in m_font_VBO and are only rebuilt when
+	// their content or size changes, placement and color come from their slot
+	struct TextCacheEntry
+	{
+		std::string text;     // full string, or the label for counters
+		bool is_counter;
+		ivec2 counter_value;  // value and optional total in the digit tail
+		vec2 scale;
+		std::vector<TextVertex> vertices; // CPU copy, re-uploaded when the VBO is compacted
+		GLint first;          // first vertex in m_font_VBO, -1 until uploaded
+		size_t count;         // vertices drawn, a counter's tail is only partly used
+		// Counters: the label is followed by room for the longest value/total,
+		// starting at this vertex and x
+		size_t tail_first;
+		float tail_x;
+		int slot;             // slot written into the vertices, -1 before the first draw
+		// Vertices changed since the upload, rewritten in place before drawing
+		size_t dirty_begin;
+		size_t dirty_end;
+		unsigned int last_used_frame;
+
+		void markDirty(size_t begin, size_t end)
+		{
+			if (dirty_begin >= dirty_end)
+				dirty_begin = begin, dirty_end = end;
+			else
+				dirty_begin = std::min(dirty_begin, begin), dirty_end = std::max(dirty_end, end);
+		}
+	};
+	// Keyed by a hash of the string or counter label and its size, node based so queued
+	// entries stay put while new ones are added. An entry is queued at most
+	// once per frame, the same string twice gets a second entry.
+	std::unordered_multimap<size_t, TextCacheEntry> m_text_cache;
+	// Strings drawn this frame, in draw order
+	struct TextDraw
+	{
+		TextCacheEntry* entry;
+		mat4 transform; // the command's trans with its pos applied
+		vec3 color;
+	};
+	std::vector<TextDraw> m_text_queue;
+	// Vertices of the strings new this frame, uploaded with one call
+	std::vector<TextVertex> m_text_upload;
+	// Scratch layout of a counter's new digits
+	std::vector<TextVertex> m_text_digits;
+	// Uniform arrays and vertex ranges of the strings in one draw
+	std::vector<mat4> m_text_transforms;
+	std::vector<vec3> m_text_colors;
+	std::vector<GLint> m_text_firsts;
+	std::vector<GLsizei> m_text_counts;
+	// Capacity and bump pointer of m_font_VBO in vertices
+	size_t m_text_vbo_capacity;
+	size_t m_text_vbo_used;
+	unsigned int m_text_frame;
 
 public:
-	// Initialize the window
+	// Initialize the window, or render offscreen into the frame buffer when
+	// window is null and a GL context is already current (see headless_context.hpp)
 	bool init(GLFWwindow* window);
+	// Wait for the display refresh on every buffer swap, call while the context
+	// is current on the calling thread, i.e. before startRenderThread
+	void setVSync(bool enabled);
+	ivec2 getFramebufferSize() const;
+	// Reads back the last rendered frame as top-down RGBA
+	void readPixels(std::vector<unsigned char>& rgba, ivec2& size);
 
 	template <class T>
-	void bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices, std::vector<uint16_t> indices);
+	void bindVBOandIBO(GEOMETRY_BUFFER_ID gid, const std::vector<T>& vertices, const std::vector<uint16_t>& indices);
+	// Sets the quad drawn for a streamed sprite sheet geometry
+	void updateSpriteQuad(GEOMETRY_BUFFER_ID gid, const std::array<TexturedVertex, 4>& vertices);
 
 	void initializeGlTextures();
 
 	void initializeGlEffects();
 
-	void initializeGlMeshes();
+	// Parses every OBJ on the thread pool, initializeGlMeshes uploads them
+	std::vector<std::future<bool>> loadMeshes();
+	void initializeGlMeshes(std::vector<std::future<bool>>& mesh_loads);
 	Mesh& getMesh(GEOMETRY_BUFFER_ID id) { return meshes[(int)id]; };
 
-	void initializeGlGeometryBuffers();
+	void initializeGlGeometryBuffers(std::vector<std::future<bool>>& mesh_loads);
 	// Initialize the screen texture used as intermediate render target
 	// The draw loop first renders to this texture, then it is used for the wind
 	// shader
 	bool initScreenTexture();
 	
-	bool initFont(const std::string& font_filename, unsigned int font_default_size);
+	// The CPU side of the font comes from font_atlas.hpp or the asset pack
+	bool initFont(const FontAtlas& atlas);
 
 	// Destroy resources associated to one or all entities created by the system
 	~RenderSystem();
 
-	// Draw all entities
+	// Snapshot the visible entities and HUD into a frame and hand it to the
+	// renderer, call from the main thread once per iteration
 	void draw();
 
-	// Draw text
-	void RenderSystem::drawText(std::string text, vec2 pos, vec2 scale, const vec3& color, const mat4& trans);
+	// Moves GL submission to its own thread, which takes over the context.
+	// Without it draw() renders every frame itself.
+	void startRenderThread();
+	// Renders whatever was submitted, then gives the context back to the caller
+	void stopRenderThread();
+
+	// Queue text for the frame being built, only valid while draw() runs
+	void drawText(const std::string& text, vec2 pos, vec2 scale, const vec3& color, const mat4& trans);
+	// Draws label followed by value, the string is only rebuilt when value changes
+	void drawCounter(const std::string& label, int value, vec2 pos, vec2 scale, const vec3& color, const mat4& trans);
+	void drawCounter(const std::string& label, int value, int total, vec2 pos, vec2 scale, const vec3& color, const mat4& trans);
 
 	mat3 createProjectionMatrix();
 
 	void setFPS(int fps);
+	// Replaces the parallax strips drawn behind the world, empty for none
+	void setParallaxLayers(const std::vector<ParallaxLayer>& layers) { parallax_layers = layers; }
+	const std::vector<ParallaxLayer>& getParallaxLayers() const { return parallax_layers; }
+	// Logs the GPU time of every render pass to a CSV file
+	bool openGpuLog(const std::string& path) { return gpu_profiler.openLog(path); }
+	// Starts streaming in the textures of a state and those of the one after it
+	void setGameState(GameState state) { textures.setState(state); }
+	// VRAM kept for textures before unused ones are evicted, call before startRenderThread
+	void setTextureBudget(size_t bytes) { textures.setBudget(bytes); }
+	// True until every texture of the current state is resident
+	bool texturesLoading() { return textures.loading(); }
 	bool fps_bool;
 	bool help_bool;
 
 private:
+	// One draw resolved from an entity's motion and render request
+	struct DrawCommand
+	{
+		mat3 transform;
+		vec3 color;
+		EFFECT_ASSET_ID used_effect;
+		TEXTURE_ASSET_ID used_texture;
+		GEOMETRY_BUFFER_ID used_geometry;
+		int quad; // index into FrameSnapshot::quads for streamed geometry, -1 otherwise
+	};
+	struct ParallaxCommand
+	{
+		TEXTURE_ASSET_ID texture;
+		vec4 rect;
+		vec2 tile_size;
+		float scroll;
+		bool flip_y;
+	};
+	struct TextCommand
+	{
+		std::string text;     // full string, or the label for counters
+		bool is_counter;
+		ivec2 counter_value;  // value and optional total
+		vec2 pos;
+		vec2 scale;
+		vec3 color;
+		mat4 trans;
+	};
+	// Everything needed to draw one frame. The main thread fills it from the
+	// registry and the renderer only ever reads it, so the two never share
+	// game state.
+	struct FrameSnapshot
+	{
+		ivec2 framebuffer_size;
+		bool camera_valid;
+		mat4 camera_view;
+		std::vector<DrawCommand> draws;  // sorted, in draw order
+		// Parallax strips go in front of draws[0, first_after_parallax)
+		std::vector<ParallaxCommand> parallax;
+		size_t first_after_parallax;
+		std::vector<std::array<TexturedVertex, 4>> quads;
+		std::vector<TextCommand> texts;
+		std::vector<DebugVertex> debug_lines; // pairs, see debug_draw.hpp
+		bool profile_gpu;
+		bool post_process;
+		float darken_screen_factor;
+		float wind_strength;
+		float time;
+	};
+
+	// Main thread side of draw()
+	void buildFrame(FrameSnapshot& frame);
+	void updateSpriteSheet(Entity entity, const RenderRequest& render_request);
+	// GL side of draw(), on the render thread when there is one
+	void renderFrame(const FrameSnapshot& frame);
+
+	// Frame hand off, see render_system_thread.cpp
+	// Waits until the slot to build into is no longer being rendered
+	FrameSnapshot& beginFrame();
+	void submitFrame();
+	void renderLoop();
+
+	// Two snapshots, the main thread builds one while the other is rendered
+	enum class FRAME_STATE { FREE, READY, RENDERING };
+	std::array<FrameSnapshot, 2> frames;
+	std::array<FRAME_STATE, 2> frame_states;
+	int build_slot;
+	bool render_thread_running;
+	std::thread render_thread;
+	std::mutex frame_mutex;
+	std::condition_variable frame_cv;
+
 	// Internal drawing functions for each entity type
-	void drawTexturedMesh(Entity entity, const mat3& projection);
-	void drawToScreen();
-	void resetVAO();
+	void drawTexturedMesh(const FrameSnapshot& frame, const DrawCommand& draw, const mat3& projection);
+	void drawToScreen(const FrameSnapshot& frame);
+	void drawParallax(const FrameSnapshot& frame);
+	void drawDebugLines(const FrameSnapshot& frame, const mat3& projection);
+	// Looks up or lays out the cached string for a text command and queues it
+	void queueText(const TextCommand& command);
+	// Upload and draw all text queued since the last flush
+	void flushText();
+	TextCacheEntry& findText(const std::string& text, bool is_counter, vec2 scale);
+	// Appends the glyph quads of text starting at x, returns the x after the last glyph
+	float layoutText(std::vector<TextVertex>& vertices, const std::string& text, float x, vec2 scale, float slot);
+	// Rewrites a counter's digit tail, only those quads are uploaded again
+	void setCounterValue(TextCacheEntry& entry, ivec2 value);
+	// Drops text that has not been drawn for a while and repacks the rest
+	void compactTextBuffer(size_t needed);
+
+	// Visibility culling, see render_system_culling.cpp
+	// Derives the view matrix and visible world rectangle from the player's camera
+	void updateCamera();
+	// Fills visible_draws with everything that should be drawn this frame,
+	// sorted by layer, effect, texture and geometry
+	void collectVisible();
+	// Stable LSD radix sort of visible_draws by key, one byte per pass
+	void sortVisible();
+	// Conservative world space bounds of an entity, valid for any rotation or mirroring
+	void entityBounds(Entity entity, vec2& out_min, vec2& out_max);
+
+	// Camera shared by every TEXTURED draw this frame
+	bool camera_valid;
+	mat4 camera_view;
+	vec2 camera_min;
+	vec2 camera_max;
+
+	// 64 bit sort key, from the most significant byte down:
+	// layer (4) | effect (4) | texture (8) | geometry (8) | unused (8) | entity id (32)
+	struct DrawItem
+	{
+		uint64_t key;
+		Entity entity;
+	};
+	std::vector<DrawItem> visible_draws;
+	std::vector<DrawItem> sort_scratch;
+	int visible_count;
+	int drawable_count;
+
+	// Thin GL state tracking layer, every bind in the draw loop goes through
+	// these so that redundant state changes never reach the driver.
+	// Only texture unit 0 is ever used, so a single texture slot is tracked.
+	struct GLStateCache
+	{
+		GLuint program;
+		GLuint texture;
+		GLuint array_buffer;
+		GLuint element_buffer;
+		GLuint vertex_array;
+		GLint blend;
+	};
+	GLStateCache gl_state;
+	void invalidateGLState();
+	void useProgram(GLuint program);
+	void bindTexture(GLuint texture);
+	void bindArrayBuffer(GLuint buffer);
+	void bindElementBuffer(GLuint buffer);
+	void bindVertexArray(GLuint vao);
+	void setBlend(bool enabled);
 
 	// Window handle
 	GLFWwindow* window;
 
 	// Dummy VAO
 	GLuint m_vao;
+	// Never has attributes enabled, for draws that generate their vertices
+	GLuint m_empty_vao;
+	// Reads DebugVertex from sprite_stream
+	GLuint m_debug_vao;
+	std::vector<ParallaxLayer> parallax_layers;
 
 	// FPS
 	int m_fps;
+	// Per pass GPU times, shown with the FPS
+	GpuProfiler gpu_profiler;
 
 
 	// Screen texture handles
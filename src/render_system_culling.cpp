@@ -0,0 +1,145 @@
+// internal
+#include "render_system.hpp"
+#include "static_tiles.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "tiny_ecs_registry.hpp"
+
+// stlib
+#include <cmath>
+
+// The state fields share the top 32 bits so the entity id tiebreak keeps all
+// of its bits, ids only grow and pass 16 bits over a play session
+static_assert(render_layer_count <= 16, "render layer does not fit the sort key");
+static_assert(effect_count < 16, "effect does not fit the sort key");
+static_assert(texture_count < 256, "texture does not fit the sort key");
+static_assert(geometry_count < 256, "geometry does not fit the sort key");
+
+static uint64_t sort_key(Entity entity, const RenderRequest& request)
+{
+	return ((uint64_t)request.layer << 60) |
+		((uint64_t)request.used_effect << 56) |
+		((uint64_t)request.used_texture << 48) |
+		((uint64_t)request.used_geometry << 40) |
+		(uint64_t)(unsigned int)entity;
+}
+
+static bool overlaps(vec2 a_min, vec2 a_max, vec2 b_min, vec2 b_max)
+{
+	return a_min.x <= b_max.x && b_min.x <= a_max.x && a_min.y <= b_max.y && b_min.y <= a_max.y;
+}
+
+void RenderSystem::updateCamera()
+{
+	// Without a player the previous camera stays in place
+	if (registry.players.size() == 0)
+		return;
+
+	float x = registry.players.get(registry.players.entities[0]).camera_x;
+	float y = registry.players.get(registry.players.entities[0]).camera_y;
+	glm::vec3 playerPos = glm::vec3(
+		(2.0f * x - window_width_px) / window_width_px, ((window_height_px - y - 400.0f) * 2.0f) / window_height_px,
+		0.0f);
+
+	camera_view = glm::lookAt(
+		playerPos + glm::vec3(0.0f, 0.0f, 1.0f),
+		playerPos,
+		glm::vec3(0.0f, 1.0f, 0.0f)
+	);
+
+	// Undoing the view shift above, the visible world is one window wide
+	// centered on x and ends 400 pixels below y
+	camera_min = { x - window_width_px / 2.f, y + 400.f - window_height_px };
+	camera_max = { x + window_width_px / 2.f, y + 400.f };
+	camera_valid = true;
+}
+
+void RenderSystem::entityBounds(Entity entity, vec2& out_min, vec2& out_max)
+{
+	const Motion& motion = registry.motions.get(entity);
+	const GLuint geometry = (GLuint)registry.renderRequests.get(entity).used_geometry;
+
+	// Furthest the mesh reaches from its origin, mirroring and projectile
+	// rotation are covered by using the radius on both axes
+	vec2 extent = max(abs(geometry_bounds_min[geometry]), abs(geometry_bounds_max[geometry]));
+	float radius = length(extent * abs(motion.scale));
+	out_min = motion.position - vec2(radius);
+	out_max = motion.position + vec2(radius);
+}
+
+void RenderSystem::collectVisible()
+{
+	static_tiles.sync();
+
+	visible_draws.clear();
+	drawable_count = (int)static_tiles.entities.size();
+
+	// Tiles come from the grid cells under the camera
+	auto add_tile = [&](uint32_t t) {
+		Entity tile = static_tiles.entities[t];
+		if (registry.renderRequests.has(tile))
+			visible_draws.push_back({ sort_key(tile, registry.renderRequests.get(tile)), tile });
+	};
+	if (!camera_valid)
+	{
+		for (uint32_t t = 0; t < static_tiles.entities.size(); t++)
+			add_tile(t);
+	}
+	else
+		static_tiles.query(camera_min, camera_max, add_tile);
+
+	// Everything else can move, so it is tested directly
+	for (Entity entity : registry.renderRequests.entities)
+	{
+		if (!registry.motions.has(entity) || registry.tiles.has(entity))
+			continue;
+
+		// do not render attack obj
+		if (registry.player_attack1.has(entity) || registry.player_attack2.has(entity))
+			continue;
+
+		drawable_count++;
+		const RenderRequest& request = registry.renderRequests.get(entity);
+		// Other effects draw in screen space and are always visible
+		if (camera_valid && request.used_effect == EFFECT_ASSET_ID::TEXTURED)
+		{
+			vec2 bounds_min, bounds_max;
+			entityBounds(entity, bounds_min, bounds_max);
+			if (!overlaps(bounds_min, bounds_max, camera_min, camera_max))
+				continue;
+		}
+		visible_draws.push_back({ sort_key(entity, request), entity });
+	}
+	visible_count = (int)visible_draws.size();
+
+	sortVisible();
+}
+
+// Stable LSD radix sort on the 64 bit keys, one byte per pass
+void RenderSystem::sortVisible()
+{
+	std::vector<DrawItem>& items = visible_draws;
+	std::vector<DrawItem>& scratch = sort_scratch;
+	if (items.empty())
+		return;
+	scratch.resize(items.size());
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = { 0 };
+		for (const DrawItem& item : items)
+			counts[(item.key >> shift) & 0xFF]++;
+		// Skip bytes every key shares, most of the high ones do
+		if (counts[(items[0].key >> shift) & 0xFF] == items.size())
+			continue;
+
+		size_t offset = 0;
+		for (size_t& count : counts)
+		{
+			size_t n = count;
+			count = offset;
+			offset += n;
+		}
+		for (const DrawItem& item : items)
+			scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+		items.swap(scratch);
+	}
+}
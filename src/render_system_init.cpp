@@ -1,17 +1,20 @@
 // internal
 #include "render_system.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 
-#include "../ext/stb_image/stb_image.h"
-
 // This creates circular header inclusion, that is quite bad.
 #include "tiny_ecs_registry.hpp"
+#include "asset_pack.hpp"
+#include "mesh_cache.hpp"
+#include "shader_cache.hpp"
+#include "startup_report.hpp"
+#include "thread_pool.hpp"
 
-// fonts
-#include <ft2build.h>
-#include FT_FREETYPE_H
 
 // stlib
 #include <iostream>
@@ -20,15 +23,36 @@
 // World initialization
 bool RenderSystem::init(GLFWwindow* window_arg)
 {
+	StartupTimer timer("renderer", "init");
 	this->window = window_arg;
 
-	glfwMakeContextCurrent(window);
-	glfwSwapInterval(0); // vsync
+	// The font is rasterized and the meshes parsed on the thread pool while
+	// this thread sets up GL and compiles shaders, both are uploaded below
+	const std::string font_filename = data_path() + "/fonts/Kingthings Petrock.ttf";
+	const unsigned int font_default_size = 48;
+	FontAtlas font_atlas;
+	std::future<bool> font_loaded = thread_pool.submit([&font_atlas, font_filename, font_default_size] {
+		return asset_pack.font(font_filename, font_default_size, font_atlas) ||
+			rasterize_font(font_filename, font_default_size, font_atlas);
+	});
+	std::vector<std::future<bool>> mesh_loads = loadMeshes();
+
+	// Without a window the caller has already made an offscreen context current
+	if (window != nullptr)
+	{
+		glfwMakeContextCurrent(window);
+		glfwSwapInterval(0); // vsync
+	}
 
 	// Load OpenGL function pointers
 	const int is_fine = gl3w_init();
 	assert(is_fine == 0);
 
+	// Let the driver report errors through KHR_debug instead of polling glGetError
+	if (gl_enable_debug_output())
+		printf("OpenGL: KHR_debug output enabled\n");
+	invalidateGLState();
+
 	// Create a frame buffer
 	frame_buffer = 0;
 	glGenFramebuffers(1, &frame_buffer);
@@ -37,8 +61,9 @@ bool RenderSystem::init(GLFWwindow* window_arg)
 
 	// For some high DPI displays (ex. Retina Display on Macbooks)
 	// https://stackoverflow.com/questions/36672935/why-retina-screen-coordinate-value-is-twice-the-value-of-pixel-value
-	int frame_buffer_width_px, frame_buffer_height_px;
-	glfwGetFramebufferSize(window, &frame_buffer_width_px, &frame_buffer_height_px);  // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
+	const ivec2 frame_buffer_size = getFramebufferSize();
+	const int frame_buffer_width_px = frame_buffer_size.x;
+	const int frame_buffer_height_px = frame_buffer_size.y;
 	if (frame_buffer_width_px != window_width_px)
 	{
 		printf("WARNING: retina display! https://stackoverflow.com/questions/36672935/why-retina-screen-coordinate-value-is-twice-the-value-of-pixel-value\n");
@@ -46,58 +71,79 @@ bool RenderSystem::init(GLFWwindow* window_arg)
 		printf("window width_height = %d,%d\n", window_width_px, window_height_px);
 	}
 
-
-	// setup fonts
-	std::string font_filename = "..//..//..//data//fonts//Kingthings Petrock.ttf";
-	unsigned int font_default_size = 48;
-	initFont(font_filename, font_default_size);
-
 	m_fps = 0;
-	// Hint: Ask your TA for how to setup pretty OpenGL error callbacks. 
-	// This can not be done in mac os, so do not enable
-	// it unless you are on Linux or Windows. You will need to change the window creation
-	// code to use OpenGL 4.3 (not suported on mac) and add additional .h and .cpp
-	// glDebugMessageCallback((GLDEBUGPROC)errorCallback, nullptr);
+	gpu_profiler.init();
 
 	// We are not really using VAO's but without at least one bound we will crash in
 	// some systems.
 	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
+	glGenVertexArrays(1, &m_empty_vao);
+	bindVertexArray(m_vao);
 	gl_has_errors();
 
 	initScreenTexture();
     initializeGlTextures();
 	initializeGlEffects();
-	initializeGlGeometryBuffers();
+	if (font_loaded.get())
+		initFont(font_atlas);
+	initializeGlGeometryBuffers(mesh_loads);
+
+	// The loaders above bind objects directly, start the draw loop from a known state
+	invalidateGLState();
+	bindVertexArray(m_vao);
+	glActiveTexture(GL_TEXTURE0);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	gl_has_errors();
+
+	// Nothing is culled until a player camera exists, tiles come from static_tiles
+	camera_valid = false;
+	visible_count = 0;
+	drawable_count = 0;
+
+	// Frames are rendered by draw() itself until startRenderThread is called
+	frame_states.fill(FRAME_STATE::FREE);
+	build_slot = 0;
+	render_thread_running = false;
 	
 	return true;
 }
 
-void RenderSystem::initializeGlTextures()
+void RenderSystem::setVSync(bool enabled)
+{
+	assert(!render_thread.joinable());
+	if (window != nullptr)
+		glfwSwapInterval(enabled ? 1 : 0);
+}
+
+ivec2 RenderSystem::getFramebufferSize() const
 {
-    glGenTextures((GLsizei)texture_gl_handles.size(), texture_gl_handles.data());
+	// Offscreen frames are exactly the logical window size
+	if (window == nullptr)
+		return { window_width_px, window_height_px };
+	ivec2 size;
+	glfwGetFramebufferSize(window, &size.x, &size.y); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
+	return size;
+}
 
-    for(uint i = 0; i < texture_paths.size(); i++)
-    {
-		const std::string& path = texture_paths[i];
-		ivec2& dimensions = texture_dimensions[i];
+void RenderSystem::readPixels(std::vector<unsigned char>& rgba, ivec2& size)
+{
+	size = getFramebufferSize();
+	rgba.resize((size_t)size.x * size.y * 4);
+	glBindFramebuffer(GL_FRAMEBUFFER, window == nullptr ? frame_buffer : 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+	gl_has_errors();
 
-		stbi_uc* data;
-		data = stbi_load(path.c_str(), &dimensions.x, &dimensions.y, NULL, 4);
+	// GL rows start at the bottom
+	const size_t row = (size_t)size.x * 4;
+	for (int y = 0; y < size.y / 2; y++)
+		std::swap_ranges(rgba.begin() + y * row, rgba.begin() + (y + 1) * row, rgba.begin() + (size.y - 1 - y) * row);
+}
 
-		if (data == NULL)
-		{
-			const std::string message = "Could not load the file " + path + ".";
-			fprintf(stderr, "%s", message.c_str());
-			assert(false);
-		}
-		glBindTexture(GL_TEXTURE_2D, texture_gl_handles[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dimensions.x, dimensions.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		gl_has_errors();
-		stbi_image_free(data);
-    }
+void RenderSystem::initializeGlTextures()
+{
+	// Nothing is decoded until a state asks for it or a draw misses
+	textures.init(texture_paths);
 	gl_has_errors();
 }
 
@@ -108,37 +154,72 @@ void RenderSystem::initializeGlEffects()
 		const std::string vertex_shader_name = effect_paths[i] + ".vs.glsl";
 		const std::string fragment_shader_name = effect_paths[i] + ".fs.glsl";
 
+		StartupTimer timer("shaders", effect_paths[i]);
 		bool is_valid = loadEffectFromFile(vertex_shader_name, fragment_shader_name, effects[i]);
 		assert(is_valid && (GLuint)effects[i] != 0);
 	}
 }
 
 // One could merge the following two functions as a template function...
+// Position of a vertex in the xy plane, the screen triangle uses bare vec3s
+template <class T>
+static vec2 vertex_xy(const T& vertex) { return vec2(vertex.position); }
+static vec2 vertex_xy(const vec3& vertex) { return vec2(vertex); }
+
 template <class T>
-void RenderSystem::bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices, std::vector<uint16_t> indices)
+void RenderSystem::bindVBOandIBO(GEOMETRY_BUFFER_ID gid, const std::vector<T>& vertices, const std::vector<uint16_t>& indices)
 {
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(uint)gid]);
+	bindArrayBuffer(vertex_buffers[(uint)gid]);
 	glBufferData(GL_ARRAY_BUFFER,
 		sizeof(vertices[0]) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
 	gl_has_errors();
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(uint)gid]);
+	bindElementBuffer(index_buffers[(uint)gid]);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
 		sizeof(indices[0]) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	index_counts[(uint)gid] = (GLsizei)indices.size();
 	gl_has_errors();
+
+	vec2 bounds_min = vec2(0.f);
+	vec2 bounds_max = vec2(0.f);
+	if (!vertices.empty())
+	{
+		bounds_min = bounds_max = vertex_xy(vertices[0]);
+		for (const T& vertex : vertices)
+		{
+			bounds_min = min(bounds_min, vertex_xy(vertex));
+			bounds_max = max(bounds_max, vertex_xy(vertex));
+		}
+	}
+	geometry_bounds_min[(uint)gid] = bounds_min;
+	geometry_bounds_max[(uint)gid] = bounds_max;
 }
 
-void RenderSystem::initializeGlMeshes()
+std::vector<std::future<bool>> RenderSystem::loadMeshes()
 {
+	// Each job only writes its own mesh
+	std::vector<std::future<bool>> mesh_loads;
 	for (uint i = 0; i < mesh_paths.size(); i++)
 	{
-		// Initialize meshes
 		GEOMETRY_BUFFER_ID geom_index = mesh_paths[i].first;
 		std::string name = mesh_paths[i].second;
-		Mesh::loadFromOBJFile(name, 
-			meshes[(int)geom_index].vertices,
-			meshes[(int)geom_index].vertex_indices,
-			meshes[(int)geom_index].original_size);
+		Mesh& mesh = meshes[(int)geom_index];
+		mesh_loads.push_back(thread_pool.submit([&mesh, name] {
+			StartupTimer timer("meshes", name);
+			return asset_pack.mesh(name, mesh) || load_mesh_cached(name, mesh);
+		}));
+	}
+	return mesh_loads;
+}
+
+void RenderSystem::initializeGlMeshes(std::vector<std::future<bool>>& mesh_loads)
+{
+	for (uint i = 0; i < mesh_paths.size(); i++)
+	{
+		// Initialize meshes
+		GEOMETRY_BUFFER_ID geom_index = mesh_paths[i].first;
+		if (!mesh_loads[i].get())
+			continue;
 
 		bindVBOandIBO(geom_index,
 			meshes[(int)geom_index].vertices, 
@@ -146,15 +227,18 @@ void RenderSystem::initializeGlMeshes()
 	}
 }
 
-void RenderSystem::initializeGlGeometryBuffers()
+void RenderSystem::initializeGlGeometryBuffers(std::vector<std::future<bool>>& mesh_loads)
 {
 	// Vertex Buffer creation.
 	glGenBuffers((GLsizei)vertex_buffers.size(), vertex_buffers.data());
 	// Index Buffer creation.
 	glGenBuffers((GLsizei)index_buffers.size(), index_buffers.data());
+	index_counts.fill(0);
+	geometry_bounds_min.fill(vec2(0.f));
+	geometry_bounds_max.fill(vec2(0.f));
 
 	// Index and Vertex buffer data initialization.
-	initializeGlMeshes();
+	initializeGlMeshes(mesh_loads);
 
 	//////////////////////////
 	// Initialize sprite
@@ -172,7 +256,46 @@ void RenderSystem::initializeGlGeometryBuffers()
 	// Counterclockwise as it's the default opengl front winding direction.
 	const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
 	bindVBOandIBO(GEOMETRY_BUFFER_ID::SPRITE, textured_vertices, textured_indices);
-	bindVBOandIBO(GEOMETRY_BUFFER_ID::PLAYER, textured_vertices, textured_indices);
+
+	//////////////////////////
+	// Initialize streamed sprite sheet quads, they all share the sprite indices.
+	// Until their first animation frame they draw nothing, except for the
+	// player which starts out as a plain sprite
+	glGenBuffers(1, &quad_index_buffer);
+	bindElementBuffer(quad_index_buffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * textured_indices.size(), textured_indices.data(), GL_STATIC_DRAW);
+	sprite_stream.init(256 * 1024);
+	quads_base_vertex = 0;
+
+	// Debug lines are streamed through the same buffer and drawn with
+	// glDrawArrays from their offset, so their VAO is set up once
+	glGenVertexArrays(1, &m_debug_vao);
+	bindVertexArray(m_debug_vao);
+	bindArrayBuffer(sprite_stream.buffer());
+	const GLuint debug_program = effects[(GLuint)EFFECT_ASSET_ID::DEBUG_LINES];
+	const GLint debug_position_loc = glGetAttribLocation(debug_program, "in_position");
+	const GLint debug_color_loc = glGetAttribLocation(debug_program, "in_color");
+	glEnableVertexAttribArray(debug_position_loc);
+	glVertexAttribPointer(debug_position_loc, 2, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, position));
+	glEnableVertexAttribArray(debug_color_loc);
+	glVertexAttribPointer(debug_color_loc, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, color));
+	bindVertexArray(m_vao);
+	gl_has_errors();
+
+	const GEOMETRY_BUFFER_ID sprite_sheet_geometries[] = {
+		GEOMETRY_BUFFER_ID::PLAYER, GEOMETRY_BUFFER_ID::PLAYER_HEART, GEOMETRY_BUFFER_ID::PLAYER_SHIELD,
+		GEOMETRY_BUFFER_ID::SKELETON_ENEMY, GEOMETRY_BUFFER_ID::BAT_ENEMY, GEOMETRY_BUFFER_ID::MUSHROOM_ENEMY,
+		GEOMETRY_BUFFER_ID::WIZARD_ENEMY, GEOMETRY_BUFFER_ID::MAGICBALL1, GEOMETRY_BUFFER_ID::MAGICBALL2,
+		GEOMETRY_BUFFER_ID::SAW, GEOMETRY_BUFFER_ID::WOLF_ENEMY, GEOMETRY_BUFFER_ID::GOLEM_ENEMY,
+		GEOMETRY_BUFFER_ID::ARMPROJECTILE_ENEMY, GEOMETRY_BUFFER_ID::ENERGYPROJECTILE_ENEMY, GEOMETRY_BUFFER_ID::DEMON_ENEMY
+	};
+	sprite_quad_streamed.fill(false);
+	sprite_quads.fill({});
+	for (GEOMETRY_BUFFER_ID gid : sprite_sheet_geometries)
+		sprite_quad_streamed[(int)gid] = true;
+	std::array<TexturedVertex, 4> player_quad;
+	std::copy(textured_vertices.begin(), textured_vertices.end(), player_quad.begin());
+	updateSpriteQuad(GEOMETRY_BUFFER_ID::PLAYER, player_quad);
 	////////////////////////
 	// Initialize egg
 	std::vector<ColoredVertex> egg_vertices;
@@ -199,30 +322,6 @@ void RenderSystem::initializeGlGeometryBuffers()
 	meshes[geom_index].vertex_indices = egg_indices;
 	bindVBOandIBO(GEOMETRY_BUFFER_ID::EGG, meshes[geom_index].vertices, meshes[geom_index].vertex_indices);
 
-	//////////////////////////////////
-	// Initialize debug line
-	std::vector<ColoredVertex> line_vertices;
-	std::vector<uint16_t> line_indices;
-
-	constexpr float depth = 0.5f;
-	constexpr vec3 red = { 0.8,0.1,0.1 };
-
-	// Corner points
-	line_vertices = {
-		{{-0.5,-0.5, depth}, red},
-		{{-0.5, 0.5, depth}, red},
-		{{ 0.5, 0.5, depth}, red},
-		{{ 0.5,-0.5, depth}, red},
-	};
-
-	// Two triangles
-	line_indices = {0, 1, 3, 1, 2, 3};
-	
-	geom_index = (int)GEOMETRY_BUFFER_ID::DEBUG_LINE;
-	meshes[geom_index].vertices = line_vertices;
-	meshes[geom_index].vertex_indices = line_indices;
-	bindVBOandIBO(GEOMETRY_BUFFER_ID::DEBUG_LINE, line_vertices, line_indices);
-
 	///////////////////////////////////////////////////////
 	// Initialize screen triangle (yes, triangle, not quad; its more efficient).
 	std::vector<vec3> screen_vertices(3);
@@ -237,24 +336,34 @@ void RenderSystem::initializeGlGeometryBuffers()
 
 RenderSystem::~RenderSystem()
 {
+	// The context has to be back on this thread before anything is deleted
+	stopRenderThread();
+
 	// Don't need to free gl resources since they last for as long as the program,
 	// but it's polite to clean after yourself.
 	glDeleteBuffers((GLsizei)vertex_buffers.size(), vertex_buffers.data());
 	glDeleteBuffers((GLsizei)index_buffers.size(), index_buffers.data());
-	glDeleteTextures((GLsizei)texture_gl_handles.size(), texture_gl_handles.data());
+	glDeleteBuffers(1, &quad_index_buffer);
+	sprite_stream.destroy();
+	gpu_profiler.destroy();
+	textures.destroy();
 	glDeleteTextures(1, &off_screen_render_buffer_color);
 	glDeleteRenderbuffers(1, &off_screen_render_buffer_depth);
 
 	// font
 	glDeleteProgram(m_font_shaderProgram);
 	glDeleteBuffers(1, &m_font_VBO);
-	glDeleteBuffers(1, &m_font_VAO);
+	glDeleteVertexArrays(1, &m_font_VAO);
+	glDeleteTextures(1, &m_font_atlas);
 
 	for(uint i = 0; i < effect_count; i++) {
 		glDeleteProgram(effects[i]);
 	}
 	// delete allocated resources
 	glDeleteFramebuffers(1, &frame_buffer);
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteVertexArrays(1, &m_empty_vao);
+	glDeleteVertexArrays(1, &m_debug_vao);
 	gl_has_errors();
 
 	// remove all entities created by the render system
@@ -267,8 +376,9 @@ bool RenderSystem::initScreenTexture()
 {
 	registry.screenStates.emplace(screen_state_entity);
 
-	int framebuffer_width, framebuffer_height;
-	glfwGetFramebufferSize(const_cast<GLFWwindow*>(window), &framebuffer_width, &framebuffer_height);  // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
+	const ivec2 framebuffer_size = getFramebufferSize();
+	const int framebuffer_width = framebuffer_size.x;
+	const int framebuffer_height = framebuffer_size.y;
 
 	glGenTextures(1, &off_screen_render_buffer_color);
 	glBindTexture(GL_TEXTURE_2D, off_screen_render_buffer_color);
@@ -289,60 +399,21 @@ bool RenderSystem::initScreenTexture()
 	return true;
 }
 
-// Initialize the stuff needed for font
-bool RenderSystem::initFont(const std::string& font_filename, unsigned int font_default_size) 
+// Compiles the font shader and uploads an atlas made by rasterize_font
+bool RenderSystem::initFont(const FontAtlas& atlas)
 {
+	StartupTimer timer("font", "shader and atlas upload");
+
+	// font shader program, cached like the other effects
 	const std::string vs_path = shader_path("font") + ".vs.glsl";
 	const std::string fs_path = shader_path("font") + ".fs.glsl";
-
-	// Opening files
-	std::ifstream vs_is(vs_path);
-	std::ifstream fs_is(fs_path);
-	if (!vs_is.good() || !fs_is.good())
-	{
-		fprintf(stderr, "Failed to load shader files %s, %s", vs_path.c_str(), fs_path.c_str());
-		assert(false);
+	if (!loadEffectFromFile(vs_path, fs_path, m_font_shaderProgram))
 		return false;
-	}
-
-	// Reading sources
-	std::stringstream vs_ss, fs_ss;
-	vs_ss << vs_is.rdbuf();
-	fs_ss << fs_is.rdbuf();
-	std::string vs_str = vs_ss.str();
-	std::string fs_str = fs_ss.str();
-	const char* vs_src = vs_str.c_str();
-	const char* fs_src = fs_str.c_str();
-	GLsizei vs_len = (GLsizei)vs_str.size();
-	GLsizei fs_len = (GLsizei)fs_str.size();
-
 
 	// font buffer setup
 	glGenVertexArrays(1, &m_font_VAO);
 	glGenBuffers(1, &m_font_VBO);
 
-	// font vertex shader
-	unsigned int font_vertexShader;
-	font_vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(font_vertexShader, 1, &vs_src, NULL);
-	glCompileShader(font_vertexShader);
-
-	// font fragement shader
-	unsigned int font_fragmentShader;
-	font_fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(font_fragmentShader, 1, &fs_src, NULL);
-	glCompileShader(font_fragmentShader);
-
-	// font shader program
-	m_font_shaderProgram = glCreateProgram();
-	glAttachShader(m_font_shaderProgram, font_vertexShader);
-	glAttachShader(m_font_shaderProgram, font_fragmentShader);
-	glLinkProgram(m_font_shaderProgram);
-
-	// clean up shaders
-	glDeleteShader(font_vertexShader);
-	glDeleteShader(font_fragmentShader);
-
 	// use our new shader
 	glUseProgram(m_font_shaderProgram);
 
@@ -352,85 +423,40 @@ bool RenderSystem::initFont(const std::string& font_filename, unsigned int font_
 	assert(project_location > -1);
 	std::cout << "project_location: " << project_location << std::endl;
 	glUniformMatrix4fv(project_location, 1, GL_FALSE, glm::value_ptr(projection));
-
-	// init FreeType fonts
-	FT_Library ft;
-	if (FT_Init_FreeType(&ft))
-	{
-		std::cerr << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-		return false;
-	}
-
-	FT_Face face;
-	if (FT_New_Face(ft, font_filename.c_str(), 0, &face))
-	{
-		std::cerr << "ERROR::FREETYPE: Failed to load font: " << font_filename << std::endl;
-		return false;
-	}
-
-	// extract a default size
-	FT_Set_Pixel_Sizes(face, 0, font_default_size);
+	m_font_transforms_loc = glGetUniformLocation(m_font_shaderProgram, "transforms");
+	m_font_colors_loc = glGetUniformLocation(m_font_shaderProgram, "colors");
 
 	// disable byte-alignment restriction in OpenGL
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-	// load each of the chars - note only first 128 ASCII chars
-	for (unsigned char c = 0; c < 128; c++)
-	{
-		// load character glyph 
-		if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-		{
-			std::cerr << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-			continue;
-		}
+	// generate texture
+	glGenTextures(1, &m_font_atlas);
+	glBindTexture(GL_TEXTURE_2D, m_font_atlas);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas.size.x, atlas.size.y, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.pixels.data());
 
-		// generate texture
-		unsigned int texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-
-		// std::cout << "texture: " << c << " = " << texture << std::endl;
-
-		glTexImage2D(
-			GL_TEXTURE_2D,
-			0,
-			GL_RED,
-			face->glyph->bitmap.width,
-			face->glyph->bitmap.rows,
-			0,
-			GL_RED,
-			GL_UNSIGNED_BYTE,
-			face->glyph->bitmap.buffer
-		);
-
-		// set texture options
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// now store character for later use
-		Character character = {
-			texture,
-			glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-			glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-			static_cast<unsigned int>(face->glyph->advance.x),
-			c
-		};
-		m_ftCharacters.insert(std::pair<char, Character>(c, character));
-	}
+	// set texture options
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glBindTexture(GL_TEXTURE_2D, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-	// clean up
-	FT_Done_Face(face);
-	FT_Done_FreeType(ft);
+	m_ftCharacters = atlas.characters;
 
-	// bind buffers
+	// bind buffers, the VBO holds all cached text and grows on demand
+	m_text_vbo_capacity = 4096;
+	m_text_vbo_used = 0;
+	m_text_frame = 0;
 	glBindVertexArray(m_font_VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_font_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(TextVertex) * m_text_vbo_capacity, NULL, GL_DYNAMIC_DRAW);
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, texcoord));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, slot));
 
 	// release buffers
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -488,6 +514,13 @@ bool loadEffectFromFile(
 	GLsizei vs_len = (GLsizei)vs_str.size();
 	GLsizei fs_len = (GLsizei)fs_str.size();
 
+	// A program linked on an earlier launch skips compiling altogether
+	std::string program_name = vs_path.substr(vs_path.find_last_of("/\\") + 1);
+	program_name = program_name.substr(0, program_name.find('.'));
+	const uint64_t cache_key = shader_cache_key(vs_str, fs_str);
+	if (load_cached_program(program_name, cache_key, out_program))
+		return true;
+
 	GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertex, 1, &vs_src, &vs_len);
 	GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
@@ -512,6 +545,7 @@ bool loadEffectFromFile(
 	out_program = glCreateProgram();
 	glAttachShader(out_program, vertex);
 	glAttachShader(out_program, fragment);
+	mark_program_retrievable(out_program);
 	glLinkProgram(out_program);
 	gl_has_errors();
 
@@ -538,6 +572,7 @@ bool loadEffectFromFile(
 	glDetachShader(out_program, fragment);
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
+	save_cached_program(program_name, cache_key, out_program);
 	gl_has_errors();
 
 	return true;
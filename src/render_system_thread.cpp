@@ -0,0 +1,80 @@
+// internal
+#include "render_system.hpp"
+
+// Frame hand off between the main thread, which builds snapshots, and the
+// render thread, which owns the GL context and submits them. Both walk the
+// two slots in the same order, so the renderer is at most one frame behind.
+
+void RenderSystem::startRenderThread()
+{
+	assert(!render_thread.joinable() && window != nullptr);
+	// A context can only be current on one thread at a time
+	glfwMakeContextCurrent(nullptr);
+	render_thread_running = true;
+	render_thread = std::thread(&RenderSystem::renderLoop, this);
+}
+
+void RenderSystem::stopRenderThread()
+{
+	if (!render_thread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(frame_mutex);
+		render_thread_running = false;
+	}
+	frame_cv.notify_all();
+	render_thread.join();
+	glfwMakeContextCurrent(window);
+}
+
+RenderSystem::FrameSnapshot& RenderSystem::beginFrame()
+{
+	if (render_thread.joinable())
+	{
+		std::unique_lock<std::mutex> lock(frame_mutex);
+		frame_cv.wait(lock, [this] { return frame_states[build_slot] == FRAME_STATE::FREE; });
+	}
+	return frames[build_slot];
+}
+
+void RenderSystem::submitFrame()
+{
+	if (!render_thread.joinable())
+	{
+		renderFrame(frames[build_slot]);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(frame_mutex);
+		frame_states[build_slot] = FRAME_STATE::READY;
+	}
+	frame_cv.notify_all();
+	build_slot = 1 - build_slot;
+}
+
+void RenderSystem::renderLoop()
+{
+	glfwMakeContextCurrent(window);
+	int slot = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(frame_mutex);
+			frame_cv.wait(lock, [this, slot] { return frame_states[slot] == FRAME_STATE::READY || !render_thread_running; });
+			// Frames submitted before the stop are still drawn
+			if (frame_states[slot] != FRAME_STATE::READY)
+				break;
+			frame_states[slot] = FRAME_STATE::RENDERING;
+		}
+
+		renderFrame(frames[slot]);
+
+		{
+			std::lock_guard<std::mutex> lock(frame_mutex);
+			frame_states[slot] = FRAME_STATE::FREE;
+		}
+		frame_cv.notify_all();
+		slot = 1 - slot;
+	}
+	glfwMakeContextCurrent(nullptr);
+}
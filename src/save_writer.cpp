@@ -0,0 +1,271 @@
+#include "save_writer.hpp"
+#include "asset_pack.hpp"
+#include "thread_pool.hpp"
+
+// stlib
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// json
+#include <json.hpp>
+using json = nlohmann::json;
+
+static const uint32_t save_magic = 0x5653484E; // "NHSV"
+// Bump whenever SaveRecord changes, older binary saves fall back to the JSON
+static const uint32_t save_version = 1;
+
+// Fixed size fields so the file reads the same on every build
+struct SaveRecord
+{
+	int32_t game_state;
+	int32_t health;
+	int32_t shield;
+	int32_t honorGained;
+	float position_x;
+	float position_y;
+	uint8_t interactable;
+	uint8_t isJumping;
+	uint8_t isFalling;
+	uint8_t touchingWall;
+};
+
+struct SaveHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t checksum;
+};
+
+static std::string save_path(const std::string& name)
+{
+	return std::string(PROJECT_SOURCE_DIR) + name;
+}
+
+static void to_json(json& j, const SaveData& s) {
+	j = json{
+		{ "game_state", s.game_state },
+		{ "health", s.health },
+		{ "shield", s.shield },
+		{ "interactable", s.interactable},
+		{ "position.x", s.position.x },
+		{ "position.y", s.position.y },
+		{ "isJumping", s.isJumping},
+		{ "isFalling", s.isFalling },
+		{ "touchingWall", s.touchingWall },
+		{ "honorGained" , s.honorGained }
+	};
+}
+
+static void from_json(const json& j, SaveData& s) {
+	j.at("game_state").get_to(s.game_state);
+	j.at("health").get_to(s.health);
+	j.at("shield").get_to(s.shield);
+	j.at("interactable").get_to(s.interactable);
+	j.at("position.x").get_to(s.position.x);
+	j.at("position.y").get_to(s.position.y);
+	j.at("isJumping").get_to(s.isJumping);
+	j.at("isFalling").get_to(s.isFalling);
+	j.at("touchingWall").get_to(s.touchingWall);
+	j.at("honorGained").get_to(s.honorGained);
+}
+
+// Temp file, flushed to disk before the rename so the rename never exposes
+// a file whose contents are still in the OS cache
+static bool write_file_atomic(const std::string& path, const void* data, size_t size)
+{
+	const std::string temp_path = path + ".tmp";
+	FILE* file = fopen(temp_path.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+	bool written = fwrite(data, 1, size, file) == size && fflush(file) == 0;
+#ifdef _WIN32
+	written = written && _commit(_fileno(file)) == 0;
+#else
+	written = written && fsync(fileno(file)) == 0;
+#endif
+	written = fclose(file) == 0 && written;
+#ifdef _WIN32
+	// std::rename does not replace an existing file on Windows
+	written = written && MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+	written = written && std::rename(temp_path.c_str(), path.c_str()) == 0;
+#endif
+	if (!written)
+	{
+		fprintf(stderr, "Could not write %s\n", path.c_str());
+		std::remove(temp_path.c_str());
+	}
+	return written;
+}
+
+static void write_json(const SaveData& data)
+{
+	json j;
+	to_json(j, data);
+	std::ostringstream text;
+	text << std::setw(4) << j << std::endl;
+	const std::string out = text.str();
+	write_file_atomic(save_path("game_save.json"), out.data(), out.size());
+}
+
+static void write_binary(const SaveData& data)
+{
+	struct
+	{
+		SaveHeader header;
+		SaveRecord record;
+	} file;
+	memset(&file, 0, sizeof(file));
+	file.record.game_state = (int32_t)data.game_state;
+	file.record.health = data.health;
+	file.record.shield = data.shield;
+	file.record.honorGained = data.honorGained;
+	file.record.position_x = data.position.x;
+	file.record.position_y = data.position.y;
+	file.record.interactable = data.interactable;
+	file.record.isJumping = data.isJumping;
+	file.record.isFalling = data.isFalling;
+	file.record.touchingWall = data.touchingWall;
+	file.header = { save_magic, save_version, fnv1a(&file.record, sizeof(SaveRecord)) };
+	write_file_atomic(save_path("game_save.bin"), &file, sizeof(file));
+}
+
+static bool read_binary(SaveData& out)
+{
+	FILE* file = fopen(save_path("game_save.bin").c_str(), "rb");
+	if (file == nullptr)
+		return false;
+	SaveHeader header;
+	SaveRecord record;
+	const bool read = fread(&header, sizeof(header), 1, file) == 1 && fread(&record, sizeof(record), 1, file) == 1;
+	fclose(file);
+	if (!read || header.magic != save_magic || header.version != save_version ||
+		header.checksum != fnv1a(&record, sizeof(record)) || record.game_state < Intro || record.game_state > CutScene)
+	{
+		fprintf(stderr, "game_save.bin is damaged or outdated, loading game_save.json\n");
+		return false;
+	}
+	out.game_state = (GameState)record.game_state;
+	out.health = record.health;
+	out.shield = record.shield;
+	out.honorGained = record.honorGained;
+	out.position = { record.position_x, record.position_y };
+	out.interactable = record.interactable != 0;
+	out.isJumping = record.isJumping != 0;
+	out.isFalling = record.isFalling != 0;
+	out.touchingWall = record.touchingWall != 0;
+	return true;
+}
+
+static bool read_json(SaveData& out)
+{
+	std::ifstream file(save_path("game_save.json"));
+	if (file.fail())
+		return false;
+	try {
+		from_json(json::parse(file), out);
+	}
+	catch (const json::exception& e) {
+		fprintf(stderr, "game_save.json is damaged: %s\n", e.what());
+		return false;
+	}
+	return true;
+}
+
+void SaveWriter::write(const SaveData& data)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	pending = data;
+	has_pending = true;
+	if (!writing)
+	{
+		writing = true;
+		job = thread_pool.submit([this] { drain(); });
+	}
+}
+
+void SaveWriter::writeSnapshot(const std::string& name, const std::vector<unsigned char>& bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	pending_snapshots[name] = bytes;
+	if (!writing)
+	{
+		writing = true;
+		job = thread_pool.submit([this] { drain(); });
+	}
+}
+
+void SaveWriter::drain()
+{
+	for (;;)
+	{
+		SaveData data;
+		bool save;
+		bool with_binary;
+		std::map<std::string, std::vector<unsigned char>> snapshots;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!has_pending && pending_snapshots.empty())
+			{
+				writing = false;
+				return;
+			}
+			data = pending;
+			save = has_pending;
+			has_pending = false;
+			with_binary = binary;
+			snapshots.swap(pending_snapshots);
+		}
+		if (save)
+		{
+			write_json(data);
+			if (with_binary)
+				write_binary(data);
+			else
+				// A binary save left from an earlier run would be loaded instead of this one
+				std::remove(save_path("game_save.bin").c_str());
+		}
+		for (auto& snapshot : snapshots)
+			write_file_atomic(save_path(snapshot.first), snapshot.second.data(), snapshot.second.size());
+	}
+}
+
+void SaveWriter::flush()
+{
+	std::future<void> running;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = std::move(job);
+	}
+	if (running.valid())
+		running.wait();
+}
+
+bool SaveWriter::read(SaveData& out)
+{
+	return read_binary(out) || read_json(out);
+}
+
+bool SaveWriter::readSnapshot(const std::string& name, std::vector<unsigned char>& out)
+{
+	FILE* file = fopen(save_path(name).c_str(), "rb");
+	if (file == nullptr)
+		return false;
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	out.resize(size > 0 ? (size_t)size : 0);
+	const bool read = size > 0 && fread(out.data(), 1, out.size(), file) == out.size();
+	fclose(file);
+	return read;
+}
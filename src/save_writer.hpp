@@ -0,0 +1,64 @@
+#pragma once
+
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+// Everything a save holds, copied out of the registry on the main thread
+struct SaveData
+{
+	GameState game_state = LevelOne;
+	int health = 0;
+	int shield = 0;
+	bool interactable = false;
+	vec2 position = { 0.f, 0.f };
+	bool isJumping = false;
+	bool isFalling = false;
+	bool touchingWall = false;
+	int honorGained = 0;
+};
+
+// Writes saves on the thread pool so a level transition never waits on the
+// disk. Each file is written aside, flushed to disk and renamed over the old
+// one, a crash mid-write leaves the previous save intact. Saves requested
+// while one is being written collapse into the latest.
+//
+// game_save.json is always written. With binary saves on, game_save.bin is
+// written next to it and preferred when loading, it is checksummed and read
+// without any parsing.
+//
+// World snapshots go through the same path, one file per name, the latest
+// bytes for a name win.
+class SaveWriter
+{
+public:
+	// Main thread, off by default, --binary-save in main.cpp
+	void setBinary(bool enabled) { std::lock_guard<std::mutex> lock(mutex); binary = enabled; }
+	// Main thread, returns as soon as data is copied
+	void write(const SaveData& data);
+	// Main thread, bytes from SnapshotWriter::finish, name is a file next to the saves
+	void writeSnapshot(const std::string& name, const std::vector<unsigned char>& bytes);
+	// Waits for the save being written, call before reading saves or exiting
+	void flush();
+
+	// Reads the binary save if there is a valid one, else the JSON, false if neither
+	static bool read(SaveData& out);
+	// False if there is no snapshot called name
+	static bool readSnapshot(const std::string& name, std::vector<unsigned char>& out);
+
+private:
+	void drain();
+
+	bool binary = false;
+	std::mutex mutex;
+	SaveData pending;
+	bool has_pending = false;
+	std::map<std::string, std::vector<unsigned char>> pending_snapshots;
+	// A job is draining pending, only one at a time so files are never written twice at once
+	bool writing = false;
+	std::future<void> job;
+};
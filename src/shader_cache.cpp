@@ -0,0 +1,128 @@
+#include "shader_cache.hpp"
+#include "asset_pack.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static const uint32_t cache_magic = 0x4350484E; // "NHPC"
+
+struct CacheHeader
+{
+	uint32_t magic;
+	uint32_t format; // binary format reported by the driver
+	uint64_t key;
+	uint64_t size;
+};
+
+// Queried once, the process only ever makes one kind of context
+static bool program_binaries_supported()
+{
+	static int formats = -1;
+	if (formats < 0)
+	{
+		formats = 0;
+		if (glGetProgramBinary != nullptr && glProgramBinary != nullptr && glProgramParameteri != nullptr)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	}
+	return formats > 0;
+}
+
+static bool format_accepted(GLenum format)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+	std::vector<GLint> formats(count);
+	if (count > 0)
+		glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+	return std::find(formats.begin(), formats.end(), (GLint)format) != formats.end();
+}
+
+static std::string program_cache_path(const std::string& name)
+{
+	return cache_path(name + ".program");
+}
+
+uint64_t shader_cache_key(const std::string& vs_src, const std::string& fs_src)
+{
+	std::string text;
+	for (GLenum string : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		const GLubyte* value = glGetString(string);
+		text += value != nullptr ? (const char*)value : "";
+		text += '\0';
+	}
+	text += vs_src;
+	text += '\0';
+	text += fs_src;
+	return fnv1a(text.data(), text.size());
+}
+
+bool load_cached_program(const std::string& name, uint64_t key, GLuint& out_program)
+{
+	if (!program_binaries_supported())
+		return false;
+
+	FILE* file = fopen(program_cache_path(name).c_str(), "rb");
+	if (file == nullptr)
+		return false;
+	CacheHeader header;
+	std::vector<char> binary;
+	bool read = fread(&header, sizeof(header), 1, file) == 1 && header.magic == cache_magic &&
+		header.key == key && header.size > 0 && header.size < (1u << 26);
+	if (read)
+	{
+		binary.resize((size_t)header.size);
+		read = fread(binary.data(), 1, binary.size(), file) == binary.size();
+	}
+	fclose(file);
+	if (!read || !format_accepted(header.format))
+		return false;
+
+	// The driver may still reject a binary it wrote, then it is compiled as usual
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+	GLint is_linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &is_linked);
+	if (is_linked == GL_FALSE)
+	{
+		glDeleteProgram(program);
+		return false;
+	}
+	out_program = program;
+	return true;
+}
+
+void mark_program_retrievable(GLuint program)
+{
+	if (program_binaries_supported())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void save_cached_program(const std::string& name, uint64_t key, GLuint program)
+{
+	if (!program_binaries_supported() || !make_cache_dir())
+		return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	// Written aside and renamed, a crash mid write never leaves a truncated binary
+	const std::string path = program_cache_path(name);
+	const std::string temp_path = path + ".tmp";
+	FILE* file = fopen(temp_path.c_str(), "wb");
+	if (file == nullptr)
+		return;
+	CacheHeader header = { cache_magic, format, key, (uint64_t)length };
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(binary.data(), 1, (size_t)length, file) == (size_t)length;
+	written = fclose(file) == 0 && written;
+	std::remove(path.c_str());
+	if (!written || std::rename(temp_path.c_str(), path.c_str()) != 0)
+		std::remove(temp_path.c_str());
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common.hpp"
+
+// Linked shader programs saved with glGetProgramBinary under data/cache/.
+// Each file is keyed by a hash of both shader sources and the GL vendor,
+// renderer and version strings, so editing a shader or updating the driver
+// simply misses and the program is compiled from source again. Contexts
+// without ARB_get_program_binary, or with no binary formats, always miss.
+// All of these run on the GL thread.
+
+// Key for a program built from these sources on this driver
+uint64_t shader_cache_key(const std::string& vs_src, const std::string& fs_src);
+
+// A linked program if name was cached with the same key
+bool load_cached_program(const std::string& name, uint64_t key, GLuint& out_program);
+// Call before linking a program that will be saved
+void mark_program_retrievable(GLuint program);
+// Writes a linked program for the next launch
+void save_cached_program(const std::string& name, uint64_t key, GLuint program);
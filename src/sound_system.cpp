@@ -0,0 +1,129 @@
+#include "sound_system.hpp"
+#include "asset_pack.hpp"
+#include "startup_report.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdio>
+
+struct SoundInfo
+{
+	const char* file;
+	int priority;      // higher takes over the voices of lower
+	float cooldown_ms; // least time between two starts
+};
+
+static const SoundInfo sound_infos[sound_count] = {
+	{ "player_death.wav", 3, 500.f },
+	{ "player_heal.wav", 2, 100.f },
+	{ "player_buff.wav", 2, 100.f },
+	{ "player_jump.wav", 0, 0.f },
+	{ "player_roll.wav", 0, 0.f },
+	{ "player_take_damage.wav", 2, 100.f },
+	{ "enemy_take_damage.wav", 1, 80.f },
+	{ "potion_disappear.wav", 1, 100.f },
+	{ "next_area.wav", 2, 250.f },
+	{ "boss_death.wav", 3, 500.f }
+};
+
+static_assert(sound_count <= 32, "pending requests are one bit per sound");
+
+void SoundSystem::load()
+{
+	Mix_AllocateChannels(voice_count);
+
+	// Cooked PCM is played straight from the pack if it matches the device
+	ivec3 device_spec;
+	Uint16 device_format;
+	Mix_QuerySpec(&device_spec.x, &device_format, &device_spec.z);
+	device_spec.y = device_format;
+
+	for (int i = 0; i < sound_count; i++)
+	{
+		const std::string path = audio_path(sound_infos[i].file);
+		const std::string name = sound_infos[i].file;
+		loads[i] = thread_pool.submit([path, name, device_spec] {
+			StartupTimer timer("audio", name);
+			const unsigned char* pcm;
+			size_t size;
+			ivec3 spec;
+			if (asset_pack.sound(path, pcm, size, spec) && spec == device_spec)
+				return Mix_QuickLoad_RAW((Uint8*)pcm, (Uint32)size);
+			return Mix_LoadWAV(path.c_str());
+		});
+	}
+	// Long ago, so nothing starts out cooling down
+	since_played.fill(1e9f);
+	// Only read once every voice is busy, by then each has played something
+	voice_sounds.fill(SOUND_ID::PLAYER_JUMP);
+}
+
+bool SoundSystem::finishLoading()
+{
+	bool loaded = true;
+	for (int i = 0; i < sound_count; i++)
+	{
+		if (!loads[i].valid())
+			continue;
+		chunks[i] = loads[i].get();
+		if (chunks[i] == nullptr)
+		{
+			fprintf(stderr, "Failed to load sound %s, make sure the data directory is present\n", audio_path(sound_infos[i].file).c_str());
+			loaded = false;
+		}
+	}
+	return loaded;
+}
+
+void SoundSystem::destroy()
+{
+	finishLoading();
+	Mix_HaltChannel(-1);
+	for (Mix_Chunk*& chunk : chunks)
+	{
+		if (chunk != nullptr)
+			Mix_FreeChunk(chunk);
+		chunk = nullptr;
+	}
+}
+
+void SoundSystem::update(float elapsed_ms)
+{
+	for (float& since : since_played)
+		since += elapsed_ms;
+
+	uint32_t requested = pending.exchange(0, std::memory_order_relaxed);
+	while (requested != 0)
+	{
+		// Highest priority first, so the important sounds get the free voices
+		int id = -1;
+		for (int i = 0; i < sound_count; i++)
+			if ((requested & (1u << i)) && (id < 0 || sound_infos[i].priority > sound_infos[id].priority))
+				id = i;
+		requested &= ~(1u << id);
+
+		const SoundInfo& info = sound_infos[id];
+		if (chunks[id] == nullptr || since_played[id] < info.cooldown_ms)
+			continue;
+
+		// A free voice, or else the lowest priority busy one if it is below this sound
+		int voice = -1;
+		for (int v = 0; v < voice_count && voice < 0; v++)
+			if (!Mix_Playing(v))
+				voice = v;
+		if (voice < 0)
+		{
+			int lowest = 0;
+			for (int v = 1; v < voice_count; v++)
+				if (sound_infos[(int)voice_sounds[v]].priority < sound_infos[(int)voice_sounds[lowest]].priority)
+					lowest = v;
+			if (sound_infos[(int)voice_sounds[lowest]].priority < info.priority)
+				voice = lowest;
+		}
+		if (voice < 0)
+			continue;
+
+		Mix_PlayChannel(voice, chunks[id], 0);
+		voice_sounds[voice] = (SOUND_ID)id;
+		since_played[id] = 0.f;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <string>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include "common.hpp"
+
+enum class SOUND_ID {
+	PLAYER_DEATH = 0,
+	PLAYER_HEAL = PLAYER_DEATH + 1,
+	PLAYER_BUFF = PLAYER_HEAL + 1,
+	PLAYER_JUMP = PLAYER_BUFF + 1,
+	PLAYER_ROLL = PLAYER_JUMP + 1,
+	PLAYER_TAKE_DAMAGE = PLAYER_ROLL + 1,
+	ENEMY_TAKE_DAMAGE = PLAYER_TAKE_DAMAGE + 1,
+	POTION_DISAPPEAR = ENEMY_TAKE_DAMAGE + 1,
+	NEXT_AREA = POTION_DISAPPEAR + 1,
+	BOSS_DEATH = NEXT_AREA + 1,
+	SOUND_COUNT = BOSS_DEATH + 1
+};
+const int sound_count = (int)SOUND_ID::SOUND_COUNT;
+
+// Sound effects. Gameplay code only calls play(), which sets a bit and
+// returns, and update() turns the bits set since the last step into mixer
+// voices: a sound requested several times in one step plays once, a sound
+// still inside its cooldown is dropped, and once every voice is busy a new
+// sound takes over the voice of a lower priority one or is dropped. Per
+// sound priorities and cooldowns are in sound_system.cpp.
+class SoundSystem
+{
+public:
+	// Mixer channels used for effects, music streams separately
+	static const int voice_count = 8;
+
+	// Starts decoding every effect on the thread pool, call once the mixer is open
+	void load();
+	// Waits for load(), false if any effect is missing
+	bool finishLoading();
+	// Frees the effects, call before Mix_CloseAudio
+	void destroy();
+
+	// Any thread, constant time and lock free
+	void play(SOUND_ID id) { pending.fetch_or(1u << (int)id, std::memory_order_relaxed); }
+	// Main thread, once per step
+	void update(float elapsed_ms);
+
+private:
+	std::atomic<uint32_t> pending{ 0 };
+	std::array<Mix_Chunk*, sound_count> chunks = {};
+	std::array<std::future<Mix_Chunk*>, sound_count> loads;
+	// Time since each sound last started, for its cooldown
+	std::array<float, sound_count> since_played = {};
+	// Last sound started on each voice, to pick one to take over
+	std::array<SOUND_ID, voice_count> voice_sounds;
+};
@@ -0,0 +1,75 @@
+// internal
+#include "startup_report.hpp"
+
+// stlib
+#include <algorithm>
+#include <cstdio>
+
+StartupReport startup_report;
+
+static float ms_between(StartupReport::Clock::time_point from, StartupReport::Clock::time_point to)
+{
+	return (float)(std::chrono::duration_cast<std::chrono::microseconds>(to - from)).count() / 1000;
+}
+
+void StartupReport::begin()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	begin_time = Clock::now();
+	main_thread = std::this_thread::get_id();
+	open = true;
+}
+
+void StartupReport::finish()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	total_ms = ms_between(begin_time, Clock::now());
+	open = false;
+}
+
+void StartupReport::add(const char* phase, const std::string& name, Clock::time_point start, Clock::time_point end)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!open)
+		return;
+	entries.push_back({ phase, name, ms_between(begin_time, start), ms_between(begin_time, end),
+		std::this_thread::get_id() == main_thread });
+}
+
+void StartupReport::print()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	printf("Startup report: %.1fms to the first complete frame\n", total_ms);
+
+	// Phases in the order they started, each with its wall time and the work
+	// its assets added up to, which is larger when they ran in parallel
+	std::vector<std::string> phases;
+	for (const Entry& entry : entries)
+		if (std::find(phases.begin(), phases.end(), entry.phase) == phases.end())
+			phases.push_back(entry.phase);
+	for (const std::string& phase : phases)
+	{
+		float first = total_ms;
+		float last = 0.f;
+		float work = 0.f;
+		int count = 0;
+		for (const Entry& entry : entries)
+		{
+			if (entry.phase != phase)
+				continue;
+			first = std::min(first, entry.start_ms);
+			last = std::max(last, entry.end_ms);
+			work += entry.end_ms - entry.start_ms;
+			count++;
+		}
+		printf("  %-10s %8.1fms wall  %8.1fms work  %3d item(s)\n", phase.c_str(), last - first, work, count);
+		for (const Entry& entry : entries)
+		{
+			if (entry.phase != phase)
+				continue;
+			printf("      %-36s %8.1fms  at %7.1fms  %s\n", entry.name.c_str(), entry.end_ms - entry.start_ms,
+				entry.start_ms, entry.main_thread ? "main" : "worker");
+		}
+	}
+}
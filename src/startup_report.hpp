@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Wall clock time of every startup phase and of each asset loaded during it,
+// collected from any thread and printed with --startup-report
+class StartupReport
+{
+public:
+	using Clock = std::chrono::high_resolution_clock;
+
+	void begin();
+	// Entries recorded after finish are dropped, assets keep loading in game
+	void finish();
+	bool isOpen() const { return open; }
+	void add(const char* phase, const std::string& name, Clock::time_point start, Clock::time_point end);
+	void print();
+
+private:
+	struct Entry
+	{
+		std::string phase;
+		std::string name;
+		float start_ms;
+		float end_ms;
+		bool main_thread;
+	};
+	std::vector<Entry> entries;
+	Clock::time_point begin_time;
+	float total_ms = 0.f;
+	std::thread::id main_thread;
+	std::atomic<bool> open{ false };
+	std::mutex mutex;
+};
+
+extern StartupReport startup_report;
+
+// Times its own scope into startup_report
+class StartupTimer
+{
+public:
+	StartupTimer(const char* phase, const std::string& name)
+		: phase(phase), name(name), start(StartupReport::Clock::now()) {}
+	~StartupTimer() { startup_report.add(phase, name, start, StartupReport::Clock::now()); }
+
+private:
+	const char* phase;
+	std::string name;
+	StartupReport::Clock::time_point start;
+};
@@ -0,0 +1,63 @@
+// internal
+#include "static_grid.hpp"
+
+// stlib
+#include <cfloat>
+#include <cmath>
+
+void StaticGrid::build(const std::vector<vec2>& mins, const std::vector<vec2>& maxs, float size)
+{
+	cell_size = size;
+	cell_start.clear();
+	items.clear();
+	dims = { 0, 0 };
+	if (mins.empty())
+		return;
+
+	vec2 grid_min = vec2(FLT_MAX);
+	vec2 grid_max = vec2(-FLT_MAX);
+	for (size_t i = 0; i < mins.size(); i++)
+	{
+		grid_min = min(grid_min, mins[i]);
+		grid_max = max(grid_max, maxs[i]);
+	}
+	origin = grid_min;
+	dims = ivec2(floor((grid_max - grid_min) / cell_size)) + ivec2(1);
+
+	// Counted first so every cell's list lands in one array without reallocating
+	std::vector<uint32_t> counts(dims.x * dims.y + 1, 0);
+	for (size_t i = 0; i < mins.size(); i++)
+	{
+		ivec2 first, last;
+		cellRange(mins[i], maxs[i], first, last);
+		for (int cy = first.y; cy <= last.y; cy++)
+			for (int cx = first.x; cx <= last.x; cx++)
+				counts[cy * dims.x + cx + 1]++;
+	}
+	for (size_t c = 1; c < counts.size(); c++)
+		counts[c] += counts[c - 1];
+	cell_start = counts;
+	items.resize(cell_start.back());
+	for (size_t i = 0; i < mins.size(); i++)
+	{
+		ivec2 first, last;
+		cellRange(mins[i], maxs[i], first, last);
+		for (int cy = first.y; cy <= last.y; cy++)
+			for (int cx = first.x; cx <= last.x; cx++)
+				items[counts[cy * dims.x + cx]++] = (uint32_t)i;
+	}
+}
+
+void StaticGrid::cellRange(vec2 min_bound, vec2 max_bound, ivec2& first, ivec2& last) const
+{
+	first = max(ivec2(floor((min_bound - origin) / cell_size)), ivec2(0));
+	last = min(ivec2(floor((max_bound - origin) / cell_size)), dims - ivec2(1));
+}
+
+void static_tile_bounds(vec2 position, vec2 scale, vec2& out_min, vec2& out_max)
+{
+	// Sprite geometry spans -0.5 to 0.5, see RenderSystem::entityBounds
+	float radius = length(0.5f * abs(scale));
+	out_min = position - vec2(radius);
+	out_max = position + vec2(radius);
+}
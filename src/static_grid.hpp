@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common.hpp"
+
+// Size of a grid cell in world pixels, about a third of the screen
+const float STATIC_CELL_SIZE = 400.f;
+
+// Uniform grid over boxes that never move. Each cell lists the boxes touching
+// it, all cells share one array so a grid is written to and read from a
+// cooked level as is.
+struct StaticGrid
+{
+	vec2 origin = { 0.f, 0.f };
+	float cell_size = 0.f;
+	ivec2 dims = { 0, 0 };
+	// Boxes in cell c are items[cell_start[c]] up to items[cell_start[c + 1]]
+	std::vector<uint32_t> cell_start;
+	std::vector<uint32_t> items;
+
+	void build(const std::vector<vec2>& mins, const std::vector<vec2>& maxs, float cell_size);
+	// Cells covering [min, max] clamped to the grid, first > last if none do
+	void cellRange(vec2 min, vec2 max, ivec2& first, ivec2& last) const;
+	bool empty() const { return items.empty(); }
+};
+
+// Conservative bounds of a tile, the same box the renderer culls unit sprites
+// with so one grid serves both culling and collision
+void static_tile_bounds(vec2 position, vec2 scale, vec2& out_min, vec2& out_max);
@@ -0,0 +1,47 @@
+// internal
+#include "static_tiles.hpp"
+#include "tiny_ecs_registry.hpp"
+
+StaticTiles static_tiles;
+
+void StaticTiles::remember()
+{
+	tile_generation = registry.tiles.generation;
+	dirty = false;
+	stamps.assign(entities.size(), 0);
+	stamp = 0;
+}
+
+void StaticTiles::sync()
+{
+	if (!dirty && registry.tiles.generation == tile_generation)
+		return;
+
+	std::vector<Entity>& tiles = registry.tiles.entities;
+
+	entities.clear();
+	mins.clear();
+	maxs.clear();
+	for (Entity entity : tiles)
+	{
+		if (!registry.motions.has(entity))
+			continue;
+		const Motion& motion = registry.motions.get(entity);
+		vec2 bounds_min, bounds_max;
+		static_tile_bounds(motion.position, motion.scale, bounds_min, bounds_max);
+		entities.push_back(entity);
+		mins.push_back(bounds_min);
+		maxs.push_back(bounds_max);
+	}
+	grid.build(mins, maxs, STATIC_CELL_SIZE);
+	remember();
+}
+
+void StaticTiles::adopt(const std::vector<Entity>& tiles, const std::vector<vec2>& tile_mins, const std::vector<vec2>& tile_maxs, const StaticGrid& cooked)
+{
+	entities = tiles;
+	mins = tile_mins;
+	maxs = tile_maxs;
+	grid = cooked;
+	remember();
+}
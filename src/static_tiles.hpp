@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "common.hpp"
+#include "static_grid.hpp"
+
+// Bounds and grid of registry.tiles, shared by the physics broad phase and
+// the renderer's culling. A level loaded from a level file hands over the
+// grid its cooker built. Anything else that changes the tiles, a restored
+// snapshot or tiles made by hand, is picked up by sync() and binned again.
+class StaticTiles
+{
+public:
+	// Rebuilds if registry.tiles changed since the last build or adopt
+	void sync();
+	// Makes the next sync rebuild, for tiles moved in place without touching
+	// registry.tiles itself
+	void invalidate() { dirty = true; }
+	// Takes a cooked grid over tiles, which must be registry.tiles in order.
+	// Marks the current registry.tiles generation as indexed.
+	void adopt(const std::vector<Entity>& tiles, const std::vector<vec2>& mins, const std::vector<vec2>& maxs, const StaticGrid& cooked);
+
+	// Calls visit(i) once for every tile i whose bounds overlap [min, max]
+	template <class F>
+	void query(vec2 min_bound, vec2 max_bound, F visit)
+	{
+		if (grid.empty())
+			return;
+		// Tiles spanning several cells are only tested once per query
+		if (++stamp == 0)
+		{
+			std::fill(stamps.begin(), stamps.end(), 0);
+			stamp = 1;
+		}
+		ivec2 first, last;
+		grid.cellRange(min_bound, max_bound, first, last);
+		for (int cy = first.y; cy <= last.y; cy++)
+		{
+			for (int cx = first.x; cx <= last.x; cx++)
+			{
+				const int cell = cy * grid.dims.x + cx;
+				for (uint32_t c = grid.cell_start[cell]; c < grid.cell_start[cell + 1]; c++)
+				{
+					const uint32_t i = grid.items[c];
+					if (stamps[i] == stamp)
+						continue;
+					stamps[i] = stamp;
+					if (mins[i].x <= max_bound.x && min_bound.x <= maxs[i].x && mins[i].y <= max_bound.y && min_bound.y <= maxs[i].y)
+						visit(i);
+				}
+			}
+		}
+	}
+
+	std::vector<Entity> entities;
+	std::vector<vec2> mins;
+	std::vector<vec2> maxs;
+
+private:
+	void remember();
+
+	StaticGrid grid;
+	std::vector<unsigned int> stamps;
+	unsigned int stamp = 0;
+	// registry.tiles generation the grid was built or adopted for
+	unsigned int tile_generation = 0;
+	bool dirty = true;
+};
+
+extern StaticTiles static_tiles;
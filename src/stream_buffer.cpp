@@ -0,0 +1,86 @@
+#include "stream_buffer.hpp"
+
+#include <cstring>
+
+void StreamBuffer::init(size_t partition_size_bytes)
+{
+	partition_size = partition_size_bytes;
+	partition = 0;
+	head = 0;
+	fences.fill(nullptr);
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, partition_size * frames_in_flight, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	gl_has_errors();
+}
+
+void StreamBuffer::destroy()
+{
+	for (GLsync& fence : fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+	glDeleteBuffers(1, &vbo);
+	vbo = 0;
+}
+
+size_t StreamBuffer::write(const void* data, size_t size, size_t alignment)
+{
+	size_t offset = (head + alignment - 1) / alignment * alignment;
+	if (offset + size > (partition + 1) * partition_size)
+	{
+		// A write larger than a whole partition grows every partition, the
+		// buffer is reallocated below anyway
+		while (size + alignment > partition_size)
+			partition_size *= 2;
+
+		// This frame outgrew its partition, orphan the whole buffer so the
+		// driver hands us fresh storage and start the partition over. Draws
+		// already issued keep reading the old storage.
+		glBufferData(GL_ARRAY_BUFFER, partition_size * frames_in_flight, nullptr, GL_STREAM_DRAW);
+		for (GLsync& fence : fences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+			fence = nullptr;
+		}
+		const size_t partition_start = partition * partition_size;
+		offset = (partition_start + alignment - 1) / alignment * alignment;
+	}
+
+	void* dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (dst != nullptr)
+	{
+		memcpy(dst, data, size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	gl_has_errors();
+
+	head = offset + size;
+	return offset;
+}
+
+void StreamBuffer::endFrame()
+{
+	if (fences[partition])
+		glDeleteSync(fences[partition]);
+	fences[partition] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	partition = (partition + 1) % frames_in_flight;
+	head = partition * partition_size;
+
+	// Usually long signaled, the GPU is at most a couple of frames behind
+	GLsync& fence = fences[partition];
+	if (fence)
+	{
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+
+#include "common.hpp"
+
+// Vertex buffer for data that changes every frame. The storage is
+// split into one partition per frame in flight, writes go through
+// unsynchronized glMapBufferRange and a fence per partition makes sure the
+// GPU is done with it before it is written again, so steady state streaming
+// never reallocates or implicitly syncs. A write that does not fit a whole
+// partition grows the partitions once.
+class StreamBuffer
+{
+public:
+	static const int frames_in_flight = 3;
+
+	void init(size_t partition_size);
+	void destroy();
+
+	GLuint buffer() const { return vbo; }
+
+	// Copies size bytes into the current partition and returns their byte
+	// offset, a multiple of alignment. The buffer must be bound to GL_ARRAY_BUFFER.
+	size_t write(const void* data, size_t size, size_t alignment);
+
+	// Fences the current partition and moves on to the next one, waiting if
+	// the GPU is still reading it
+	void endFrame();
+
+private:
+	GLuint vbo = 0;
+	size_t partition_size = 0;
+	int partition = 0;
+	size_t head = 0;
+	std::array<GLsync, frames_in_flight> fences = {};
+};
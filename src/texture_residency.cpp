@@ -0,0 +1,372 @@
+// internal
+#include "texture_residency.hpp"
+#include "asset_pack.hpp"
+#include "startup_report.hpp"
+#include "thread_pool.hpp"
+
+#include "../ext/stb_image/stb_image.h"
+
+// stlib
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+// Make sure these lists remain in sync with what each state creates in world_system.cpp
+static void state_textures(GameState state, std::vector<TEXTURE_ASSET_ID>& out)
+{
+	switch (state) {
+	case Intro:
+		out = { TEXTURE_ASSET_ID::INTRO };
+		return;
+	case FirstCutscene:
+		out = { TEXTURE_ASSET_ID::CUTSCENE1A, TEXTURE_ASSET_ID::CUTSCENE1B, TEXTURE_ASSET_ID::CUTSCENE1C,
+			TEXTURE_ASSET_ID::CUTSCENE1D, TEXTURE_ASSET_ID::CUTSCENE1E };
+		return;
+	case SecondCutscene:
+		out = { TEXTURE_ASSET_ID::CUTSCENE2A, TEXTURE_ASSET_ID::CUTSCENE2B, TEXTURE_ASSET_ID::CUTSCENE2C };
+		return;
+	case ThirdCutscene:
+		out = { TEXTURE_ASSET_ID::CUTSCENE3A, TEXTURE_ASSET_ID::CUTSCENE3B, TEXTURE_ASSET_ID::CUTSCENE3C,
+			TEXTURE_ASSET_ID::CUTSCENE3D };
+		return;
+	case Complete:
+		out = { TEXTURE_ASSET_ID::COMPLETE };
+		return;
+	case GameOver:
+		out = { TEXTURE_ASSET_ID::GAMEOVER };
+		return;
+	default:
+		break;
+	}
+
+	// Every level has the player, the HUD, tiles, the parallax strips,
+	// potions and ghosts
+	out = { TEXTURE_ASSET_ID::PLAYER_SHEET, TEXTURE_ASSET_ID::HEART_SHEET, TEXTURE_ASSET_ID::SHIELD_SHEET,
+		TEXTURE_ASSET_ID::TILE, TEXTURE_ASSET_ID::TILE_VERT, TEXTURE_ASSET_ID::TILE_VERT_LONG,
+		TEXTURE_ASSET_ID::BACKGROUND_CLOUD, TEXTURE_ASSET_ID::BACKGROUND_TREE,
+		TEXTURE_ASSET_ID::STATUS_EFFECT, TEXTURE_ASSET_ID::GHOST };
+	switch (state) {
+	case Tutorial:
+		out.insert(out.end(), { TEXTURE_ASSET_ID::BACKGROUND, TEXTURE_ASSET_ID::DOOR, TEXTURE_ASSET_ID::STATUE });
+		break;
+	case LevelOne:
+		out.insert(out.end(), { TEXTURE_ASSET_ID::BACKGROUND2, TEXTURE_ASSET_ID::DOOR, TEXTURE_ASSET_ID::STATUE,
+			TEXTURE_ASSET_ID::BAT, TEXTURE_ASSET_ID::SKELETON_IDLE, TEXTURE_ASSET_ID::MUSHROOM,
+			TEXTURE_ASSET_ID::FIREBALL, TEXTURE_ASSET_ID::WOLF });
+		break;
+	case LevelTwo:
+		out.insert(out.end(), { TEXTURE_ASSET_ID::BACKGROUND3, TEXTURE_ASSET_ID::DOOR, TEXTURE_ASSET_ID::BAT,
+			TEXTURE_ASSET_ID::SKELETON_IDLE, TEXTURE_ASSET_ID::MUSHROOM, TEXTURE_ASSET_ID::FIREBALL,
+			TEXTURE_ASSET_ID::WOLF, TEXTURE_ASSET_ID::DEMON, TEXTURE_ASSET_ID::SAW, TEXTURE_ASSET_ID::WIZARD,
+			TEXTURE_ASSET_ID::MAGICBALL1, TEXTURE_ASSET_ID::MAGICBALL2, TEXTURE_ASSET_ID::TILE_VERT_LONG_THICK });
+		break;
+	case BuffRoom:
+		out.insert(out.end(), { TEXTURE_ASSET_ID::BACKGROUND, TEXTURE_ASSET_ID::DOOR, TEXTURE_ASSET_ID::STATUE,
+			TEXTURE_ASSET_ID::PEDESTAL, TEXTURE_ASSET_ID::ATTACK_BUFF, TEXTURE_ASSET_ID::DEFENSE_BUFF });
+		break;
+	case LevelThree:
+		out.insert(out.end(), { TEXTURE_ASSET_ID::BACKGROUND3, TEXTURE_ASSET_ID::GOLEM,
+			TEXTURE_ASSET_ID::ARMPROJECTILE, TEXTURE_ASSET_ID::ENERGYPROJECTILE });
+		break;
+	default:
+		break;
+	}
+}
+
+// The state usually entered after this one, restarting goes back to the first cutscene
+static GameState next_state(GameState state)
+{
+	switch (state) {
+	case Intro: return FirstCutscene;
+	case FirstCutscene: return Tutorial;
+	case Tutorial: return LevelOne;
+	case LevelOne: return SecondCutscene;
+	case SecondCutscene: return LevelTwo;
+	case LevelTwo: return ThirdCutscene;
+	case ThirdCutscene: return BuffRoom;
+	case BuffRoom: return LevelThree;
+	case LevelThree: return Complete;
+	default: return FirstCutscene;
+	}
+}
+
+static bool is_level(GameState state)
+{
+	return state == Tutorial || state == LevelOne || state == LevelTwo || state == BuffRoom || state == LevelThree;
+}
+
+void TextureResidency::init(const std::array<std::string, texture_count>& paths)
+{
+	texture_paths = paths;
+	status.fill(STATUS::UNLOADED);
+	wanted.fill(WANTED::NONE);
+	pixels.fill(nullptr);
+	pixels_mapped.fill(false);
+	dimensions.fill({ 0, 0 });
+	gl_handles.fill(0);
+	resident.fill(false);
+	uploaded_rows.fill(0);
+	last_used.fill(0);
+	resident_bytes = 0;
+	frame = 0;
+	stopping = false;
+
+	// Late textures draw as nothing rather than flashing a debug colour
+	const unsigned char transparent[4] = { 0, 0, 0, 0 };
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_2D, placeholder);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, transparent);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	gl_has_errors();
+}
+
+void TextureResidency::destroy()
+{
+	{
+		// Jobs still in the pool hold on to this object
+		std::unique_lock<std::mutex> lock(mutex);
+		stopping = true;
+		decode_cv.wait(lock, [this] { return decode_jobs == 0; });
+	}
+
+	for (int i = 0; i < texture_count; i++)
+	{
+		if (pixels[i] != nullptr && !pixels_mapped[i])
+			stbi_image_free((void*)pixels[i]);
+		pixels[i] = nullptr;
+		if (gl_handles[i] != 0)
+			glDeleteTextures(1, &gl_handles[i]);
+		gl_handles[i] = 0;
+		resident[i] = false;
+	}
+	glDeleteTextures(1, &placeholder);
+	placeholder = 0;
+	resident_bytes = 0;
+	gl_has_errors();
+}
+
+void TextureResidency::setState(GameState new_state)
+{
+	std::vector<TEXTURE_ASSET_ID> now_list;
+	std::vector<TEXTURE_ASSET_ID> next_list;
+	state_textures(new_state, now_list);
+	// Game over is left by restarting the level it interrupted
+	state_textures(new_state == GameOver ? state : next_state(new_state), next_list);
+	if (is_level(new_state))
+		next_list.push_back(TEXTURE_ASSET_ID::GAMEOVER);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (new_state != GameOver)
+			state = new_state;
+
+		wanted.fill(WANTED::NONE);
+		for (TEXTURE_ASSET_ID id : next_list)
+			wanted[(int)id] = WANTED::NEXT;
+		for (TEXTURE_ASSET_ID id : now_list)
+			wanted[(int)id] = WANTED::NOW;
+
+		// Requeue from scratch, what the current state needs goes first
+		decode_queue.clear();
+		for (int i = 0; i < texture_count; i++)
+			if (status[i] == STATUS::QUEUED)
+				status[i] = STATUS::UNLOADED;
+		for (TEXTURE_ASSET_ID id : now_list)
+			queue((int)id, false);
+		for (TEXTURE_ASSET_ID id : next_list)
+			queue((int)id, false);
+	}
+}
+
+bool TextureResidency::loading()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (int i = 0; i < texture_count; i++)
+		if (wanted[i] == WANTED::NOW && status[i] != STATUS::RESIDENT && status[i] != STATUS::FAILED)
+			return true;
+	return false;
+}
+
+// Must hold mutex
+void TextureResidency::queue(int i, bool front)
+{
+	if (status[i] != STATUS::UNLOADED && status[i] != STATUS::QUEUED)
+		return;
+	// A texture already queued further back is skipped when reached again
+	status[i] = STATUS::QUEUED;
+	if (front)
+		decode_queue.push_front(i);
+	else
+		decode_queue.push_back(i);
+	decode_jobs++;
+	thread_pool.submit([this] { decodeNext(); });
+}
+
+GLuint TextureResidency::miss(int i)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// Already on its way
+		if (wanted[i] == WANTED::NOW && status[i] != STATUS::UNLOADED)
+			return placeholder;
+		// Whatever is being drawn is needed now, even if no list has it
+		wanted[i] = WANTED::NOW;
+		queue(i, true);
+	}
+	return placeholder;
+}
+
+void TextureResidency::decodeNext()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	// Entries queued twice are skipped, a state change may also have cleared
+	// the queue or other jobs drained it
+	while (!decode_queue.empty() && status[decode_queue.front()] != STATUS::QUEUED)
+		decode_queue.pop_front();
+	if (stopping || decode_queue.empty())
+	{
+		decode_jobs--;
+		decode_cv.notify_all();
+		return;
+	}
+
+	const int i = decode_queue.front();
+	decode_queue.pop_front();
+	status[i] = STATUS::DECODING;
+
+	// texture_paths never changes after init
+	lock.unlock();
+	// Cooked textures are uploaded straight from the pack
+	ivec2 size;
+	const unsigned char* data = nullptr;
+	const bool mapped = asset_pack.texture(texture_paths[i], data, size);
+	if (!mapped)
+	{
+		StartupTimer timer("textures", texture_paths[i]);
+		data = stbi_load(texture_paths[i].c_str(), &size.x, &size.y, NULL, 4);
+	}
+	if (data == NULL)
+	{
+		const std::string message = "Could not load the file " + texture_paths[i] + ".";
+		fprintf(stderr, "%s", message.c_str());
+	}
+	lock.lock();
+
+	if (data == NULL)
+		status[i] = STATUS::FAILED;
+	else
+	{
+		pixels[i] = data;
+		pixels_mapped[i] = mapped;
+		dimensions[i] = size;
+		status[i] = STATUS::DECODED;
+	}
+	decode_jobs--;
+	decode_cv.notify_all();
+}
+
+bool TextureResidency::update()
+{
+	frame++;
+
+	std::array<STATUS, texture_count> current_status;
+	std::array<WANTED, texture_count> current_wanted;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current_status = status;
+		current_wanted = wanted;
+	}
+
+	// The current state's textures are uploaded whole, prefetched ones share a
+	// fixed number of bytes per frame so a state change never hitches
+	bool touched = false;
+	for (int i = 0; i < texture_count; i++)
+	{
+		if (current_status[i] == STATUS::DECODED && current_wanted[i] == WANTED::NOW)
+		{
+			upload(i, SIZE_MAX);
+			touched = true;
+		}
+	}
+	size_t upload_budget = upload_bytes_per_frame;
+	for (int i = 0; i < texture_count && upload_budget > 0; i++)
+	{
+		if (current_status[i] == STATUS::DECODED && current_wanted[i] != WANTED::NOW)
+		{
+			upload_budget -= std::min(upload_budget, upload(i, upload_budget));
+			touched = true;
+		}
+	}
+
+	// Over budget, drop the least recently used textures nothing wants.
+	// Anything drawn in the last few frames stays to avoid reloading it.
+	while (resident_bytes > budget_bytes)
+	{
+		int oldest = -1;
+		for (int i = 0; i < texture_count; i++)
+		{
+			if (!resident[i] || current_wanted[i] != WANTED::NONE || last_used[i] + 3 > frame)
+				continue;
+			if (oldest < 0 || last_used[i] < last_used[oldest])
+				oldest = i;
+		}
+		if (oldest < 0)
+			break;
+		evict(oldest);
+		touched = true;
+	}
+	gl_has_errors();
+	return touched;
+}
+
+size_t TextureResidency::upload(int i, size_t max_bytes)
+{
+	const ivec2 size = dimensions[i];
+	const size_t row_bytes = (size_t)size.x * 4;
+	if (gl_handles[i] == 0)
+	{
+		glGenTextures(1, &gl_handles[i]);
+		glBindTexture(GL_TEXTURE_2D, gl_handles[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		// Parallax layers tile their texture horizontally
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		uploaded_rows[i] = 0;
+		resident_bytes += row_bytes * size.y;
+	}
+	else
+		glBindTexture(GL_TEXTURE_2D, gl_handles[i]);
+
+	// At least one row per call so large textures always make progress
+	const size_t fit = std::max<size_t>(1, max_bytes / row_bytes);
+	const int rows = (int)std::min<size_t>(size.y - uploaded_rows[i], fit);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, uploaded_rows[i], size.x, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+		pixels[i] + uploaded_rows[i] * row_bytes);
+	uploaded_rows[i] += rows;
+
+	if (uploaded_rows[i] == size.y)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!pixels_mapped[i])
+			stbi_image_free((void*)pixels[i]);
+		pixels[i] = nullptr;
+		status[i] = STATUS::RESIDENT;
+		resident[i] = true;
+		last_used[i] = frame;
+	}
+	return rows * row_bytes;
+}
+
+void TextureResidency::evict(int i)
+{
+	glDeleteTextures(1, &gl_handles[i]);
+	gl_handles[i] = 0;
+	resident[i] = false;
+	resident_bytes -= (size_t)dimensions[i].x * dimensions[i].y * 4;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	status[i] = STATUS::UNLOADED;
+}
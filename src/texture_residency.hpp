@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "components.hpp"
+
+// Keeps only the textures the game is about to draw on the GPU. Every
+// GameState has a list of the textures it uses, see texture_residency.cpp.
+// Entering a state queues its own textures and those of the state that
+// usually follows it for decoding on the thread pool, decoded pixels are
+// uploaded a slice per frame and textures no state wants any more are evicted
+// least recently used first once the VRAM budget is exceeded. A texture drawn
+// before it is resident shows a transparent placeholder for a few frames.
+class TextureResidency
+{
+public:
+	// Pixel bytes uploaded per frame for textures that are only prefetched,
+	// those of the current state are uploaded whole as soon as they decode
+	static const size_t upload_bytes_per_frame = 1024 * 1024;
+	static const size_t default_budget_bytes = 96 * 1024 * 1024;
+
+	// GL thread
+	void init(const std::array<std::string, texture_count>& paths);
+	void destroy();
+	// Read by update(), call before the render thread starts
+	void setBudget(size_t bytes) { budget_bytes = bytes; }
+
+	// Any thread, makes state the one drawn from now on
+	void setState(GameState state);
+	// True while a texture the current state needs is not resident yet
+	bool loading();
+
+	// GL thread, once per frame before drawing. Returns true if it changed
+	// the texture binding.
+	bool update();
+	// GL thread, the texture or the placeholder if it is not resident. A miss
+	// queues the texture ahead of everything else.
+	GLuint handle(TEXTURE_ASSET_ID id)
+	{
+		const int i = (int)id;
+		if (!resident[i])
+			return miss(i);
+		last_used[i] = frame;
+		return gl_handles[i];
+	}
+
+private:
+	enum class STATUS { UNLOADED, QUEUED, DECODING, DECODED, RESIDENT, FAILED };
+	enum class WANTED { NONE, NEXT, NOW };
+
+	GLuint miss(int i);
+	void queue(int i, bool front);
+	// One pool job per queued texture, each decodes whatever is at the front
+	void decodeNext();
+	// Uploads up to max_bytes of a decoded texture, returns the bytes uploaded
+	size_t upload(int i, size_t max_bytes);
+	void evict(int i);
+
+	std::array<std::string, texture_count> texture_paths;
+	size_t budget_bytes = default_budget_bytes;
+
+	// Shared with the decode thread, guarded by mutex
+	std::array<STATUS, texture_count> status;
+	std::array<WANTED, texture_count> wanted;
+	std::array<const unsigned char*, texture_count> pixels;
+	std::array<bool, texture_count> pixels_mapped; // point into the asset pack, never freed
+	std::array<ivec2, texture_count> dimensions;
+	std::deque<int> decode_queue;
+	GameState state = Intro;
+	bool stopping = false;
+	int decode_jobs = 0; // submitted and not finished
+	std::mutex mutex;
+	std::condition_variable decode_cv;
+
+	// GL thread only
+	std::array<GLuint, texture_count> gl_handles;
+	std::array<bool, texture_count> resident;
+	std::array<int, texture_count> uploaded_rows; // of a texture still being uploaded
+	std::array<unsigned int, texture_count> last_used;
+	size_t resident_bytes = 0;
+	unsigned int frame = 0;
+	GLuint placeholder = 0;
+};
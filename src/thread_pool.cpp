@@ -0,0 +1,44 @@
+// internal
+#include "thread_pool.hpp"
+
+ThreadPool thread_pool;
+
+void ThreadPool::start(unsigned int thread_count)
+{
+	if (thread_count == 0)
+	{
+		const unsigned int cores = std::thread::hardware_concurrency();
+		thread_count = cores > 4 ? cores - 2 : 2;
+	}
+	stopping = false;
+	for (unsigned int i = 0; i < thread_count; i++)
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+void ThreadPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	cv.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+	workers.clear();
+}
+
+void ThreadPool::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+		if (jobs.empty())
+			return;
+		std::function<void()> job = std::move(jobs.front());
+		jobs.pop_front();
+		lock.unlock();
+		job();
+		lock.lock();
+	}
+}
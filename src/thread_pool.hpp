@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for CPU work that does not touch GL or the
+// registry: decoding, parsing and file IO. Jobs run in submission order.
+class ThreadPool
+{
+public:
+	// One worker per core beyond the main and render threads, at least two
+	void start(unsigned int thread_count = 0);
+	// Finishes the queued jobs and joins the workers
+	void stop();
+	~ThreadPool() { stop(); }
+
+	unsigned int size() const { return (unsigned int)workers.size(); }
+
+	// Queues job, its result or exception is delivered through the future.
+	// Dropping the future does not wait for the job.
+	template <class F>
+	std::future<decltype(std::declval<F>()())> submit(F job)
+	{
+		using Result = decltype(job());
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::move(job));
+		std::future<Result> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back([task] { (*task)(); });
+		}
+		cv.notify_one();
+		return result;
+	}
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool stopping = false;
+};
+
+// Shared by every system, started at the top of main
+extern ThreadPool thread_pool;
@@ -20,6 +20,14 @@ public:
 		// Note, indices of already deleted entities arent re-used in this simple implementation.
 	}
 	operator unsigned int() { return id; } // this enables automatic casting to int
+
+	// World snapshots restore entities under their saved ids
+	static Entity fromId(unsigned int id) { return Entity(id, true); }
+	static unsigned int nextId() { return id_count; }
+	// Ids below next are never handed out again
+	static void reserveIds(unsigned int next) { id_count = std::max(id_count, next); }
+private:
+	Entity(unsigned int id, bool) : id(id) {}
 };
 
 // Common interface to refer to all containers in the ECS registry
@@ -46,6 +54,10 @@ public:
 	// The corresponding entities
 	std::vector<Entity> entities;
 
+	// Bumped whenever entities are added, removed or reordered, so anything
+	// indexing the container can tell when to rebuild
+	unsigned int generation = 0;
+
 	// Constructor that registers the type
 	ComponentContainer()
 	{
@@ -60,6 +72,7 @@ public:
 		map_entity_componentID[e] = (unsigned int)components.size();
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 		entities.push_back(e);
+		generation++;
 		return components.back();
 	};
 
@@ -102,16 +115,46 @@ public:
 			map_entity_componentID.erase(e);
 			components.pop_back();
 			entities.pop_back();
+			generation++;
 			// Note, one could mark the id for re-use
 		}
 	};
 
+	// Replaces every component at once, the entities must be unique
+	void assign(std::vector<Entity>&& new_entities, std::vector<Component>&& new_components)
+	{
+		assert(new_entities.size() == new_components.size());
+		map_entity_componentID.clear();
+		map_entity_componentID.reserve(new_entities.size());
+		for (unsigned int i = 0; i < new_entities.size(); i++)
+			map_entity_componentID[new_entities[i]] = i;
+		entities = std::move(new_entities);
+		components = std::move(new_components);
+		generation++;
+	}
+
+	// Appends count components at once, e.g. a block of entities created together
+	void append(const Entity* new_entities, const Component* new_components, size_t count)
+	{
+		map_entity_componentID.reserve(entities.size() + count);
+		for (size_t i = 0; i < count; i++)
+		{
+			Entity e = new_entities[i];
+			assert(!has(e) && "Entity already contained in ECS registry");
+			map_entity_componentID[e] = (unsigned int)(entities.size() + i);
+		}
+		entities.insert(entities.end(), new_entities, new_entities + count);
+		components.insert(components.end(), new_components, new_components + count);
+		generation++;
+	}
+
 	// Remove all components of type 'Component'
 	void clear()
 	{
 		map_entity_componentID.clear();
 		components.clear();
 		entities.clear();
+		generation++;
 	}
 
 	// Report the number of components of type 'Component'
@@ -133,5 +176,6 @@ public:
 		// Fill the new hashmap
 		for (unsigned int i = 0; i < entities.size(); i++)
 			map_entity_componentID[entities[i]] = i;
+		generation++;
 	}
 };
@@ -21,7 +21,6 @@ public:
 	ComponentContainer<ScreenState> screenStates;
 	ComponentContainer<Eatable> eatables;
 	ComponentContainer<Deadly> deadlys;
-	ComponentContainer<DebugComponent> debugComponents;
 	ComponentContainer<vec3> colors;
 	ComponentContainer<Background> background;
 	ComponentContainer<Tile> tiles;
@@ -68,7 +67,6 @@ public:
 		registry_list.push_back(&screenStates);
 		registry_list.push_back(&eatables);
 		registry_list.push_back(&deadlys);
-		registry_list.push_back(&debugComponents);
 		registry_list.push_back(&colors);
 		registry_list.push_back(&background);
 		registry_list.push_back(&tiles);
@@ -107,6 +105,13 @@ public:
 			reg->clear();
 	}
 
+	// Empties every container but keep, whose entities live across levels
+	void clear_all_components_except(const ContainerInterface& keep) {
+		for (ContainerInterface* reg : registry_list)
+			if (reg != &keep)
+				reg->clear();
+	}
+
 	void list_all_components() {
 		printf("Debug info on all registry entries:\n");
 		for (ContainerInterface* reg : registry_list)
@@ -25,7 +25,8 @@ Entity createPlayer(RenderSystem* renderer, vec2 pos, int health)
 		entity,
 		{ TEXTURE_ASSET_ID::PLAYER_SHEET, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::PLAYER });
+			GEOMETRY_BUFFER_ID::PLAYER,
+			RENDER_LAYER::ACTORS });
 
 	registry.players.get(entity).camera_x = registry.motions.get(entity).position.x;
 	registry.players.get(entity).camera_y = registry.motions.get(entity).position.y;
@@ -49,7 +50,8 @@ Entity createIntro(RenderSystem* renderer, vec2 pos) {
 		entity,
 		{ TEXTURE_ASSET_ID::INTRO, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTUREDFIXED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::BACKGROUND });
 
 	return entity;
 }
@@ -71,7 +73,8 @@ Entity createScene(RenderSystem* renderer, vec2 pos, TEXTURE_ASSET_ID id) {
 		entity,
 		{ id, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTUREDFIXED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::BACKGROUND });
 
 	return entity;
 }
@@ -104,53 +107,33 @@ Entity createBackground(RenderSystem* renderer, vec2 pos, int background_id)
 		entity,
 		{ bg_id, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTUREDFIXED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::BACKGROUND });
 
 	return entity;
 }
 
-Entity createBackgroundCloud(RenderSystem* renderer, vec2 pos)
+void createParallaxBackground(RenderSystem* renderer)
 {
-	auto entity = Entity();
-	// Setting initial motion values
-	Motion& motion = registry.motions.emplace(entity);
-	motion.interactable = false;
-	motion.position = pos;
-	motion.angle = 0.f;
-	motion.velocity = { 0.f, 0.f };
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({ 576.f, -324.f });
-	// Create and (empty) Chicken component to be able to refer to all eagles
-	registry.background.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{ TEXTURE_ASSET_ID::BACKGROUND_CLOUD, // TEXTURE_COUNT indicates that no txture is needed
-			EFFECT_ASSET_ID::TEXTUREDFIXED,
-			GEOMETRY_BUFFER_ID::SPRITE });
-
-	return entity;
-}
-
-Entity createBackgroundTrees(RenderSystem* renderer, vec2 pos)
-{
-	auto entity = Entity();
-	// Setting initial motion values
-	Motion& motion = registry.motions.emplace(entity);
-	motion.interactable = false;
-	motion.position = pos;
-	motion.angle = 0.f;
-	motion.velocity = { 0.f, 0.f };
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({ 800.f, 600.f });
-	// Create and (empty) Chicken component to be able to refer to all eagles
-	registry.background.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{ TEXTURE_ASSET_ID::BACKGROUND_TREE, // TEXTURE_COUNT indicates that no txture is needed
-			EFFECT_ASSET_ID::TEXTUREDFIXED,
-			GEOMETRY_BUFFER_ID::SPRITE });
-
-	return entity;
+	// Clouds fill the top of the screen, their texture is stored upside down
+	ParallaxLayer clouds;
+	clouds.texture = TEXTURE_ASSET_ID::BACKGROUND_CLOUD;
+	clouds.screen_pos = { 0.f, 0.f };
+	clouds.screen_size = { (float)window_width_px, 324.f };
+	clouds.tile_size = { 576.f, 324.f };
+	clouds.speed_factor = 4.f;
+	clouds.flip_y = true;
+
+	// Trees line the bottom and move a bit faster
+	ParallaxLayer trees;
+	trees.texture = TEXTURE_ASSET_ID::BACKGROUND_TREE;
+	trees.screen_pos = { 0.f, window_height_px - 600.f };
+	trees.screen_size = { (float)window_width_px, 600.f };
+	trees.tile_size = { 800.f, 600.f };
+	trees.speed_factor = 2.5f;
+	trees.flip_y = false;
+
+	renderer->setParallaxLayers({ clouds, trees });
 }
 
 Entity createAttack1(RenderSystem* renderer, vec2 pos)
@@ -175,7 +158,8 @@ Entity createAttack1(RenderSystem* renderer, vec2 pos)
 		entity,
 		{ TEXTURE_ASSET_ID::TEXTURE_COUNT, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::PLAYER,
-			GEOMETRY_BUFFER_ID::PLAYER_ATTACK1 });
+			GEOMETRY_BUFFER_ID::PLAYER_ATTACK1,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -202,7 +186,8 @@ Entity createAttack2(RenderSystem* renderer, vec2 pos)
 		entity,
 		{ TEXTURE_ASSET_ID::TEXTURE_COUNT, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::PLAYER,
-			GEOMETRY_BUFFER_ID::PLAYER_ATTACK2 });
+			GEOMETRY_BUFFER_ID::PLAYER_ATTACK2,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -225,7 +210,8 @@ Entity createTile(RenderSystem* renderer, vec2 pos)
 		entity,
 		{ TEXTURE_ASSET_ID::TILE, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::STATIC });
 
 	return entity;
 }
@@ -249,7 +235,8 @@ Entity createCustomTile(RenderSystem* renderer, vec2 pos, vec2 scale)
 		entity,
 		{ TEXTURE_ASSET_ID::TILE, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::STATIC });
 
 	return entity;
 }
@@ -272,7 +259,8 @@ Entity createVerticalTile(RenderSystem* renderer, vec2 pos, vec2 scale)
 		entity,
 		{ TEXTURE_ASSET_ID::TILE_VERT, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::STATIC });
 
 	return entity;
 }
@@ -295,7 +283,8 @@ Entity createVerticalLongTile(RenderSystem* renderer, vec2 pos, vec2 scale)
 		entity,
 		{ TEXTURE_ASSET_ID::TILE_VERT_LONG, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::STATIC });
 
 	return entity;
 }
@@ -318,7 +307,8 @@ Entity createVerticalLongThickTile(RenderSystem* renderer, vec2 pos, vec2 scale)
 		entity,
 		{ TEXTURE_ASSET_ID::TILE_VERT_LONG, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::STATIC });
 
 	return entity;
 }
@@ -341,7 +331,8 @@ Entity createDoor(RenderSystem* renderer, vec2 pos, vec2 scale)
 		entity,
 		{ TEXTURE_ASSET_ID::DOOR, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::STATIC });
 
 	return entity;
 }
@@ -364,7 +355,8 @@ Entity createStatue(RenderSystem* renderer, vec2 pos)
 		entity,
 		{ TEXTURE_ASSET_ID::STATUE, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::STATIC });
 
 	return entity;
 }
@@ -387,7 +379,8 @@ Entity createAttackBuff(RenderSystem* renderer, vec2 pos)
 		entity,
 		{ TEXTURE_ASSET_ID::ATTACK_BUFF, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -410,7 +403,8 @@ Entity createDefenseBuff(RenderSystem* renderer, vec2 pos)
 		entity,
 		{ TEXTURE_ASSET_ID::DEFENSE_BUFF, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -431,7 +425,8 @@ Entity createPedestal(RenderSystem* renderer, vec2 pos)
 		entity,
 		{ TEXTURE_ASSET_ID::PEDESTAL, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::STATIC });
 
 	return entity;
 }
@@ -461,7 +456,8 @@ Entity createBat(RenderSystem* renderer, vec2 pos,float flyRange)
 		entity,
 		{ TEXTURE_ASSET_ID::BAT, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::BAT_ENEMY });
+			GEOMETRY_BUFFER_ID::BAT_ENEMY,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -484,7 +480,8 @@ Entity createFireBall(RenderSystem* renderer, vec2 pos, float angle, vec2 veloci
 		entity,
 		{ TEXTURE_ASSET_ID::FIREBALL, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::PROJECTILES });
 
 	return entity;
 }
@@ -514,7 +511,8 @@ Entity createMagicBall(RenderSystem* renderer, vec2 pos, float angle, vec2 veloc
 		entity,
 		{ texture, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			geometry});
+			geometry,
+			RENDER_LAYER::PROJECTILES });
 
 	return entity;
 }
@@ -546,7 +544,8 @@ Entity createRangedEnemy(RenderSystem* renderer, vec2 pos, float attackRange, fl
 		entity,
 		{ TEXTURE_ASSET_ID::MUSHROOM, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::MUSHROOM_ENEMY });
+			GEOMETRY_BUFFER_ID::MUSHROOM_ENEMY,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -577,7 +576,8 @@ Entity createWizard(RenderSystem* renderer, vec2 pos, float attackRange, float r
 		entity,
 		{ TEXTURE_ASSET_ID::WIZARD, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::WIZARD_ENEMY });
+			GEOMETRY_BUFFER_ID::WIZARD_ENEMY,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -605,7 +605,8 @@ Entity createGolem(RenderSystem* renderer, vec2 pos) {
 		entity,
 		{ TEXTURE_ASSET_ID::GOLEM, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::GOLEM_ENEMY });
+			GEOMETRY_BUFFER_ID::GOLEM_ENEMY,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -635,7 +636,8 @@ Entity createArmProjectile(RenderSystem* renderer, vec2 pos,vec2 distanceVec,flo
 		entity,
 		{ TEXTURE_ASSET_ID::ARMPROJECTILE, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::ARMPROJECTILE_ENEMY });
+			GEOMETRY_BUFFER_ID::ARMPROJECTILE_ENEMY,
+			RENDER_LAYER::PROJECTILES });
 
 	return entity;
 }
@@ -664,7 +666,8 @@ Entity createEnergyProjectile(RenderSystem* renderer, vec2 pos, vec2 distanceVec
 		entity,
 		{ TEXTURE_ASSET_ID::ENERGYPROJECTILE, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::ENERGYPROJECTILE_ENEMY });
+			GEOMETRY_BUFFER_ID::ENERGYPROJECTILE_ENEMY,
+			RENDER_LAYER::PROJECTILES });
 
 	return entity;
 }
@@ -694,7 +697,8 @@ Entity createDemon(RenderSystem* renderer, vec2 pos, float boundLeft, float boun
 		entity,
 		{ TEXTURE_ASSET_ID::DEMON, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::DEMON_ENEMY });
+			GEOMETRY_BUFFER_ID::DEMON_ENEMY,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -725,7 +729,8 @@ Entity createSkeleton(RenderSystem* renderer, vec2 pos, float attackRange, float
 		entity,
 		{ TEXTURE_ASSET_ID::SKELETON_IDLE, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SKELETON_ENEMY });
+			GEOMETRY_BUFFER_ID::SKELETON_ENEMY,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -754,7 +759,8 @@ Entity createGhost(RenderSystem* renderer, vec2 pos) {
 		entity,
 		{ TEXTURE_ASSET_ID::GHOST, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -787,7 +793,8 @@ Entity createWolf(RenderSystem* renderer, vec2 pos, float roamRange,float set_ju
 		entity,
 		{ TEXTURE_ASSET_ID::WOLF, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::WOLF_ENEMY });
+			GEOMETRY_BUFFER_ID::WOLF_ENEMY,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -813,7 +820,8 @@ Entity createSaw(RenderSystem* renderer, vec2 pos) {
 		entity,
 		{ TEXTURE_ASSET_ID::SAW, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SAW });
+			GEOMETRY_BUFFER_ID::SAW,
+			RENDER_LAYER::ACTORS });
 
 	return entity;
 }
@@ -843,30 +851,9 @@ Entity createPotion(RenderSystem* renderer, vec2 pos, PotionType pot) {
 		entity,
 		{ TEXTURE_ASSET_ID::STATUS_EFFECT, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
-
-	return entity;
-}
-
-Entity createLine(vec2 position, vec2 scale)
-{
-	Entity entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
-	registry.renderRequests.insert(
-		entity,
-		{ TEXTURE_ASSET_ID::TEXTURE_COUNT,
-		 EFFECT_ASSET_ID::EGG,
-		 GEOMETRY_BUFFER_ID::DEBUG_LINE });
-
-	// Create motion
-	Motion& motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = { 0, 0 };
-	motion.position = position;
-	motion.scale = scale;
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::ACTORS });
 
-	registry.debugComponents.emplace(entity);
 	return entity;
 }
 
@@ -894,7 +881,8 @@ Entity createHeart(RenderSystem* renderer, vec2 pos, vec2 r_pos, vec2 scale) {
 		entity,
 		{ TEXTURE_ASSET_ID::HEART_SHEET, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTUREDFIXED,
-			GEOMETRY_BUFFER_ID::PLAYER_HEART });
+			GEOMETRY_BUFFER_ID::PLAYER_HEART,
+			RENDER_LAYER::HUD });
 
 	return entity;
 }
@@ -922,7 +910,8 @@ Entity createShield(RenderSystem* renderer, vec2 pos, vec2 r_pos, vec2 scale) {
 		entity,
 		{ TEXTURE_ASSET_ID::SHIELD_SHEET, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::TEXTUREDFIXED,
-			GEOMETRY_BUFFER_ID::PLAYER_SHIELD });
+			GEOMETRY_BUFFER_ID::PLAYER_SHIELD,
+			RENDER_LAYER::HUD });
 
 	return entity;
 }
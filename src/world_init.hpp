@@ -58,8 +58,8 @@ Entity createScene(RenderSystem* renderer, vec2 pos, TEXTURE_ASSET_ID id);
 // the background
 // the background, background id = 1 to set background to background.png, it specifies the id of the background image it wants to use
 Entity createBackground(RenderSystem* renderer, vec2 pos, int background_id);
-Entity createBackgroundCloud(RenderSystem* renderer, vec2 pos);
-Entity createBackgroundTrees(RenderSystem* renderer, vec2 pos);
+// scrolling clouds and trees, drawn by the renderer and not entities
+void createParallaxBackground(RenderSystem* renderer);
 // the tile
 Entity createTile(RenderSystem* renderer, vec2 pos);
 
@@ -94,9 +94,6 @@ Entity createAttack1(RenderSystem* renderer, vec2 pos);
 // attack2 obj
 Entity createAttack2(RenderSystem* renderer, vec2 pos);
 
-// a red line for debugging purposes
-Entity createLine(vec2 position, vec2 size);
-
 // bat enemy
 // flies up and down a certain distance, no horizontal movement
 Entity createBat(RenderSystem* renderer, vec2 pos, float flyRange);
@@ -0,0 +1,448 @@
+#include "world_snapshot.hpp"
+#include "asset_pack.hpp"
+#include "render_system.hpp"
+
+// stlib
+#include <cstring>
+
+static const uint32_t snapshot_magic = 0x5357484E; // "NHWS"
+// Bump whenever a serialize() below or a plain component changes
+static const uint32_t snapshot_version = 1;
+
+struct SnapshotHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size;
+	uint64_t checksum;
+};
+
+SnapshotWriter::SnapshotWriter()
+{
+	bytes.resize(sizeof(SnapshotHeader));
+}
+
+void SnapshotWriter::raw(const void* data, size_t size)
+{
+	const unsigned char* begin = (const unsigned char*)data;
+	bytes.insert(bytes.end(), begin, begin + size);
+}
+
+void SnapshotWriter::value(std::string& s)
+{
+	uint32_t length = (uint32_t)s.size();
+	value(length);
+	raw(s.data(), length);
+}
+
+// The keys never change after construction, only the flags are written
+void SnapshotWriter::value(std::map<std::string, bool>& m)
+{
+	uint32_t count = (uint32_t)m.size();
+	value(count);
+	for (auto& state : m)
+		value(state.second);
+}
+
+std::vector<unsigned char>& SnapshotWriter::finish()
+{
+	SnapshotHeader header;
+	header.magic = snapshot_magic;
+	header.version = snapshot_version;
+	header.size = bytes.size() - sizeof(SnapshotHeader);
+	header.checksum = fnv1a(bytes.data() + sizeof(SnapshotHeader), (size_t)header.size);
+	memcpy(bytes.data(), &header, sizeof(header));
+	return bytes;
+}
+
+bool SnapshotReader::open(const std::vector<unsigned char>& data)
+{
+	SnapshotHeader header;
+	if (data.size() < sizeof(header))
+		return false;
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != snapshot_magic || header.version != snapshot_version ||
+		header.size != data.size() - sizeof(header) ||
+		header.checksum != fnv1a(data.data() + sizeof(header), (size_t)header.size))
+		return false;
+	cursor = data.data() + sizeof(header);
+	end = data.data() + data.size();
+	ok = true;
+	return true;
+}
+
+void SnapshotReader::raw(void* data, size_t size)
+{
+	if (!ok || size > remaining())
+	{
+		ok = false;
+		memset(data, 0, size);
+		return;
+	}
+	memcpy(data, cursor, size);
+	cursor += size;
+}
+
+bool SnapshotReader::commit()
+{
+	if (ok)
+		for (std::function<void()>& assign : pending)
+			assign();
+	pending.clear();
+	return ok;
+}
+
+void SnapshotReader::value(std::string& s)
+{
+	uint32_t length = 0;
+	value(length);
+	if (!ok || length > remaining())
+	{
+		ok = false;
+		return;
+	}
+	s.assign((const char*)cursor, length);
+	cursor += length;
+}
+
+void SnapshotReader::value(std::vector<Entity>& v)
+{
+	std::vector<uint32_t> ids;
+	value(ids);
+	v.clear();
+	v.reserve(ids.size());
+	for (uint32_t id : ids)
+		v.push_back(Entity::fromId(id));
+}
+
+void SnapshotReader::value(std::map<std::string, bool>& m)
+{
+	uint32_t count = 0;
+	value(count);
+	if (count != m.size())
+	{
+		ok = false;
+		return;
+	}
+	for (auto& state : m)
+		value(state.second);
+}
+
+// Components holding strings or maps. state_map is left out, it is the same
+// for every instance of a type.
+
+template <class A, class C>
+static void serialize_animation(A& a, C& c)
+{
+	a(c.sheetsize, c.state_curr, c.rowMax, c.colMax, c.state_index, c.stateChange);
+}
+
+template <class A>
+static void serialize(A& a, Buff& c)
+{
+	a(c.buff_type);
+}
+
+template <class A>
+static void serialize(A& a, Saw& c)
+{
+	a(c.render_update_frame, c.render_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, Readable& c)
+{
+	a(c.beingRead, c.lines);
+}
+
+template <class A>
+static void serialize(A& a, RangedEnemy& c)
+{
+	a(c.initialPos, c.stationary, c.attackRange, c.idleSpeed, c.roamRange, c.chargeUpTime, c.immunity_duration_ms,
+		c.health, c.honor, c.skeleton_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, Wizard& c)
+{
+	a(c.initialPos, c.stationary, c.attackRange, c.roamRange, c.idleSpeed, c.immunity_duration_ms, c.attack_duration_ms,
+		c.attack_delay_ms, c.hurt_duration_ms, c.death_duration_ms, c.health, c.wizard_curr_frame, c.honor);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, MagicBall1& c)
+{
+	a(c.initialPos, c.render_update_frame, c.render_curr_frame, c.duration_ms, c.damage);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, MagicBall2& c)
+{
+	a(c.initialPos, c.damage, c.render_update_frame, c.render_curr_frame, c.duration_ms);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, BatEnemy& c)
+{
+	a(c.initialPos, c.flyRange, c.damage, c.health, c.honor, c.immunity_duration_ms, c.bat_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, SkeletonEnemy& c)
+{
+	a(c.initialPos, c.attackRange, c.idleSpeed, c.aggroSpeed, c.roamRange, c.damage, c.health, c.honor,
+		c.immunity_duration_ms, c.skeleton_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, GhostEnemy& c)
+{
+	a(c.initialPos, c.attackRange, c.idleSpeed, c.aggroSpeed, c.roamRange, c.damage, c.health, c.skeleton_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, EnergyProjectile& c)
+{
+	a(c.damage, c.render_update_frame, c.render_curr_frame, c.duration_ms);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, ArmProjectile& c)
+{
+	a(c.duration_ms, c.health, c.damage, c.speed, c.render_update_frame, c.render_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, Golem& c)
+{
+	a(c.deathDuration, c.engaged, c.burstCount, c.burst_cd, c.alive, c.energyBurstCount, c.energyBurst_cd, c.bob_cd,
+		c.up, c.attack_range, c.health, c.damage, c.energy_attack_cd_ms, c.energy_attack_curr_cd_ms,
+		c.arm_projectile_cd_ms, c.arm_projectile_curr_cd_ms, c.immunity_reset_duration, c.immunity_duration,
+		c.render_update_frame, c.render_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, Demon& c)
+{
+	a(c.idleSpeed, c.boundLeft, c.boundRight, c.damage, c.health, c.honor, c.attack_range, c.attack_cd_ms,
+		c.attack_curr_cd_ms, c.attack_actual_reset_timer, c.attack_actual_timer, c.immunity_reset_duration,
+		c.immunity_duration, c.walk_reset_timer, c.walk_timer, c.render_update_frame, c.render_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, WolfEnemy& c)
+{
+	a(c.initialPos, c.attackRange, c.idleSpeed, c.aggroSpeed, c.roamRange, c.damage, c.health, c.honor, c.jump_cd,
+		c.set_jump_cd, c.jump_speed, c.wolf_curr_frame, c.immunity_duration_ms, c.render_update_frame,
+		c.render_curr_frame);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, Heart& c)
+{
+	a(c.relative_pos);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, Shield& c)
+{
+	a(c.relative_pos);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, Player& c)
+{
+	a(c.alive, c.camera_x, c.camera_y, c.immunity_duration_ms, c.health, c.shield, c.damage);
+	serialize_animation(a, c);
+}
+
+template <class A>
+static void serialize(A& a, Text& c)
+{
+	a(c.str, c.color, c.trans, c.fixed);
+}
+
+// Plain components are a single copy of the whole array
+template <class C>
+static void write_components(SnapshotWriter& out, std::vector<C>& components, std::true_type)
+{
+	out.raw(components.data(), sizeof(C) * components.size());
+}
+
+template <class C>
+static void write_components(SnapshotWriter& out, std::vector<C>& components, std::false_type)
+{
+	for (C& component : components)
+		serialize(out, component);
+}
+
+template <class C>
+static void read_components(SnapshotReader& in, std::vector<C>& components, std::true_type)
+{
+	in.raw(components.data(), sizeof(C) * components.size());
+}
+
+template <class C>
+static void read_components(SnapshotReader& in, std::vector<C>& components, std::false_type)
+{
+	for (C& component : components)
+		serialize(in, component);
+}
+
+template <class C>
+static void write_container(SnapshotWriter& out, ComponentContainer<C>& container)
+{
+	out.value(container.entities);
+	write_components(out, container.components, std::is_trivially_copyable<C>());
+}
+
+template <class C>
+static void read_container(SnapshotReader& in, ComponentContainer<C>& container)
+{
+	std::vector<Entity> entities;
+	in.value(entities);
+	if (!in.ok)
+		return;
+	// Default constructed first so state_map and the like are set up
+	std::vector<C> components(entities.size());
+	read_components(in, components, std::is_trivially_copyable<C>());
+	if (!in.ok)
+		return;
+	auto staged = std::make_shared<std::pair<std::vector<Entity>, std::vector<C>>>(std::move(entities), std::move(components));
+	in.later([&container, staged] { container.assign(std::move(staged->first), std::move(staged->second)); });
+}
+
+struct ContainerWriter
+{
+	SnapshotWriter& out;
+	template <class C>
+	void operator()(ComponentContainer<C>& container) { write_container(out, container); }
+};
+
+struct ContainerReader
+{
+	SnapshotReader& in;
+	template <class C>
+	void operator()(ComponentContainer<C>& container) { read_container(in, container); }
+};
+
+// Every container saved as is. meshPtrs, screenStates and collisions are
+// handled by hand below.
+// IMPORTANT: Don't forget to add any newly added containers!
+template <class F>
+static void for_each_container(F&& f)
+{
+	f(registry.deathTimers);
+	f(registry.nextLevelTimers);
+	f(registry.motions);
+	f(registry.players);
+	f(registry.renderRequests);
+	f(registry.eatables);
+	f(registry.deadlys);
+	f(registry.colors);
+	f(registry.background);
+	f(registry.tiles);
+	f(registry.deathboxes);
+	f(registry.nextLevels);
+	f(registry.potions);
+	f(registry.batEnemy);
+	f(registry.skeletonEnemy);
+	f(registry.demonBoss);
+	f(registry.wolfEnemy);
+	f(registry.player_attack1);
+	f(registry.player_attack2);
+	f(registry.player_health);
+	f(registry.readables);
+	f(registry.ghostEnemy);
+	f(registry.buffs);
+	f(registry.pedestals);
+	f(registry.doors);
+	f(registry.saws);
+	f(registry.texts);
+	f(registry.rollTimers);
+	f(registry.rangedEnemy);
+	f(registry.fireBalls);
+	f(registry.attackPathTimers);
+	f(registry.shields);
+	f(registry.armProjectile);
+	f(registry.energyProjectile);
+	f(registry.golem);
+	f(registry.wizards);
+	f(registry.magicBalls1);
+	f(registry.magicBalls2);
+}
+
+void snapshot_registry(SnapshotWriter& out, RenderSystem* renderer)
+{
+	uint32_t next_id = Entity::nextId();
+	out.value(next_id);
+	for_each_container(ContainerWriter{ out });
+
+	// Mesh pointers are saved as the geometry they point to
+	const Mesh* first_mesh = &renderer->getMesh((GEOMETRY_BUFFER_ID)0);
+	std::vector<uint32_t> geometry;
+	geometry.reserve(registry.meshPtrs.size());
+	for (Mesh* mesh : registry.meshPtrs.components)
+		geometry.push_back((uint32_t)(mesh - first_mesh));
+	out.value(registry.meshPtrs.entities);
+	out.value(geometry);
+
+	// The screen state entity belongs to the renderer, only its values are saved
+	ScreenState screen = registry.screenStates.components.empty() ? ScreenState() : registry.screenStates.components[0];
+	out.value(screen);
+}
+
+void restore_registry(SnapshotReader& in, RenderSystem* renderer)
+{
+	uint32_t next_id = 0;
+	in.value(next_id);
+	for_each_container(ContainerReader{ in });
+
+	std::vector<Entity> mesh_entities;
+	std::vector<uint32_t> geometry;
+	in.value(mesh_entities);
+	in.value(geometry);
+	if (in.ok && mesh_entities.size() == geometry.size())
+	{
+		std::vector<Mesh*> meshes;
+		meshes.reserve(geometry.size());
+		for (uint32_t id : geometry)
+		{
+			if (id >= (uint32_t)geometry_count)
+				in.ok = false;
+			else
+				meshes.push_back(&renderer->getMesh((GEOMETRY_BUFFER_ID)id));
+		}
+		if (in.ok)
+		{
+			auto staged = std::make_shared<std::pair<std::vector<Entity>, std::vector<Mesh*>>>(std::move(mesh_entities), std::move(meshes));
+			in.later([staged] { registry.meshPtrs.assign(std::move(staged->first), std::move(staged->second)); });
+		}
+	}
+	else
+		in.ok = false;
+
+	ScreenState screen;
+	in.value(screen);
+	in.later([screen, next_id] {
+		if (!registry.screenStates.components.empty())
+			registry.screenStates.components[0] = screen;
+		registry.collisions.clear();
+		Entity::reserveIds(next_id);
+	});
+}
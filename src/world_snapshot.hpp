@@ -0,0 +1,145 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "common.hpp"
+#include "tiny_ecs_registry.hpp"
+
+class RenderSystem;
+
+// Binary image of the whole world: every registry container plus whatever
+// WorldSystem keeps outside of it. Components that are plain data are copied
+// as one block per container, the others go through a serialize() overload
+// in world_snapshot.cpp that lists their fields. Restoring refills each
+// container in one go under the saved entity ids, nothing is rebuilt from
+// the level_*() functions. Nothing is replaced until the whole snapshot has
+// been read, a damaged one leaves the world as it was.
+//
+// Both archives take fields through operator(), so one serialize() function
+// describes a type for saving and loading.
+class SnapshotWriter
+{
+public:
+	SnapshotWriter();
+
+	template <class... T>
+	void operator()(T&... values)
+	{
+		int expand[] = { 0, (value(values), 0)... };
+		(void)expand;
+	}
+
+	template <class T>
+	void value(T& v)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "needs a serialize() overload");
+		raw(&v, sizeof(T));
+	}
+	void value(std::string& s);
+	void value(std::map<std::string, bool>& m);
+	template <class T>
+	void value(std::vector<T>& v)
+	{
+		uint32_t count = (uint32_t)v.size();
+		value(count);
+		for (T& element : v)
+			value(element);
+	}
+
+	void raw(const void* data, size_t size);
+
+	// Fills in the header, the snapshot is ready to be stored
+	std::vector<unsigned char>& finish();
+
+private:
+	std::vector<unsigned char> bytes;
+};
+
+class SnapshotReader
+{
+public:
+	// False if data is not a snapshot of this version or is damaged
+	bool open(const std::vector<unsigned char>& data);
+
+	template <class... T>
+	void operator()(T&... values)
+	{
+		int expand[] = { 0, (value(values), 0)... };
+		(void)expand;
+	}
+
+	template <class T>
+	void value(T& v)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "needs a serialize() overload");
+		raw(&v, sizeof(T));
+	}
+	void value(std::string& s);
+	void value(std::map<std::string, bool>& m);
+	// Without handing out a new id per element
+	void value(std::vector<Entity>& v);
+	template <class T>
+	void value(std::vector<T>& v)
+	{
+		uint32_t count = 0;
+		value(count);
+		if (!ok || count > remaining())
+		{
+			ok = false;
+			return;
+		}
+		v.resize(count);
+		for (T& element : v)
+			value(element);
+	}
+
+	void raw(void* data, size_t size);
+	size_t remaining() const { return (size_t)(end - cursor); }
+
+	// Reads values into copies that only replace them on commit()
+	template <class... T>
+	void deferred(T&... values)
+	{
+		int expand[] = { 0, (deferredValue(values), 0)... };
+		(void)expand;
+	}
+	template <class T>
+	void deferredValue(T& v)
+	{
+		// Starts from the current value, maps keep their keys
+		std::shared_ptr<T> copy = std::make_shared<T>(v);
+		value(*copy);
+		later([&v, copy] { v = std::move(*copy); });
+	}
+	// Queues an assignment for commit()
+	void later(std::function<void()> assign) { pending.push_back(std::move(assign)); }
+	// Runs the queued assignments if everything was read, false and nothing
+	// assigned otherwise
+	bool commit();
+
+	// False once anything was read past the end or did not match
+	bool ok = true;
+
+private:
+	const unsigned char* cursor = nullptr;
+	const unsigned char* end = nullptr;
+	std::vector<std::function<void()>> pending;
+};
+
+// Archive for values outside the registry, read through SnapshotReader::deferred
+struct DeferredReader
+{
+	SnapshotReader& in;
+	template <class... T>
+	void operator()(T&... values) { in.deferred(values...); }
+};
+
+// Every registry container, collisions excepted since they only live within a step
+void snapshot_registry(SnapshotWriter& out, RenderSystem* renderer);
+// Reads every registry container, they are replaced by in.commit()
+void restore_registry(SnapshotReader& in, RenderSystem* renderer);
@@ -4,15 +4,19 @@
 
 // stlib
 #include <cassert>
+#include <chrono>
+#include <climits>
 #include <sstream>
 
+#include "debug_draw.hpp"
+#include "level_file.hpp"
 #include "physics_system.hpp"
+#include "startup_report.hpp"
+#include "static_tiles.hpp"
+#include "thread_pool.hpp"
+#include "world_snapshot.hpp"
 #include <iostream>
 
-// json
-#include <json.hpp>
-using json = nlohmann::json;
-
 // Game configuration
 int playerHealth = 3;
 bool movingLeft = false;
@@ -34,6 +38,33 @@ bool showBossHealth = false;
 bool previousKeyA = false;
 bool previousKeyD = false;
 
+// State the next level timer leads to, gs itself if it leads nowhere
+static GameState next_state(GameState gs) {
+	switch (gs) {
+	case FirstCutscene: return Tutorial;
+	case Tutorial: return LevelOne;
+	case LevelOne: return SecondCutscene;
+	case SecondCutscene: return LevelTwo;
+	case LevelTwo: return ThirdCutscene;
+	case ThirdCutscene: return BuffRoom;
+	case BuffRoom: return LevelThree;
+	case LevelThree: return Complete;
+	default: return gs;
+	}
+}
+
+// Name of the data/levels file a state is built from, nullptr if it has none
+static const char* level_file_name(GameState gs) {
+	switch (gs) {
+	case Tutorial: return "tutorial";
+	case LevelOne: return "level_one";
+	case LevelTwo: return "level_two";
+	case BuffRoom: return "buff_room";
+	case LevelThree: return "level_three";
+	default: return nullptr;
+	}
+}
+
 float lerp(float start, float end, float t) {
 	return start * (1 - t) + end * t;
 }
@@ -64,34 +95,6 @@ float cubicInterp(float timeCurrent, float velocity)
 	return (a * pow(timeCurrent, 3)) + (b * pow(timeCurrent, 2) + (c * timeCurrent) + d);
 }
 
-void to_json(json& j, const GameState& gs, const Player& p, const Motion& m) {
-	j = json{
-		{ "game_state", gs },
-		{ "health", p.health },
-		{ "shield", p.shield },
-		{ "interactable", m.interactable},
-		{ "position.x", m.position.x },
-		{ "position.y", m.position.y },
-		{ "isJumping", m.isJumping},
-		{ "isFalling", m.isFalling },
-		{ "touchingWall", m.touchingWall },
-		{ "honorGained" , honorGained }
-	};
-}
-
-void from_json(json& j, GameState &gs, Player&p, Motion& m) {
-	j.at("game_state").get_to(gs);
-	j.at("health").get_to(p.health);
-	j.at("shield").get_to(p.shield);
-	j.at("interactable").get_to(m.interactable);
-	j.at("position.x").get_to(m.position.x);
-	j.at("position.y").get_to(m.position.y);
-	j.at("isJumping").get_to(m.isJumping);
-	j.at("isFalling").get_to(m.isFalling);
-	j.at("touchingWall").get_to(m.touchingWall);
-	j.at("honorGained").get_to(honorGained);
-}
-
 // Create the bug world
 WorldSystem::WorldSystem()
 	: points(0)
@@ -101,25 +104,9 @@ WorldSystem::WorldSystem()
 }
 
 WorldSystem::~WorldSystem() {
-	// Destroy audio components
-	if (player_death_sound != nullptr)
-		Mix_FreeChunk(player_death_sound);
-	if (player_heal_sound != nullptr)
-		Mix_FreeChunk(player_heal_sound);
-	if (player_buff_sound != nullptr)
-		Mix_FreeChunk(player_buff_sound);
-	if (player_jump_sound != nullptr)
-		Mix_FreeChunk(player_jump_sound);
-	if (player_roll_sound != nullptr)
-		Mix_FreeChunk(player_roll_sound);
-	if (player_take_damage != nullptr)
-		Mix_FreeChunk(player_take_damage);
-	if (enemy_take_damage != nullptr)
-		Mix_FreeChunk(enemy_take_damage);
-	if (potion_disappear_sound != nullptr)
-		Mix_FreeChunk(potion_disappear_sound);
-	if (next_area_sound != nullptr)
-		Mix_FreeChunk(next_area_sound);
+	saves.flush();
+	sounds.destroy();
+	music.destroy();
 	Mix_CloseAudio();
 
 	// Destroy all created components
@@ -136,32 +123,18 @@ namespace {
 	}
 }
 
-// DO NOT WORK WELL WITH CAMERA, see render_system.cpp ln 190
 void WorldSystem::drawDebugBoundingBox(
 	const vec2& pos,
 	const vec2& scale,
-	vec3 color = { 1, 0.8f, 0.8f },
-	float lineThickns = 5.0f)
+	vec3 color = { 1, 0.8f, 0.8f })
 {
-	// left
-	Entity left = createLine({ pos.x - abs(scale.x) / 2.0f, pos.y }, { lineThickns, abs(scale.y) });
-	registry.colors.insert(left, color);
-	// right
-	Entity right = createLine({ pos.x + abs(scale.x) / 2.0f, pos.y }, { lineThickns, abs(scale.y) });
-	registry.colors.insert(right, color);
-	// top
-	Entity top = createLine({ pos.x, pos.y - abs(scale.y) / 2.0f }, { abs(scale.x), lineThickns });
-	registry.colors.insert(top, color);
-	// bottom
-	Entity bottom = createLine({ pos.x, pos.y + abs(scale.y) / 2.0f }, { abs(scale.x), lineThickns });
-	registry.colors.insert(bottom, color);
+	debug_box(pos, scale, color);
 }
 
-// DO NOT WORK WELL WITH CAMERA, see render_system.cpp ln 190
 void WorldSystem::drawDebugDot(
 	Entity& e,
 	vec3 color = { 1, 0.8f, 0.8f },
-	float lineThickns = 5.0f)
+	float dotSize = 5.0f)
 {
 	if (registry.meshPtrs.has(e))
 	{
@@ -175,45 +148,31 @@ void WorldSystem::drawDebugDot(
 		float& posX = registry.motions.get(e).position.x;
 		float& posY = registry.motions.get(e).position.y;
 
-		for (uint i = 0; i < registry.meshPtrs.get(e)->vertices.size(); i += 25)
+		for (const vec2& sample : registry.meshPtrs.get(e)->samples)
 		{
 
 			vec2 curr = {
-				posX + registry.meshPtrs.get(e)->vertices[i].position.x * sizeOffset_x,
-				posY - registry.meshPtrs.get(e)->vertices[i].position.y * sizeOffset_y };
+				posX + sample.x * sizeOffset_x,
+				posY - sample.y * sizeOffset_y };
 
 			// draw outline dots, for debug
-			Entity currP = createLine(curr, { lineThickns, lineThickns });
-			registry.colors.insert(currP, color);
+			debug_point(curr, color, dotSize);
 
 			xMin = std::min(xMin, curr.x);
 			xMax = std::max(xMax, curr.x);
 			yMin = std::min(yMin, curr.y);
 			yMax = std::max(yMax, curr.y);
 		}
-		float nw = (xMax - xMin) / 2.0f;
-		float nh = (yMax - yMin) / 2.0f;
 
-		vec2 npos = vec2({ (xMax + xMin) / 2.0f, (yMax + yMin) / 2.0f });
-
-		// left
-		Entity left = createLine({ npos.x - nw, npos.y }, { lineThickns, nh * 2.0f });
-		registry.colors.insert(left, color);
-		// right
-		Entity right = createLine({ npos.x + nw, npos.y }, { lineThickns, nh * 2.0f });
-		registry.colors.insert(right, color);
-		// top
-		Entity top = createLine({ npos.x, npos.y - nh }, { nw * 2.0f, lineThickns });
-		registry.colors.insert(top, color);
-		// bottom
-		Entity bottom = createLine({ npos.x, npos.y + nh }, { nw * 2.0f, lineThickns });
-		registry.colors.insert(bottom, color);
+		debug_box({ (xMax + xMin) / 2.0f, (yMax + yMin) / 2.0f }, { xMax - xMin, yMax - yMin }, color);
 	}
 }
 
 // World initialization
 // Note, this has a lot of OpenGL specific things, could be moved to the renderer
 GLFWwindow* WorldSystem::create_window() {
+	StartupTimer timer("window", "GLFW window and SDL audio");
+
 	///////////////////////////////////////
 	// Initialize GLFW
 	glfwSetErrorCallback(glfw_err_cb);
@@ -229,7 +188,9 @@ GLFWwindow* WorldSystem::create_window() {
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifndef NDEBUG
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
 #if __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
@@ -262,120 +223,162 @@ GLFWwindow* WorldSystem::create_window() {
 		return nullptr;
 	}
 
-	player_death_sound = Mix_LoadWAV(audio_path("player_death.wav").c_str());
-	player_heal_sound = Mix_LoadWAV(audio_path("player_heal.wav").c_str());
-	player_buff_sound = Mix_LoadWAV(audio_path("player_buff.wav").c_str());
-	player_jump_sound = Mix_LoadWAV(audio_path("player_jump.wav").c_str());
-	player_roll_sound = Mix_LoadWAV(audio_path("player_roll.wav").c_str());
-	player_take_damage = Mix_LoadWAV(audio_path("player_take_damage.wav").c_str());
-	enemy_take_damage = Mix_LoadWAV(audio_path("enemy_take_damage.wav").c_str());
-	potion_disappear_sound = Mix_LoadWAV(audio_path("potion_disappear.wav").c_str());
-	next_area_sound = Mix_LoadWAV(audio_path("next_area.wav").c_str());
-	boss_death_sound = Mix_LoadWAV(audio_path("boss_death.wav").c_str());
-	background_music = Mix_LoadWAV(audio_path("background_music.wav").c_str());
-	boss_music = Mix_LoadWAV(audio_path("boss_music.wav").c_str());
-	intro_music = Mix_LoadWAV(audio_path("intro.wav").c_str());
-
-	if (player_death_sound == nullptr || player_heal_sound == nullptr || player_jump_sound == nullptr || player_roll_sound == nullptr || player_buff_sound == nullptr
-		|| potion_disappear_sound == nullptr || next_area_sound == nullptr || player_take_damage == nullptr || enemy_take_damage == nullptr || boss_death_sound == nullptr
-		|| background_music == nullptr || boss_music == nullptr || intro_music == nullptr) {
-		fprintf(stderr, "Failed to load sounds\n %s\n %s\n %s\n make sure the data directory is present",
-			audio_path("player_death.wav").c_str(),
-			audio_path("player_heal.wav").c_str(),
-			audio_path("player_buff.wav").c_str(),
-			audio_path("player_jump.wav").c_str(),
-			audio_path("player_roll.wav").c_str(),
-			audio_path("player_take_damage.wav").c_str(),
-			audio_path("enemy_take_damage.wav").c_str(),
-			audio_path("potion_disappear.wav").c_str(),
-			audio_path("next_area.wav").c_str(),
-			audio_path("boss_death.wav").c_str(),
-			audio_path("background_music.wav").c_str(),
-			audio_path("boss_music.wav").c_str(),
-			audio_path("intro.wav").c_str());
-
-		return nullptr;
-	}
+	// Decoding overlaps the renderer's startup, init() waits for the results
+	sounds.load();
 
 	return window;
 }
 
-void WorldSystem::init(RenderSystem* renderer_arg) {
-	Mix_PlayChannel(2, intro_music, -1);
-	Mix_Volume(2, MIX_MAX_VOLUME / 2);
+bool WorldSystem::init(RenderSystem* renderer_arg) {
+	StartupTimer timer("world", "sounds and intro");
+	if (!sounds.finishLoading())
+		return false;
+
+	music.play(MUSIC_TRACK::INTRO);
 	this->renderer = renderer_arg;
 	renderer->fps_bool = false;
 	renderer->help_bool = false;
 
+	renderer->setGameState(Intro);
 	intro();
+	return true;
 }
 
 void WorldSystem::load_game_save() {
-	Mix_HaltChannel(2);
-	Mix_PlayChannel(0, background_music, -1);
-	std::string filename = "game_save.json";
-	std::ifstream infile;
-	std::ofstream outfile;
-
-
-	infile.open(std::string(PROJECT_SOURCE_DIR) + filename);
-
-	// If file doesn't exist create
-	if (infile.fail()) {
-		infile.close();
-		outfile.open(std::string(PROJECT_SOURCE_DIR) + filename);
-		outfile.close();
-		printf("CREATED SAVE FILE\n");
+	music.play(MUSIC_TRACK::BACKGROUND);
+	// The last save may still be on its way to disk
+	saves.flush();
+	// The world exactly as it was saved, else the level rebuilt with the player patched in
+	std::vector<unsigned char> snapshot;
+	if (SaveWriter::readSnapshot("game_save.snapshot", snapshot) && restore_snapshot(snapshot))
+		return;
+	SaveData data;
+	if (!SaveWriter::read(data)) {
+		printf("NO SAVE FILE\n");
 		game_state = LevelOne;
 	}
 	else {
-		json data = json::parse(infile);
-
-		Motion m;
-		Player p;
-
-		from_json(data, game_state, p, m);
+		game_state = data.game_state;
+		honorGained = data.honorGained;
 		level_start_honor = honorGained;
 
 		switch_state(game_state);
 
 		Player& p_player = registry.players.get(player);
-		p_player.health = p.health;
-		p_player.shield = p.shield;
+		p_player.health = data.health;
+		p_player.shield = data.shield;
 		update_hearts();
 		update_shields();
 
 
 		Motion& p_motion = registry.motions.get(player);
-		p_motion.interactable = m.interactable;
-		p_motion.position.x = m.position.x;
-		p_motion.position.y = m.position.y;
-		p_motion.isJumping = m.isJumping;
-		p_motion.isFalling = m.isFalling;
-		p_motion.touchingWall = m.touchingWall;
+		p_motion.interactable = data.interactable;
+		p_motion.position = data.position;
+		p_motion.isJumping = data.isJumping;
+		p_motion.isFalling = data.isFalling;
+		p_motion.touchingWall = data.touchingWall;
 	}
 }
 
 void WorldSystem::save_game() {
 	if (registry.players.has(player) && !registry.deathTimers.has(player)) {
-		std::string filename = "game_save.json";
-
-		std::ofstream file(std::string(PROJECT_SOURCE_DIR) + filename, std::ofstream::trunc);
-
-		json data;
+		// Copied here, serialized and written on the thread pool
 		Motion& m = registry.motions.get(player);
 		Player& p = registry.players.get(player);
-		to_json(data, game_state, p, m);
+		SaveData data;
+		data.game_state = game_state;
+		data.health = p.health;
+		data.shield = p.shield;
+		data.interactable = m.interactable;
+		data.position = m.position;
+		data.isJumping = m.isJumping;
+		data.isFalling = m.isFalling;
+		data.touchingWall = m.touchingWall;
+		data.honorGained = honorGained;
+		saves.write(data);
+		saves.writeSnapshot("game_save.snapshot", take_snapshot());
+	}
+}
+
+// Everything outside the registry a level needs to carry on, held keys excluded
+template <class A>
+void WorldSystem::serialize_world(A& a) {
+	a(game_state, player, background, tiles);
+	a(playerHealth, playerCanRead, playerCanPickUp, playerIsReading, inCutscene, currentSlide, whichCutscene);
+	a(honorGained, level_start_honor, bossHealth, defenseBuffGained, attackBuffGained, gameStarted, displayHonor, showBossHealth);
+	a(player_curr_frame, player_attack_curr_cd, camera_curr_frame, ghost_spawn_cd, ghost_spawn_limit, set_ghost_spawn_cd);
+}
+
+std::vector<unsigned char> WorldSystem::take_snapshot() {
+	SnapshotWriter out;
+	serialize_world(out);
+	std::vector<ParallaxLayer> parallax = renderer->getParallaxLayers();
+	out.value(parallax);
+	snapshot_registry(out, renderer);
+	return std::move(out.finish());
+}
+
+bool WorldSystem::restore_snapshot(const std::vector<unsigned char>& snapshot) {
+	SnapshotReader in;
+	if (!in.open(snapshot)) {
+		printf("Snapshot is damaged or from another version\n");
+		return false;
+	}
+	DeferredReader world_fields = { in };
+	serialize_world(world_fields);
+	std::vector<ParallaxLayer> parallax;
+	in.value(parallax);
+	restore_registry(in, renderer);
+	if (!in.commit()) {
+		// Nothing was replaced, the caller falls back on what it has
+		printf("Snapshot ended early, nothing was restored\n");
+		return false;
+	}
+	// The tiles may be another level's under the same ids
+	static_tiles.invalidate();
+
+	renderer->setGameState(game_state);
+	renderer->setParallaxLayers(parallax);
+	music.play(game_state == Intro ? MUSIC_TRACK::INTRO : game_state == LevelThree ? MUSIC_TRACK::BOSS : MUSIC_TRACK::BACKGROUND);
+	movingLeft = false;
+	movingRight = false;
+	return true;
+}
+
+void WorldSystem::quick_save() {
+	if (!registry.players.has(player) || registry.deathTimers.has(player))
+		return;
+	auto start = std::chrono::steady_clock::now();
+	quick_snapshot = take_snapshot();
+	saves.writeSnapshot("quick_save.snapshot", quick_snapshot);
+	float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("Quick saved %.1f KB in %.2f ms\n", quick_snapshot.size() / 1024.f, ms);
+}
 
-		file << std::setw(4) << data << std::endl;
+void WorldSystem::quick_load() {
+	auto start = std::chrono::steady_clock::now();
+	// From an earlier run when nothing was saved in this one
+	if (quick_snapshot.empty()) {
+		saves.flush();
+		if (!SaveWriter::readSnapshot("quick_save.snapshot", quick_snapshot)) {
+			printf("No quick save\n");
+			return;
+		}
+	}
+	if (!restore_snapshot(quick_snapshot)) {
+		quick_snapshot.clear();
+		return;
 	}
+	float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("Quick loaded in %.2f ms\n", ms);
 }
 
 // Update our game world
 bool WorldSystem::step(float elapsed_ms_since_last_update) {
-	// Remove debug info from the last step
-	while (registry.debugComponents.entities.size() > 0)
-	    registry.remove_all_components_of(registry.debugComponents.entities.back());
+	// Debug lines last until the step that replaces them
+	clear_debug_lines();
+	music.update();
+	sounds.update(elapsed_ms_since_last_update);
 
 	auto& motions_registry = registry.motions;
 
@@ -389,12 +392,6 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			registry.players.get(player).alive = true;
 		}
 
-		if (player_prev_position != -1000.f)
-		{
-			player_position_derivative = motions_registry.get(player).position.x - player_prev_position;
-		}
-		player_prev_position = motions_registry.get(player).position.x;
-
 		if (movingLeft) {
 			registry.motions.get(player).velocity.x = -700.f;
 			if (registry.players.get(player).getCurrState() == "idle") {
@@ -603,47 +600,6 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 				cam_x = lerp(cam_x, pos_x, 0.5f);
 			}
 		}
-
-		// rolling clouds based on player movement;
-		for (Entity e : background_cloud)
-		{
-			registry.motions.get(e).position.x -=
-				player_position_derivative / cloud_relative_speed_factor;
-			// left bound
-			if (registry.motions.get(e).position.x < window_width_px - background_cloud.size() * cloud_width + cloud_width / 2.f)
-			{
-				registry.motions.get(e).position.x += cloud_width * background_cloud.size();
-			}
-			// right bound
-			if (registry.motions.get(e).position.x > background_cloud.size() * cloud_width - cloud_width / 2.f)
-			{
-				registry.motions.get(e).position.x -= cloud_width * background_cloud.size();
-			}
-		}
-
-		for (Entity e : background_tree)
-		{
-
-			registry.motions.get(e).position.x -=
-				player_position_derivative / tree_relative_speed_factor;
-
-			// left bound
-			if (registry.motions.get(e).position.x < window_width_px - background_tree.size() * tree_width + tree_width / 2.f)
-			{
-				registry.motions.get(e).position.x += tree_width * background_tree.size();
-			}
-			// right bound
-			if (registry.motions.get(e).position.x > background_tree.size() * tree_width - tree_width / 2.f)
-			{
-				registry.motions.get(e).position.x -= tree_width * background_tree.size();
-			}
-		}
-	}
-	else
-	{
-		// reset player related data if player died
-		player_prev_position = -1000.f;
-		player_position_derivative = 0.f;
 	}// END of player related step
 
 	for (uint i = 0; i < registry.golem.entities.size(); i++)
@@ -1027,7 +983,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 							update_health(-1);
 							p.immunity_duration_ms = 1000.f;
 							if (p.health >= 0)
-								Mix_PlayChannel(-1, player_take_damage, 0);
+								sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 						}
 					}
 				}
@@ -1369,6 +1325,10 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 	// Timer for next level
 	for (Entity entity : registry.nextLevelTimers.entities) {
+		// The level behind the fade is read while it plays
+		const GameState next = next_state(game_state);
+		stage_level(next);
+
 		// progress timer
 		NextLevelTimer& counter = registry.nextLevelTimers.get(entity);
 		counter.counter_ms -= elapsed_ms_since_last_update;
@@ -1386,33 +1346,10 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			currentSlide = 0;
 			registry.nextLevelTimers.remove(entity);
 			screen.darken_screen_factor = 0;
-			if (game_state == 1) {
-				switch_state(Tutorial);
-			}
-			else if (game_state == 2) {
-				switch_state(LevelOne);
-				level_start_honor = honorGained;
-			}
-			else if (game_state == 3) {
-				switch_state(SecondCutscene);
-			}
-			else if (game_state == 4) {
-				switch_state(LevelTwo);
-				 level_start_honor = honorGained;
-			}
-			else if (game_state == 5) {
-				switch_state(ThirdCutscene);
-			}
-			else if (game_state == 6) {
-				switch_state(BuffRoom);
-				level_start_honor = honorGained;
-			}
-			else if (game_state == 7) {
-				switch_state(LevelThree);
-				level_start_honor = honorGained;
-			}
-			else if (game_state == 8) {
-				switch_state(Complete);
+			if (next != game_state) {
+				switch_state(next);
+				if (next == LevelOne || next == LevelTwo || next == BuffRoom || next == LevelThree)
+					level_start_honor = honorGained;
 			}
 			return true;
 		}
@@ -1433,7 +1370,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 		if (counter.timeout_ms < 0) {
 			registry.remove_all_components_of(entity);
-			Mix_PlayChannel(-1, potion_disappear_sound, 0);
+			sounds.play(SOUND_ID::POTION_DISAPPEAR);
 		}
 	}
 
@@ -1454,11 +1391,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 // Reset the world state to its initial state
 void WorldSystem::restart_game() {
-	Mix_HaltChannel(0);
-	Mix_HaltChannel(2);
-	Mix_HaltChannel(1);
-	Mix_PlayChannel(0, background_music, -1);
-	Mix_Volume(0, MIX_MAX_VOLUME / 15);
+	music.play(MUSIC_TRACK::BACKGROUND);
 	// Debugging for memory/component leaks
 	// Updating window title
 	std::stringstream title_ss;
@@ -1475,17 +1408,24 @@ void WorldSystem::restart_game() {
 	// Debugging for memory/component leaks
 	registry.list_all_components();
 
-	// NOTE: Things (layers) will be created in order, so order matter
+	// NOTE: Draw order comes from RenderRequest::layer, creation order does not matter
 	tiles.clear();
 	switch_state(FirstCutscene);
 }
 
 void WorldSystem::switch_state(GameState gs) {
+	using Clock = std::chrono::high_resolution_clock;
+	const Clock::time_point switch_start = Clock::now();
+
+	// Textures the state draws start decoding before its entities exist
+	renderer->setGameState(gs);
 	if (gs != GameOver) {
 		game_state = gs;
 	}
 
 	cleanup();
+	const Clock::time_point cleanup_end = Clock::now();
+	const bool staged = level_file_name(gs) != nullptr && staged_level.valid() && staged_state == gs;
 	switch (gs) {
 	case Intro:
 		intro();
@@ -1521,6 +1461,46 @@ void WorldSystem::switch_state(GameState gs) {
 		game_over();
 		break;
 	}
+
+	if (transition_tracking) {
+		in_transition = true;
+		transition_frames_after = 0;
+		transition_state = gs;
+		transition_staged = staged;
+		transition_cleanup_ms = std::chrono::duration<float, std::milli>(cleanup_end - switch_start).count();
+		transition_build_ms = std::chrono::duration<float, std::milli>(Clock::now() - cleanup_end).count();
+	}
+
+	// A cutscene or the buff room has the whole state to read the level after it
+	stage_level(next_state(gs));
+}
+
+void WorldSystem::record_frame(float frame_ms) {
+	if (!transition_tracking) {
+		transition_tracking = true;
+		return;
+	}
+	if (!in_transition) {
+		if (registry.nextLevelTimers.size() == 0)
+			return;
+		in_transition = true;
+		transition_max_ms = 0.f;
+	}
+	transition_max_ms = max(transition_max_ms, frame_ms);
+
+	// The switch frame and the first frame of the new state, which draws it
+	if (transition_frames_after < 0 || ++transition_frames_after < 2)
+		return;
+	if (transition_max_ms > transition_budget_ms) {
+		const char* level = level_file_name(transition_state) == nullptr ? "no level" :
+			transition_staged ? "level staged" : "level read on the main thread";
+		printf("Transition to state %d: longest frame %.1f ms, over the %.1f ms budget (cleanup %.2f ms, build %.2f ms, %s)\n",
+			(int)transition_state, transition_max_ms, transition_budget_ms,
+			transition_cleanup_ms, transition_build_ms, level);
+	}
+	in_transition = false;
+	transition_frames_after = -1;
+	transition_max_ms = 0.f;
 }
 
 void WorldSystem::intro() {
@@ -1550,7 +1530,7 @@ void WorldSystem::firstCutscene() {
 			Entity player = createPlayer(renderer, { -500, -500 }, playerHealth);
 			registry.nextLevelTimers.emplace(player);
 			registry.nextLevelTimers.get(player).counter_ms = 2000;
-			Mix_PlayChannel(-1, next_area_sound, 0);
+			sounds.play(SOUND_ID::NEXT_AREA);
 			whichCutscene++;
 	}
 }
@@ -1571,7 +1551,7 @@ void WorldSystem::secondCutscene() {
 		Entity player = createPlayer(renderer, { -500, -500 }, playerHealth);
 		registry.nextLevelTimers.emplace(player);
 		registry.nextLevelTimers.get(player).counter_ms = 2000;
-		Mix_PlayChannel(-1, next_area_sound, 0);
+		sounds.play(SOUND_ID::NEXT_AREA);
 		whichCutscene++;
 	}
 }
@@ -1595,89 +1575,144 @@ void WorldSystem::thirdCutscene() {
 		Entity player = createPlayer(renderer, { -500, -500 }, playerHealth);
 		registry.nextLevelTimers.emplace(player);
 		registry.nextLevelTimers.get(player).counter_ms = 2000;
-		Mix_PlayChannel(-1, next_area_sound, 0);
+		sounds.play(SOUND_ID::NEXT_AREA);
 		whichCutscene++;
 	}
 }
 
-void WorldSystem::tutorial() {
-	gameStarted = true;
-	// Create floors and walls
-	// Divided into columns, then quadrants (A1 = top quadrant of leftmost column, H3 = bottom quadrant of rightmost column)
-	// Quadrants are 1280 x 1000 in size
-	background = createBackground(renderer, { window_width_px / 2.f, window_height_px / 2.f }, 1); // Background
-	background_cloud.clear();
-	background_tree.clear();
-
-	ghost_spawn_limit = 0;
-	set_ghost_spawn_cd = 4000;
-	ghost_spawn_cd = set_ghost_spawn_cd;
+// Empty tag components, e.g. Tile, for a run of level statics
+template <class C>
+static void append_tags(ComponentContainer<C>& container, const Entity* entities, uint32_t count)
+{
+	std::vector<C> tags(count);
+	container.append(entities, tags.data(), count);
+}
 
-	float cloud_rightEdge = cloud_width / 2.f;
-	while (cloud_rightEdge - cloud_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_cloud.push_back(createBackgroundCloud(
-			renderer, { cloud_rightEdge - cloud_width / 2.0f, cloud_height / 2.f }));
-		cloud_rightEdge += cloud_width;
-	}
-	float tree_rightEdge = tree_width / 2.f;
-	while (tree_rightEdge - tree_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_tree.push_back(createBackgroundTrees(
-			renderer, { tree_rightEdge - tree_width / 2.0f, window_height_px - tree_height / 2.f }));
-		tree_rightEdge += tree_width;
-	}
-
-	// Next level box
-	Entity nextLevel = createCustomTile(renderer, { 20, 370 }, { 60, 90 });
-	registry.tiles.remove(nextLevel);
-	registry.nextLevels.emplace(nextLevel);
-	registry.colors.insert(nextLevel, { 0.3f, 0.3f, 0.3f });
-
-	tiles.push_back(createCustomTile(renderer, { 640, 1050 }, { 1280, 300 })); // Floor all the way down
-	tiles.push_back(createCustomTile(renderer, { 1640, 1050 }, { 1280, 300 })); // Floor all the way down
-	tiles.push_back(createCustomTile(renderer, { 1080, 700 }, { 240, 79 })); // Lower platform
-	tiles.push_back(createCustomTile(renderer, { 790, 450 }, { 320, 79 })); // Higher platform
-	tiles.push_back(createCustomTile(renderer, { 315, 450 }, { 640, 79 })); // Higher floor
-	tiles.push_back(createVerticalTile(renderer, { -100, 100 }, { 240, 640 })); // Higher floor wall
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createVerticalTile(renderer, { -150, 50 + 1280 * i }, { 300, 1280 }));// Left Wall all the way down
+void WorldSystem::stage_level(GameState gs) {
+	const char* name = level_file_name(gs);
+	if (name == nullptr || (staged_level.valid() && staged_state == gs))
+		return;
+
+	// Only files are touched off the main thread, entity ids and the
+	// registry are left to build_level
+	staged_state = gs;
+	std::string file = name;
+	staged_level = thread_pool.submit([file] {
+		std::unique_ptr<LevelData> level(new LevelData());
+		if (!read_level(file, *level))
+			level.reset();
+		return level;
+	});
+}
+
+void WorldSystem::build_level(GameState gs) {
+	const std::string name = level_file_name(gs);
+	std::unique_ptr<LevelData> staged;
+	if (staged_level.valid() && staged_state == gs)
+		staged = staged_level.get(); // waits if the read is still running
+	else {
+		staged.reset(new LevelData());
+		if (!read_level(name, *staged))
+			staged.reset();
 	}
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createVerticalTile(renderer, { 1350, 50 + 1280 * i }, { 300, 1280 }));// Right Wall all the way down
+	if (!staged) {
+		fprintf(stderr, "Could not load level %s, it will be empty\n", name.c_str());
+		staged.reset(new LevelData());
 	}
+	const LevelData& level = *staged;
+	const LevelSettings& settings = level.settings;
 
-	createDoor(renderer, { 20, 360 }, { 70, 100 }); // Door to next level
-
-	// Controls sign
-	Entity sign1 = createStatue(renderer, { 100, 850 });
-	registry.readables.get(sign1).lines.push_back("Press 'H' key to see player controls");
-	registry.readables.get(sign1).lines.push_back("on the bottom left of the screen.");
+	background = createBackground(renderer, { window_width_px / 2.f, window_height_px / 2.f }, settings.background); // Background
 
-	// Potion sign
-	Entity sign2 = createStatue(renderer, { 1000, 850 });
-	registry.readables.get(sign2).lines.push_back("Healing flasks can be scavenged in the cursed lands.");
-	registry.readables.get(sign2).lines.push_back("Take care to not neglect their presence.");
-	registry.readables.get(sign2).lines.push_back("The denizens of the land will steal them in time.");
+	ghost_spawn_limit = settings.ghost_spawn_limit;
+	set_ghost_spawn_cd = settings.ghost_spawn_cd;
+	ghost_spawn_cd = set_ghost_spawn_cd;
 
-	for (Entity tile : tiles) {
-		registry.colors.insert(tile, { 0.3f, 0.3f, 0.3f });
-	}
+	if (settings.parallax)
+		createParallaxBackground(renderer);
+
+	// The static block takes a run of new ids and every container its part of
+	// the block in one append, the cooked grid then indexes the tiles as is
+	const unsigned int first_id = Entity::nextId();
+	const uint32_t count = (uint32_t)level.motions.size();
+	std::vector<Entity> statics;
+	statics.reserve(count);
+	for (uint32_t i = 0; i < count; i++)
+		statics.push_back(Entity::fromId(first_id + i));
+	Entity::reserveIds(first_id + count);
+
+	registry.motions.append(statics.data(), level.motions.data(), count);
+	registry.renderRequests.append(statics.data(), level.requests.data(), count);
+	registry.colors.append(statics.data(), level.colors.data(), level.colors.size());
+	const Entity* block = statics.data();
+	const uint32_t* kind_count = level.kind_count;
+	append_tags(registry.tiles, block, kind_count[(int)LEVEL_STATIC::TILE]);
+	block += kind_count[(int)LEVEL_STATIC::TILE];
+	append_tags(registry.nextLevels, block, kind_count[(int)LEVEL_STATIC::NEXT_LEVEL]);
+	block += kind_count[(int)LEVEL_STATIC::NEXT_LEVEL];
+	append_tags(registry.deathboxes, block, kind_count[(int)LEVEL_STATIC::DEATHBOX]);
+	block += kind_count[(int)LEVEL_STATIC::DEATHBOX];
+	append_tags(registry.doors, block, kind_count[(int)LEVEL_STATIC::DOOR]);
+
+	// Adopted after the tiles are appended, so the grid matches their generation
+	tiles.assign(statics.begin(), statics.begin() + kind_count[(int)LEVEL_STATIC::TILE]);
+	static_tiles.adopt(tiles, level.tile_mins, level.tile_maxs, level.grid);
 
 	//Player
-	player = createPlayer(renderer, { 100, 880 }, playerHealth);
+	player = createPlayer(renderer, settings.player, settings.player_health > 0 ? settings.player_health : playerHealth);
 	registry.colors.insert(player, { 1, 0.8f, 0.8f });
 
+	size_t line = 0;
+	for (const LevelSpawn& spawn : level.spawns) {
+		const float* p = spawn.params;
+		switch (spawn.type) {
+		case LEVEL_SPAWN::POTION:
+			createPotion(renderer, spawn.position, Heal);
+			break;
+		case LEVEL_SPAWN::BAT:
+			createBat(renderer, spawn.position, p[0]);
+			break;
+		case LEVEL_SPAWN::SKELETON:
+			registry.skeletonEnemy.get(createSkeleton(renderer, spawn.position, p[0], p[1])).stateChange = true;
+			break;
+		case LEVEL_SPAWN::WOLF:
+			createWolf(renderer, spawn.position, p[0], p[1]);
+			break;
+		case LEVEL_SPAWN::RANGED:
+			registry.rangedEnemy.get(createRangedEnemy(renderer, spawn.position, p[0], p[1], p[2] != 0.f)).stateChange = true;
+			break;
+		case LEVEL_SPAWN::WIZARD:
+			registry.wizards.get(createWizard(renderer, spawn.position, p[0], p[1], p[2] != 0.f)).stateChange = true;
+			break;
+		case LEVEL_SPAWN::SAW:
+			createSaw(renderer, spawn.position);
+			break;
+		case LEVEL_SPAWN::DEMON:
+			createDemon(renderer, spawn.position, p[0], p[1]);
+			break;
+		case LEVEL_SPAWN::GOLEM:
+			createGolem(renderer, spawn.position);
+			break;
+		case LEVEL_SPAWN::SIGN: {
+			Entity sign = createStatue(renderer, spawn.position);
+			std::vector<std::string>& lines = registry.readables.get(sign).lines;
+			lines.insert(lines.end(), level.lines.begin() + line, level.lines.begin() + line + spawn.line_count);
+			line += spawn.line_count;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+void WorldSystem::tutorial() {
+	gameStarted = true;
+	build_level(Tutorial);
+
 	// Player hearts
 	update_hearts();
 
-	// Potions
-	createPotion(renderer, { 1150, 885 }, Heal);
-
 	save_game();
 }
 
@@ -1685,173 +1720,11 @@ void WorldSystem::level_one() {
 	displayHonor = true;
 	gameStarted = true;
 	showBossHealth = false;
-	// Create floors and walls
-	// Divided into columns, then quadrants (A1 = top quadrant of leftmost column, H3 = bottom quadrant of rightmost column)
-	// Quadrants are 1280 x 1000 in size
-	background = createBackground(renderer, { window_width_px / 2.f, window_height_px / 2.f }, 2); // Background
-	background_cloud.clear();
-	background_tree.clear();
-
-	ghost_spawn_limit = 1;
-	set_ghost_spawn_cd = 3000;
-	ghost_spawn_cd = set_ghost_spawn_cd;
-
-	float cloud_rightEdge = cloud_width / 2.f;
-	while (cloud_rightEdge - cloud_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_cloud.push_back(createBackgroundCloud(
-			renderer, { cloud_rightEdge - cloud_width / 2.0f, cloud_height / 2.f }));
-		cloud_rightEdge += cloud_width;
-	}
-	float tree_rightEdge = tree_width / 2.f;
-	while (tree_rightEdge - tree_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_tree.push_back(createBackgroundTrees(
-			renderer, { tree_rightEdge - tree_width / 2.0f, window_height_px - tree_height / 2.f }));
-		tree_rightEdge += tree_width;
-	}
-
-	// Next level box
-	Entity nextLevel = createCustomTile(renderer, { 10290, 2530 }, { 70, 120 });
-	registry.tiles.remove(nextLevel);
-	registry.nextLevels.emplace(nextLevel);
-	registry.colors.insert(nextLevel, { 0.3f, 0.3f, 0.3f });
-
-	// A
-	tiles.push_back(createCustomTile(renderer, { 640, 1000 }, { 1280, 300 })); // Floor all the way down
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createVerticalTile(renderer, { -150, 500+1280*i }, { 300, 1280 }));// Left Wall all the way down
-	}
-
-	// B
-	for (int i = 0; i < 8; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 1620, 1000 + 300*i }, { 1280, 300 })); // Floor all the way down
-	}
-
-	// C
-	// C2
-	tiles.push_back(createCustomTile(renderer, { 3225, 1115 }, { 600, 40 })); // Top platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 2810, 1365 }, { 600, 40 })); // Second platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 3225, 1615 }, { 600, 40 })); // Third platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 2810, 1865 }, { 600, 40 })); // Fourth platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 3325, 2115 }, { 550, 40 })); // Last platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 2710, 2665 }, { 600, 720 })); // Tallest raised ground (DONE)
-	tiles.push_back(createCustomTile(renderer, { 2860, 2765 }, { 600, 480 })); // Middle raised ground (DONE)
-	tiles.push_back(createCustomTile(renderer, { 3050, 2865 }, { 600, 480 })); // Lowest raised ground (DONE)
-	tiles.push_back(createVerticalLongTile(renderer, { 2410, 2130 }, { 300, 2560 }));// Left Wall all the way down
-
-	// C3
-	tiles.push_back(createCustomTile(renderer, { 3200, 3000 }, { 1300, 320 })); // Bottom floor (DONE)
-
-	// D
-	for (int i = 0; i < 4; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 4300, 1000 + 300*i }, { 1280, 300 })); // Floor all the way down
-	}
-	tiles.push_back(createVerticalTile(renderer, { 3510, 1510 }, { 300, 1300 }));// Left Wall all the way down
-	tiles.push_back(createCustomTile(renderer, { 4000, 1000 }, { 1280, 300 })); // Floor all the way down
-
-	// D3
-	tiles.push_back(createCustomTile(renderer, { 4170, 2960 }, { 650, 240 })); // Left bottom floor (DONE)
-	tiles.push_back(createCustomTile(renderer, { 5210, 2960 }, { 650, 240 })); // Right bottom floor (DONE)
-
-	// E
-	tiles.push_back(createCustomTile(renderer, { 5280, 1000 }, { 1280, 300 }));
-	tiles.push_back(createCustomTile(renderer, { 6560, 1000 }, { 1280, 300 }));
-	for (int i = 0; i < 4; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 6800, 950 + 200*i }, { 1280, 200 }));
-	}
-	tiles.push_back(createCustomTile(renderer, { 8350, 1115 }, { 600, 40 })); // First platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 7780, 1365 }, { 600, 40 })); // Second platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 8400, 1615 }, { 600, 40 })); // Third platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 7780, 1870 }, { 600, 40 })); // Fourth platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 8400, 2115 }, { 600, 40 })); // Fifth platform (DONE)
-	tiles.push_back(createCustomTile(renderer, { 7780, 2365 }, { 600, 40 })); // Sixth platform (DONE)
-	tiles.push_back(createVerticalTile(renderer, { 7590, 1380 }, { 300, 1060 }));// Left Wall all the way down
-
-	// E3
-	tiles.push_back(createCustomTile(renderer, { 5400, 2960 }, { 700, 240 })); // Left bottom floor (DONE)
-
-	// F3
-	tiles.push_back(createCustomTile(renderer, { 6800, 2960 }, { 1500, 240 })); // Left bottom floor (DONE)
-
-	// G3
-	tiles.push_back(createCustomTile(renderer, { 8440, 2725 }, { 1280, 300 })); // Platform
-
-	// H
-	for (int i = 0; i < 4; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 9600, 1000 + 300*i }, { 1800, 300 })); // Floor all the way down
-	}
-	tiles.push_back(createVerticalTile(renderer, { 8550, 1505 }, { 300, 1310 }));// Left Wall all the way down
-	tiles.push_back(createCustomTile(renderer, { 9140, 2725 }, { 1280, 300 })); // Floor from middle of H3 to bottom
-	tiles.push_back(createCustomTile(renderer, { 10420, 2725 }, { 1280, 300 }));
-	for (int i = 0; i < 3; i++)
-	{
-		tiles.push_back(createVerticalTile(renderer, { 10400, 500 + 1280 * i }, { 300, 1280 }));// Right Wall down to level exit
-	}
-	for (Entity tile : tiles) {
-		registry.colors.insert(tile, { 0.3f, 0.3f, 0.3f });
-	}
-
-	createDoor(renderer, { 10250, 2525 }, { 70, 100 }); // Door to next level
-
-	// Deathbox
-	Entity deathbox = createCustomTile(renderer, { 5120, 5000 }, { 10240, 4000 });
-	registry.tiles.remove(deathbox);
-	registry.deathboxes.emplace(deathbox);
-	registry.colors.insert(deathbox, { 0.f, 0.f, 0.f });
-
-	// Enemy sign
-	Entity sign1 = createStatue(renderer, { 400, 800 });
-	registry.readables.get(sign1).lines.push_back("The path ahead rewards the righteous.");
-	registry.readables.get(sign1).lines.push_back("Defeating foes reclaims thy honor.");
-	registry.readables.get(sign1).lines.push_back("Honor glows a different shade with each milestone.");
-	registry.readables.get(sign1).lines.push_back("Raise thy honor level to receive boons in the future.");
-
-	//Player
-	player = createPlayer(renderer, { 100,800 }, playerHealth);
-	registry.colors.insert(player, { 1, 0.8f, 0.8f });
+	build_level(LevelOne);
 
 	// Player hearts
 	update_hearts();
 
-	// Potions
-	createPotion(renderer, { 10200, 835 }, Heal);
-	createPotion(renderer, { 5500, 2871 }, Heal);
-	createPotion(renderer, { 3320, 2080 }, Heal);
-
-	// Bats
-	createBat(renderer, { 4500,2600 }, 150);
-	createBat(renderer, { 5900,2600 }, 150);
-
-	// Skeletons
-	Entity skeleton1 = createSkeleton(renderer, { 800,775 }, 200, 500); //start position (x,y), attack range, roaming range
-	Entity skeleton2 = createSkeleton(renderer, { 1500,775 }, 200, 500); //start position (x,y), attack range, roaming range
-	Entity skeleton3 = createSkeleton(renderer, { 5500,775 }, 200, 600); //start position (x,y), attack range, roaming range
-	Entity skeleton4 = createSkeleton(renderer, { 5300,2770 }, 200, 300); //start position (x,y), attack range, roaming range
-	registry.skeletonEnemy.get(skeleton1).stateChange = true;
-	registry.skeletonEnemy.get(skeleton2).stateChange = true;
-	registry.skeletonEnemy.get(skeleton3).stateChange = true;
-	registry.skeletonEnemy.get(skeleton4).stateChange = true;
-
-	createWolf(renderer, { 7000, 800 }, 400, 2000);
-	createWolf(renderer, { 9200, 800 }, 400, 2000);
-	createWolf(renderer, { 6900, 2795 }, 400, 2000);
-
-	// Mushrooms
-	Entity rangedEnemy1 = createRangedEnemy(renderer, { 3800, 780 }, 500, 600, true); //start position (x,y), attack range, roaming range, STATIONARY?
-	Entity rangedEnemy2 = createRangedEnemy(renderer, { 7780, 2275 }, 500, 600, true); //start position (x,y), attack range, roaming range, STATIONARY?
-	registry.rangedEnemy.get(rangedEnemy1).stateChange = true;
-	registry.rangedEnemy.get(rangedEnemy2).stateChange = true;
-
-	Motion& temp = registry.motions.get(player);
-
 	save_game();
 }
 
@@ -1859,212 +1732,11 @@ void WorldSystem::level_two() {
 	displayHonor = true;
 	gameStarted = true;
 	showBossHealth = false;
-	// Create floors and walls
-	// Divided into columns, then quadrants (A1 = top quadrant of leftmost column, H3 = bottom quadrant of rightmost column)
-	// Quadrants are 1280 x 1000 in size
-	background = createBackground(renderer, { window_width_px / 2.f, window_height_px / 2.f }, 3); // Background
-	background_cloud.clear();
-	background_tree.clear();
-
-	ghost_spawn_limit = 3;
-	set_ghost_spawn_cd = 6000;
-	ghost_spawn_cd = set_ghost_spawn_cd;
-
-	float cloud_rightEdge = cloud_width / 2.f;
-	while (cloud_rightEdge - cloud_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_cloud.push_back(createBackgroundCloud(
-			renderer, { cloud_rightEdge - cloud_width / 2.0f, cloud_height / 2.f }));
-		cloud_rightEdge += cloud_width;
-	}
-	float tree_rightEdge = tree_width / 2.f;
-	while (tree_rightEdge - tree_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_tree.push_back(createBackgroundTrees(
-			renderer, { tree_rightEdge - tree_width / 2.0f, window_height_px - tree_height / 2.f }));
-		tree_rightEdge += tree_width;
-	}
-
-	// Next level box
-	Entity nextLevel = createCustomTile(renderer, { 7240, 1955 }, { 70, 120 });
-	registry.tiles.remove(nextLevel);
-	registry.nextLevels.emplace(nextLevel);
-	registry.colors.insert(nextLevel, { 0.3f, 0.3f, 0.3f });
-
-	// A
-	tiles.push_back(createVerticalLongTile(renderer, { -300, 900 }, { 600, 2400 })); // Left Wall all the way down (DONE)
-	// A1
-	tiles.push_back(createCustomTile(renderer, { 640, 950 }, { 1280, 300 })); // Floor (DONE)
-	// A2-A4
-	tiles.push_back(createCustomTile(renderer, { 725, 1975 }, { 1450, 300 })); // Floor (DONE)
-	
-	// B platforms
-	tiles.push_back(createCustomTile(renderer, { 2450, 1100 }, { 600, 40 })); // Top platform
-	tiles.push_back(createCustomTile(renderer, { 1750, 1350 }, { 600, 40 })); // Second platform
-	tiles.push_back(createCustomTile(renderer, { 2450, 1600 }, { 600, 40 })); // Third platform
-	tiles.push_back(createCustomTile(renderer, { 1750, 1845 }, { 600, 40 })); // Fourth platform
-	tiles.push_back(createCustomTile(renderer, { 2450, 2125 }, { 600, 40 })); // Fifth platform
-	tiles.push_back(createCustomTile(renderer, { 1750, 2375 }, { 600, 40 })); // Sixth platform
-	tiles.push_back(createCustomTile(renderer, { 2275, 2625 }, { 400, 40 })); // Seventh platform 
-	tiles.push_back(createCustomTile(renderer, { 2650, 3070 }, { 600, 40 })); // Fifth platform
-
-	// B1
-	tiles.push_back(createCustomTile(renderer, { 2100, 600 }, { 600, 40 })); // Platform
-	// B1/B2
-	tiles.push_back(createVerticalTile(renderer, { 1480, 1095 }, { 400, 590 })); // Wall
-	tiles.push_back(createCustomTile(renderer, { 1650, 1865 }, { 400, 80 })); // Fourth platform
-	// B3 raised floors
-	tiles.push_back(createCustomTile(renderer, { 2000, 3550 }, { 400, 560 })); // Taller raised floor
-	tiles.push_back(createCustomTile(renderer, { 2255, 3700 }, { 400, 310 })); // Lower raised floor
-	tiles.push_back(createVerticalLongTile(renderer, { 1600, 2905 }, { 500, 2000 })); // Left Wall all the way down (DONE)
-
-	// C1/C2
-	tiles.push_back(createVerticalTile(renderer, { 2700, 1480 }, { 400, 1360 })); // Wall
-
-	// D
-	// D2
-	tiles.push_back(createCustomTile(renderer, { 5600, 2175 }, { 300, 40 })); // Level 2 platform 
-	// D3
-	tiles.push_back(createCustomTile(renderer, { 5560, 2725 }, { 150, 160 })); // Level 3 platform 
-
-	// E
-	// E2
-	tiles.push_back(createCustomTile(renderer, { 6600, 2175 }, { 300, 40 })); // Level 2 platform 
-	// E3
-	tiles.push_back(createCustomTile(renderer, { 6475, 2725 }, { 150, 160 })); // Level 3 platform 
-
-	// F4
-	tiles.push_back(createVerticalTile(renderer, { 7800, 3445 }, { 300, 710 })); // Wall
-
-	// G platforms
-	tiles.push_back(createCustomTile(renderer, { 8650, 1100 }, { 600, 40 })); // Top platform
-	tiles.push_back(createCustomTile(renderer, { 8200, 1350 }, { 300, 40 })); // Second platform
-	tiles.push_back(createCustomTile(renderer, { 8650, 1600 }, { 600, 40 })); // Third platform
-	tiles.push_back(createCustomTile(renderer, { 8200, 1865 }, { 300, 40 })); // Fourth platform
-	tiles.push_back(createCustomTile(renderer, { 8750, 2125 }, { 600, 40 })); // Fifth platform
-	tiles.push_back(createCustomTile(renderer, { 8200, 2360 }, { 300, 40 })); // Sixth platform
-	tiles.push_back(createCustomTile(renderer, { 8750, 2725 }, { 600, 360 })); // Seventh platform
-
-	// H
-	// H3
-	tiles.push_back(createVerticalLongTile(renderer, { 9000, 1920 }, { 400, 2200 })); // Wall/Floor
-	tiles.push_back(createVerticalTile(renderer, { 9400,700 }, { 400, 1000 })); // Wall/Floor
-
-
-	// C1-D1 floor
-	tiles.push_back(createCustomTile(renderer, { 3400, 960 }, { 1200, 320 }));
-	// D1-E1 floor
-	tiles.push_back(createCustomTile(renderer, { 4600, 960 }, { 1200, 320 }));
-	// E1-F1 floor
-	tiles.push_back(createCustomTile(renderer, { 5800, 960 }, { 1200, 320 }));
-	// E1-F1 floor
-	tiles.push_back(createCustomTile(renderer, { 7000, 960 }, { 1200, 320 }));
-	// C2-D2 floor
-	tiles.push_back(createCustomTile(renderer, { 4860 - 1280 - 440, 2150 }, { 1280, 300 }));
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 4860 - i*1280, 2150 }, { 1280, 300 }));
-	}
-	// E2-F2 floor
-	tiles.push_back(createCustomTile(renderer, { 7175, 2080 }, { 850, 160 }));
-	tiles.push_back(createCustomTile(renderer, { 7425, 1920 }, { 350, 160 }));
-
-	// F
-	// F1/F2
-	tiles.push_back(createVerticalLongThickTile(renderer, { 7650, 1360 }, { 900, 1120 })); // Wall
-
-	// B3-D3 floor
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 3555 + i * 1280, 2935 }, { 1600, 300 }));
-	}
-	
-	// D3-E3 platform
-	tiles.push_back(createCustomTile(renderer, { 6100, 2425 }, { 300, 40 }));
-	// E3-H3 floor
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 7040 + i*1280, 2940 }, { 1280, 300 }));
-	}
-	
-	// B4-D4 floor
-	for (int i = 0; i < 3; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 2575 + i * 1280, 3950 }, { 1450, 300 }));
-	}
-	// E4-F4 floor
-	tiles.push_back(createCustomTile(renderer, { 7200, 3960 }, { 1500, 320 }));
-
-	for (Entity tile : tiles) {
-		registry.colors.insert(tile, { 0.3f, 0.3f, 0.3f });
-	}
-
-	// Deathbox
-	Entity deathbox = createCustomTile(renderer, { 6200, 13000 }, { 10240, 18000 });
-	registry.tiles.remove(deathbox);
-	registry.deathboxes.emplace(deathbox);
-	registry.colors.insert(deathbox, { 0.f, 0.f, 0.f });
-
-	createDoor(renderer, { 7200, 1945 }, { 70, 110 }); // Door to next level
-
-	//Player
-	player = createPlayer(renderer, { 100, 800 }, 3);
-	registry.colors.insert(player, { 1, 0.8f, 0.8f });
+	build_level(LevelTwo);
 
 	// Player hearts
 	update_hearts();
 
-	// Saws
-	createSaw(renderer, { 5450, 2750 });
-	createSaw(renderer, { 6600, 2750 });
-
-	// Potions
-	createPotion(renderer, { 700, 1810 }, Heal);
-	createPotion(renderer, { 2720, 3035 }, Heal);
-	createPotion(renderer, { 3200, 1980 }, Heal);
-	createPotion(renderer, { 5120, 780 }, Heal);
-	createPotion(renderer, { 8760, 2530 }, Heal);
-	createPotion(renderer, { 9060, 800 }, Heal);
-	createPotion(renderer, { 7450, 3780 }, Heal);
-
-	// Bats
-	createBat(renderer, { 1400,1600 }, 150);
-	createBat(renderer, { 7200,2600 }, 150);
-	createBat(renderer, { 5700,3600 }, 150);
-
-	// Wolves
-	createWolf(renderer, { 7200, 2740 }, 400, 2000);
-	createWolf(renderer, { 3800, 3750 }, 400, 2000);
-	createWolf(renderer, { 5100, 3750 }, 400, 2000);
-	createWolf(renderer, { 7100, 3750 }, 400, 2000);
-	
-	// Demon
-	float left_b = 2600.f;
-	float right_b = 7900.f;
-	createDemon(renderer, { 5120, 680 }, left_b + DEMON_WIDTH / 2.0f, right_b - DEMON_WIDTH / 2.0f);
-	
-	// Skeletons
-	Entity skeleton1 = createSkeleton(renderer, { 750,1750 }, 300, 200); //start position (x,y), attack range, roaming range
-	Entity skeleton2 = createSkeleton(renderer, { 4500,2710 }, 300, 600); //start position (x,y), attack range, roaming range
-	Entity skeleton3 = createSkeleton(renderer, { 3500,1925 }, 300, 600); //start position (x,y), attack range, roaming range
-	registry.skeletonEnemy.get(skeleton1).stateChange = true;
-	registry.skeletonEnemy.get(skeleton2).stateChange = true;
-	registry.skeletonEnemy.get(skeleton3).stateChange = true;
-
-	// Wizards
-	Entity wizard1 = createWizard(renderer, { 9000,770 }, 500, 600, true); //start position (x,y), attack range, roaming range, STATIONARY?
-	Entity wizard2 = createWizard(renderer, { 2100,530 }, 500, 600, true); //start position (x,y), attack range, roaming range, STATIONARY?
-	registry.wizards.get(wizard1).stateChange = true;
-	registry.wizards.get(wizard2).stateChange = true;
-
-	// Mushrooms
-	Entity rangedEnemy1 = createRangedEnemy(renderer, { 7450,3730 }, 500, 600, true); //start position (x,y), attack range, roaming range, STATIONARY?
-	registry.rangedEnemy.get(rangedEnemy1).stateChange = true;
-
-	Motion& temp = registry.motions.get(player);
-
 	save_game();
 }
 
@@ -2072,60 +1744,7 @@ void WorldSystem::buff_room() {
 	gameStarted = true;
 	displayHonor = false;
 	showBossHealth = false;
-
-	ghost_spawn_limit = 0;
-	set_ghost_spawn_cd = 6000;
-	ghost_spawn_cd = set_ghost_spawn_cd;
-
-	// Create floors and walls
-	// Divided into columns, then quadrants (A1 = top quadrant of leftmost column, H3 = bottom quadrant of rightmost column)
-	// Quadrants are 1280 x 1000 in size
-	background = createBackground(renderer, { window_width_px / 2.f, window_height_px / 2.f }, 1); // Background
-	background_cloud.clear();
-	background_tree.clear();
-	float cloud_rightEdge = cloud_width / 2.f;
-	while (cloud_rightEdge - cloud_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_cloud.push_back(createBackgroundCloud(
-			renderer, { cloud_rightEdge - cloud_width / 2.0f, cloud_height / 2.f }));
-		cloud_rightEdge += cloud_width;
-	}
-	float tree_rightEdge = tree_width / 2.f;
-	while (tree_rightEdge - tree_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_tree.push_back(createBackgroundTrees(
-			renderer, { tree_rightEdge - tree_width / 2.0f, window_height_px - tree_height / 2.f }));
-		tree_rightEdge += tree_width;
-	}
-
-	// Next level box
-	Entity nextLevel = createCustomTile(renderer, { 70, 370 }, { 60, 90 });
-	registry.tiles.remove(nextLevel);
-	registry.nextLevels.emplace(nextLevel);
-	registry.colors.insert(nextLevel, { 0.3f, 0.3f, 0.3f });
-
-	tiles.push_back(createCustomTile(renderer, { 640, 1050 }, { 1280, 300 })); // Floor all the way down
-	tiles.push_back(createCustomTile(renderer, { 1640, 1050 }, { 1280, 300 })); // Floor all the way down
-	tiles.push_back(createCustomTile(renderer, { 1100, 750 }, { 320, 80 })); // Lower platform
-	tiles.push_back(createCustomTile(renderer, { 720, 500 }, { 320, 80 })); // Higher platform
-	tiles.push_back(createCustomTile(renderer, { 1100, 250 }, { 320, 80 })); // Highest platform
-	tiles.push_back(createCustomTile(renderer, { 250, 500 }, { 640, 80 })); // Higher floor
-	tiles.push_back(createVerticalTile(renderer, { -50, 140 }, { 240, 640 })); // Higher floor wall
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createVerticalTile(renderer, { -150, 500 + 1280 * i }, { 300, 1280 }));// Left Wall all the way down
-	}
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createVerticalTile(renderer, { 1350, 500 + 1280 * i }, { 300, 1280 }));// Left Wall all the way down
-	}
-
-	createDoor(renderer, { 70, 410 }, { 70, 100 }); // Door to next level
-
-	createPedestal(renderer, { 1150, 875 });
-	createPedestal(renderer, { 1150, 185 });
+	build_level(BuffRoom);
 
 	// Attack buff sign
 	Entity sign1 = createStatue(renderer, { 1000, 850 });
@@ -2152,14 +1771,6 @@ void WorldSystem::buff_room() {
 		createAttackBuff(renderer, { 1150, 150 });
 	}
 
-	for (Entity tile : tiles) {
-		registry.colors.insert(tile, { 0.3f, 0.3f, 0.3f });
-	}
-
-	//Player
-	player = createPlayer(renderer, { 100, 880 }, playerHealth);
-	registry.colors.insert(player, { 1, 0.8f, 0.8f });
-
 	// Player hearts
 	update_hearts();
 
@@ -2167,62 +1778,14 @@ void WorldSystem::buff_room() {
 }
 
 void WorldSystem::level_three() {
-	// Create floors and walls
-	// Divided into columns, then quadrants (A1 = top quadrant of leftmost column, H3 = bottom quadrant of rightmost column)
-	// Quadrants are 1280 x 1000 in size
 	showBossHealth = true;
-	background = createBackground(renderer, { window_width_px / 2.f, window_height_px / 2.f }, 3); // Background
-	background_cloud.clear();
-	background_tree.clear();
 	// music
-	Mix_HaltChannel(0);
-	Mix_PlayChannel(1, boss_music, -1);
-	Mix_Volume(1, MIX_MAX_VOLUME / 10);
-
-	ghost_spawn_limit = 0;
-	set_ghost_spawn_cd = 10000;
-	ghost_spawn_cd = set_ghost_spawn_cd;
+	music.play(MUSIC_TRACK::BOSS);
+	build_level(LevelThree);
 
-	float cloud_rightEdge = cloud_width / 2.f;
-	while (cloud_rightEdge - cloud_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_cloud.push_back(createBackgroundCloud(
-			renderer, { cloud_rightEdge - cloud_width / 2.0f, cloud_height / 2.f }));
-		cloud_rightEdge += cloud_width;
-	}
-	float tree_rightEdge = tree_width / 2.f;
-	while (tree_rightEdge - tree_width * 2.f < window_width_px)
-	{
-		// fill the sky with clouds
-		background_tree.push_back(createBackgroundTrees(
-			renderer, { tree_rightEdge - tree_width / 2.0f, window_height_px - tree_height / 2.f }));
-		tree_rightEdge += tree_width;
-	}
-
-	// Next level box
-	Entity nextLevel = createCustomTile(renderer, { 7240, 1955 }, { 70, 120 });
-	registry.tiles.remove(nextLevel);
-	registry.nextLevels.emplace(nextLevel);
-	registry.colors.insert(nextLevel, { 0.3f, 0.3f, 0.3f });
-
-	// A
-	tiles.push_back(createVerticalLongTile(renderer, { -265, 500 }, { 850, 2000 })); // Left Wall all the way down (DONE)
-	// A1
-	for (int i = 0; i < 2; i++)
-	{
-		tiles.push_back(createCustomTile(renderer, { 800+1280*i, 1000 }, { 1280, 400 })); // Floor (DONE)
+	if (registry.golem.size() > 0) {
+		bossHealth = registry.golem.components[0].health;
 	}
-	tiles.push_back(createVerticalLongTile(renderer, { 3145, 500 }, { 850, 2000 })); // Left Wall all the way down (DONE)
-	// platforms
-	tiles.push_back(createCustomTile(renderer, { 1000, 600 }, { 500, 40 }));
-	tiles.push_back(createCustomTile(renderer, { 2000, 600 }, { 500, 40 }));
-
-	Entity Boss = createGolem(renderer, { 1500, 500 });
-	bossHealth = registry.golem.get(Boss).health;
-
-	player = createPlayer(renderer, { 300, 700 }, playerHealth);
-	registry.colors.insert(player, { 1, 0.8f, 0.8f });
 
 	Player& p = registry.players.get(player);
 
@@ -2350,7 +1913,7 @@ void WorldSystem::handle_collisions() {
 					{
 						registry.golem.get(entity_other).health -= registry.players.get(registry.players.entities[0]).damage;
 						bossHealth -= registry.players.get(registry.players.entities[0]).damage;
-						Mix_PlayChannel(-1, enemy_take_damage, 0);
+						sounds.play(SOUND_ID::ENEMY_TAKE_DAMAGE);
 					}
 
 					// kill enemy
@@ -2380,11 +1943,11 @@ void WorldSystem::handle_collisions() {
 						if (registry.demonBoss.get(entity_other).immunity_duration <= 0.f)
 						{
 							registry.demonBoss.get(entity_other).health -= registry.players.get(registry.players.entities[0]).damage;
-							Mix_PlayChannel(-1, enemy_take_damage, 0);
+							sounds.play(SOUND_ID::ENEMY_TAKE_DAMAGE);
 						}
 						// kill enemy
 						if (registry.demonBoss.get(entity_other).health <= 0) {
-							Mix_PlayChannel(-1, boss_death_sound, 0);
+							sounds.play(SOUND_ID::BOSS_DEATH);
 							registry.demonBoss.get(entity_other).changeState("dead", true);
 							honorGained += registry.demonBoss.get(entity_other).honor;
 						}
@@ -2398,7 +1961,7 @@ void WorldSystem::handle_collisions() {
 				// attack collision on ghost
 				if (registry.ghostEnemy.has(entity_other))
 				{
-					Mix_PlayChannel(-1, enemy_take_damage, 0);
+					sounds.play(SOUND_ID::ENEMY_TAKE_DAMAGE);
 					registry.remove_all_components_of(entity_other);
 				}
 
@@ -2407,7 +1970,7 @@ void WorldSystem::handle_collisions() {
 				if (registry.wolfEnemy.has(entity_other)) {
 					if (registry.wolfEnemy.get(entity_other).immunity_duration_ms <= 0) {
 						registry.wolfEnemy.get(entity_other).health -= registry.players.get(registry.players.entities[0]).damage;
-						Mix_PlayChannel(-1, enemy_take_damage, 0);
+						sounds.play(SOUND_ID::ENEMY_TAKE_DAMAGE);
 
 						// kill enemy
 						if (registry.wolfEnemy.get(entity_other).health <= 0) {
@@ -2429,7 +1992,7 @@ void WorldSystem::handle_collisions() {
 
 				// ATTACK COLLISION ON RANGED ENEMY
 				if (registry.rangedEnemy.has(entity_other)) {
-					Mix_PlayChannel(-1, enemy_take_damage, 0);
+					sounds.play(SOUND_ID::ENEMY_TAKE_DAMAGE);
 					honorGained += registry.rangedEnemy.get(entity_other).honor;
 					registry.remove_all_components_of(entity_other);
 				}
@@ -2439,7 +2002,7 @@ void WorldSystem::handle_collisions() {
 				{
 					if (registry.skeletonEnemy.get(entity_other).immunity_duration_ms <= 0) {
 						registry.skeletonEnemy.get(entity_other).health -= registry.players.get(registry.players.entities[0]).damage;
-						Mix_PlayChannel(-1, enemy_take_damage, 0);
+						sounds.play(SOUND_ID::ENEMY_TAKE_DAMAGE);
 
 						// kill enemy
 						if (registry.skeletonEnemy.get(entity_other).health <= 0) {
@@ -2476,7 +2039,7 @@ void WorldSystem::handle_collisions() {
 							registry.wizards.get(entity_other).changeState("attack1", false);
 							registry.wizards.get(entity_other).changeState("attack2", false);
 						}
-						Mix_PlayChannel(-1, enemy_take_damage, 0);
+						sounds.play(SOUND_ID::ENEMY_TAKE_DAMAGE);
 					}
 					// kill enemy
 					if (registry.wizards.get(entity_other).health <= 0 && registry.wizards.get(entity_other).getCurrState() != "dead") {
@@ -2496,7 +2059,7 @@ void WorldSystem::handle_collisions() {
 				{
 					if (registry.batEnemy.get(entity_other).immunity_duration_ms <= 0) {
 						registry.batEnemy.get(entity_other).health -= registry.players.get(registry.players.entities[0]).damage;
-						Mix_PlayChannel(-1, enemy_take_damage, 0);
+						sounds.play(SOUND_ID::ENEMY_TAKE_DAMAGE);
 
 						// kill enemy
 						if (registry.batEnemy.get(entity_other).health <= 0) {
@@ -2523,7 +2086,7 @@ void WorldSystem::handle_collisions() {
 						registry.players.get(player).changeState("death", true);
 						movingLeft = false;
 						movingRight = false;
-						Mix_PlayChannel(-1, player_death_sound, 0);
+						sounds.play(SOUND_ID::PLAYER_DEATH);
 					}
 				}
 
@@ -2536,7 +2099,7 @@ void WorldSystem::handle_collisions() {
 						registry.motions.get(entity).velocity.x = 0; // Fixes issue that makes camera keep moving after player death
 						movingLeft = false;
 						movingRight = false;
-						Mix_PlayChannel(-1, player_death_sound, 0);
+						sounds.play(SOUND_ID::PLAYER_DEATH);
 					}
 				}
 
@@ -2566,12 +2129,12 @@ void WorldSystem::handle_collisions() {
 						ghost_spawn_cd = 0;
 						registry.nextLevelTimers.emplace(entity);
 						registry.nextLevelTimers.get(entity).counter_ms = 2000;
-						Mix_PlayChannel(-1, next_area_sound, 0);
+						sounds.play(SOUND_ID::NEXT_AREA);
 					}
 				}
 				// Check potion collisions
 				else if (registry.potions.has(entity_other)) {
-					Mix_PlayChannel(-1, player_heal_sound, 0);
+					sounds.play(SOUND_ID::PLAYER_HEAL);
 
 					auto& player = registry.players.get(entity);
 					if (player.health < 3 || player.shield < 3) {
@@ -2589,7 +2152,7 @@ void WorldSystem::handle_collisions() {
 						player.immunity_duration_ms = 1000.f;
 						update_health(-registry.armProjectile.get(entity_other).damage);
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 
@@ -2600,7 +2163,7 @@ void WorldSystem::handle_collisions() {
 						player.immunity_duration_ms = 1000.f;
 						update_health(-registry.energyProjectile.get(entity_other).damage);
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 
@@ -2611,7 +2174,7 @@ void WorldSystem::handle_collisions() {
 						player.immunity_duration_ms = 1000.f;
 						update_health(-registry.magicBalls1.get(entity_other).damage);
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 
@@ -2622,7 +2185,7 @@ void WorldSystem::handle_collisions() {
 						player.immunity_duration_ms = 1000.f;
 						update_health(-registry.magicBalls2.get(entity_other).damage);
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 				
@@ -2633,7 +2196,7 @@ void WorldSystem::handle_collisions() {
 						player.immunity_duration_ms = 1000.f;
 						update_health(-registry.wolfEnemy.get(entity_other).damage);
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 
@@ -2644,12 +2207,12 @@ void WorldSystem::handle_collisions() {
 						player.immunity_duration_ms = 1000.f;
 						update_health(-registry.ghostEnemy.get(entity_other).damage);
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 
 				else if (registry.buffs.has(entity_other)) {
-					Mix_PlayChannel(-1, player_buff_sound, 0);
+					sounds.play(SOUND_ID::PLAYER_BUFF);
 					if (registry.buffs.get(entity_other).buff_type == "attack") {
 						registry.players.get(player).damage = 2;
 						attackBuffGained = true;
@@ -2669,7 +2232,7 @@ void WorldSystem::handle_collisions() {
 						update_health(-registry.batEnemy.get(entity_other).damage);
 						player.immunity_duration_ms = 1000.f;
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 				// checking fireball - player collision
@@ -2679,7 +2242,7 @@ void WorldSystem::handle_collisions() {
 						update_health(-registry.fireBalls.get(entity_other).damage);
 						player.immunity_duration_ms = 1000.f;
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 				// checking skeleton - player collision
@@ -2689,7 +2252,7 @@ void WorldSystem::handle_collisions() {
 						update_health(-registry.skeletonEnemy.get(entity_other).damage);
 						player.immunity_duration_ms = 1000.f;
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 				else if (registry.saws.has(entity_other)) {
@@ -2698,7 +2261,7 @@ void WorldSystem::handle_collisions() {
 						update_health(-1);
 						player.immunity_duration_ms = 1000.f;
 						if (player.health >= 0)
-							Mix_PlayChannel(-1, player_take_damage, 0);
+							sounds.play(SOUND_ID::PLAYER_TAKE_DAMAGE);
 					}
 				}
 				// Checking Player - Tile collisions
@@ -2975,7 +2538,7 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 		 // isJumping set so player can't jump in midair
 		 if (action == GLFW_PRESS && key == GLFW_KEY_W && registry.motions.get(player).isJumping != true && 
 			 registry.motions.get(player).velocity.y >= 0 && !registry.rollTimers.has(player) && !playerIsReading) {
-			 Mix_PlayChannel(-1, player_jump_sound, 0);
+			 sounds.play(SOUND_ID::PLAYER_JUMP);
 			 registry.motions.get(player).isJumping = true;
 			 registry.players.get(player).changeState("jump", true, false);
 			 registry.motions.get(player).velocity.y = -16.0f;
@@ -2983,7 +2546,7 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 
 		 if (key == GLFW_KEY_SPACE && action == GLFW_PRESS && !registry.rollTimers.has(player) && (registry.motions.get(player).velocity.y <= 0.5 && 
 			 registry.motions.get(player).velocity.y >= -0.5) && !playerIsReading) {
-			 Mix_PlayChannel(-1, player_roll_sound, 0);
+			 sounds.play(SOUND_ID::PLAYER_ROLL);
 			 registry.rollTimers.emplace(player);
 			 registry.players.get(player).changeState("roll", true);
 			 if (previousKeyA) {
@@ -3025,16 +2588,10 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 	if (action == GLFW_RELEASE && key == GLFW_KEY_ESCAPE) {
 		save_game();
 
-		cleanup();
-
-		// Remove all screenStates
-		while (registry.screenStates.entities.size() > 0)
-			registry.remove_all_components_of(registry.screenStates.entities.back());
-
-		// Debugging for memory/component leaks
-		registry.list_all_components();
-
-		exit(0);
+		// Let the main loop end so the render thread is joined before the
+		// systems clean up in their destructors
+		glfwSetWindowShouldClose(window, GLFW_TRUE);
+		return;
 	}
 
 	// Resetting game
@@ -3060,6 +2617,15 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 		load_game_save();
 	}
 
+	// Quick save and quick load the whole world
+	if (action == GLFW_RELEASE && key == GLFW_KEY_F5) {
+		quick_save();
+	}
+
+	if (action == GLFW_RELEASE && key == GLFW_KEY_F9) {
+		quick_load();
+	}
+
 	// Restart level
 	if (action == GLFW_RELEASE && key == GLFW_KEY_C) {
 		int w, h;
@@ -3093,196 +2659,15 @@ void WorldSystem::on_mouse_move(vec2 mouse_position) {
 }
 
 void WorldSystem::cleanup() {
+	// Every entity but the screen state belongs to the level. Emptying the
+	// containers whole leaves the same registry as removing the entities one
+	// by one, without a lookup per entity in every container.
+	registry.clear_all_components_except(registry.screenStates);
 
-	// Remove all deathTimers
-	while (registry.deathTimers.entities.size() > 0)
-		registry.remove_all_components_of(registry.deathTimers.entities.back());
-	printf("Cleaned Deathtimers\n");
+	// The parallax strips belong to the level
+	renderer->setParallaxLayers({});
 
-	while (registry.motions.entities.size() > 0)
-		registry.remove_all_components_of(registry.motions.entities.back());
-	printf("Cleaned Motions\n");
-
-	// Remove all collisions
-	while (registry.collisions.entities.size() > 0)
-		registry.remove_all_components_of(registry.collisions.entities.back());
-	printf("Cleaned Collisions\n");
-
-	// Remove all players
-	while (registry.players.entities.size() > 0)
-		registry.remove_all_components_of(registry.players.entities.back());
-	printf("Cleaned Players\n");
-
-	// Remove all meshPtrs
-	while (registry.meshPtrs.entities.size() > 0)
-		registry.remove_all_components_of(registry.meshPtrs.entities.back());
-	printf("Cleaned meshPtrs\n");
-
-	// Remove all renderRequests
-	while (registry.renderRequests.entities.size() > 0)
-		registry.remove_all_components_of(registry.renderRequests.entities.back());
-	printf("Cleaned renderRequests\n");
-
-	// Remove all eatables
-	while (registry.eatables.entities.size() > 0)
-		registry.remove_all_components_of(registry.eatables.entities.back());
-	printf("Cleaned eatables\n");
-
-	// Remove all deadlys
-	while (registry.deadlys.entities.size() > 0)
-		registry.remove_all_components_of(registry.deadlys.entities.back());
-	printf("Cleaned deadlys\n");
-
-	// Remove all debugComponents
-	while (registry.debugComponents.entities.size() > 0)
-		registry.remove_all_components_of(registry.debugComponents.entities.back());
-	printf("Cleaned debugComponents\n");
-
-	// Remove all colors
-	while (registry.colors.entities.size() > 0)
-		registry.remove_all_components_of(registry.colors.entities.back());
-	printf("Cleaned colors\n");
-
-	// Remove all background
-	while (registry.background.entities.size() > 0)
-		registry.remove_all_components_of(registry.background.entities.back());
-	printf("Cleaned background\n");
-
-	// Remove all tiles
-	while (registry.tiles.entities.size() > 0)
-		registry.remove_all_components_of(registry.tiles.entities.back());
-	printf("Cleaned tiles\n");
-
-	// Remove all deathboxes
-	while (registry.deathboxes.entities.size() > 0)
-		registry.remove_all_components_of(registry.deathboxes.entities.back());
-	printf("Cleaned deathboxes\n");
-	
-	// Remove all potions
-	while (registry.potions.entities.size() > 0)
-		registry.remove_all_components_of(registry.potions.entities.back());
-	printf("Cleaned potions\n");
-
-	// Remove all batEnemy
-	while (registry.batEnemy.entities.size() > 0)
-		registry.remove_all_components_of(registry.batEnemy.entities.back());
-	printf("Cleaned Bat Enemy\n");
-
-	// Remove all skelentonEnemy
-	while (registry.skeletonEnemy.entities.size() > 0)
-		registry.remove_all_components_of(registry.skeletonEnemy.entities.back());
-	printf("Cleaned Skelenton Enemy\n");
-
-	// Remove all demon
-	while (registry.demonBoss.entities.size() > 0)
-		registry.remove_all_components_of(registry.demonBoss.entities.back());
-	printf("Cleaned Demon Enemy\n");
-
-	// Remove all wolfEnemy
-	while (registry.wolfEnemy.entities.size() > 0)
-		registry.remove_all_components_of(registry.wolfEnemy.entities.back());
-	printf("Cleaned Wolf Enemy\n");
-
-	// Remove all ghostEnemy
-	while (registry.ghostEnemy.entities.size() > 0)
-		registry.remove_all_components_of(registry.ghostEnemy.entities.back());
-	printf("Cleaned ghostEnemy \n");
-
-	// Remove all golem
-	while (registry.golem.entities.size() > 0)
-		registry.remove_all_components_of(registry.golem.entities.back());
-	printf("Cleaned golem \n");
-
-	// Remove all arm projectiles
-	while (registry.armProjectile.entities.size() > 0)
-		registry.remove_all_components_of(registry.armProjectile.entities.back());
-	printf("Cleaned armProjectile \n");
-
-	// Remove all energy projectiles
-	while (registry.energyProjectile.entities.size() > 0)
-		registry.remove_all_components_of(registry.energyProjectile.entities.back());
-	printf("Cleaned energyProjectile \n");
-
-	// Remove all player_attack1
-	while (registry.player_attack1.entities.size() > 0)
-		registry.remove_all_components_of(registry.player_attack1.entities.back());
-	printf("Cleaned Player Attack1\n");
-
-	// Remove all player_attack2
-	while (registry.player_attack2.entities.size() > 0)
-		registry.remove_all_components_of(registry.player_attack2.entities.back());
-	printf("Cleaned Player Attack2\n");
-
-	// Remove all player_health
-	while (registry.player_health.entities.size() > 0)
-		registry.remove_all_components_of(registry.player_health.entities.back());
-	printf("Cleaned Player Health\n");
-		
-	// Remove all readables
-	while (registry.readables.entities.size() > 0)
-		registry.remove_all_components_of(registry.readables.entities.back());
-	printf("Cleaned readables\n");
-
-	// Remove all doors
-	while (registry.doors.entities.size() > 0)
-		registry.remove_all_components_of(registry.doors.entities.back());
-	printf("Cleaned doors\n");
-
-	// Remove all doors
-	while (registry.saws.entities.size() > 0)
-		registry.remove_all_components_of(registry.saws.entities.back());
-	printf("Cleaned saws\n");
-
-	// Remove all texts
-	while (registry.texts.entities.size() > 0)
-		registry.remove_all_components_of(registry.texts.entities.back());
-	printf("Cleaned Texts\n");
-
-	// Remove all roll timers
-	while (registry.rollTimers.entities.size() > 0)
-		registry.remove_all_components_of(registry.rollTimers.entities.back());
-	printf("Cleaned roll timers\n");
-
-	// Remove all ranged enemies
-	while (registry.rangedEnemy.entities.size() > 0)
-		registry.remove_all_components_of(registry.rangedEnemy.entities.back());
-	printf("Cleaned ranged enemy\n");
-
-	// Remove all fireballs
-	while (registry.fireBalls.entities.size() > 0)
-		registry.remove_all_components_of(registry.fireBalls.entities.back());
-	printf("Cleaned fireballs\n");
-
-	// Remove all fireballs
-	while (registry.shields.entities.size() > 0)
-		registry.remove_all_components_of(registry.shields.entities.back());
-	printf("Cleaned shields\n");
-
-	// Remove all attackPathTimers
-	while (registry.attackPathTimers.entities.size() > 0)
-		registry.remove_all_components_of(registry.attackPathTimers.entities.back());
-	printf("Cleaned fireballs\n");
-
-	while (registry.buffs.entities.size() > 0)
-		registry.remove_all_components_of(registry.buffs.entities.back());
-	printf("Cleaned buffs\n");
-	
-
-	// Remove all Wizards
-	while (registry.wizards.entities.size() > 0)
-		registry.remove_all_components_of(registry.wizards.entities.back());
-	printf("Cleaned wizards\n");
-
-	// Remove all magicBalls1
-	while (registry.magicBalls1.entities.size() > 0)
-		registry.remove_all_components_of(registry.magicBalls1.entities.back());
-	printf("Cleaned magicBalls1\n");
-
-	// Remove all magicBalls1
-	while (registry.magicBalls2.entities.size() > 0)
-		registry.remove_all_components_of(registry.magicBalls2.entities.back());
-	printf("Cleaned magicBalls1\n");
-	
 	// Debugging for memory/component leaks
-	registry.list_all_components();
+	if (debugging.in_debug_mode)
+		registry.list_all_components();
 }
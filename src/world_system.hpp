@@ -4,6 +4,9 @@
 #include "common.hpp"
 
 // stlib
+#include <future>
+#include <memory>
+#include <string>
 #include <vector>
 #include <random>
 
@@ -11,7 +14,11 @@
 #include <SDL.h>
 #include <SDL_mixer.h>
 
+#include "level_file.hpp"
+#include "music_system.hpp"
 #include "render_system.hpp"
+#include "save_writer.hpp"
+#include "sound_system.hpp"
 
 // Container for all our entities and game logic. Individual rendering / update is
 // deferred to the relative update() methods
@@ -23,8 +30,8 @@ public:
 	// Creates a window
 	GLFWwindow* create_window();
 
-	// starts the game
-	void init(RenderSystem* renderer);
+	// starts the game, false if the sounds failed to load
+	bool init(RenderSystem* renderer);
 
 	// Releases all associated resources
 	~WorldSystem();
@@ -38,11 +45,20 @@ public:
 	// Should the game be over ?
 	bool is_over()const;
 
-	// draw debug bounding box
-	void drawDebugBoundingBox(const vec2& pos, const vec2& scale, vec3 color, float lineThickns);
+	// draw debug bounding box, see debug_draw.hpp
+	void drawDebugBoundingBox(const vec2& pos, const vec2& scale, vec3 color);
 
 	// draw dotted outline for mesh
-	void drawDebugDot(Entity& e, vec3 color, float lineThickns);
+	void drawDebugDot(Entity& e, vec3 color, float dotSize);
+
+	// also write game_save.bin next to the JSON, see save_writer.hpp
+	void set_binary_saves(bool enabled) { saves.setBinary(enabled); }
+
+	// Longest frame a level transition may take before it is reported
+	void set_transition_budget(float ms) { transition_budget_ms = ms; }
+	// Call once per frame with the frame's length, prints transitions whose
+	// longest frame went over the budget
+	void record_frame(float frame_ms);
 
 private:
 	// Input callback functions
@@ -65,15 +81,30 @@ private:
 	// Game state
 	void load_game_save();
 	void save_game();
+	SaveWriter saves;
+
+	// Whole world snapshots, see world_snapshot.hpp. Quick saves (F5, F9) are
+	// kept in memory and in quick_save.snapshot.
+	void quick_save();
+	void quick_load();
+	std::vector<unsigned char> take_snapshot();
+	bool restore_snapshot(const std::vector<unsigned char>& snapshot);
+	template <class A>
+	void serialize_world(A& a);
+	std::vector<unsigned char> quick_snapshot;
 	GameState game_state;
 	RenderSystem* renderer;
 	Entity player;
 	Entity background;
-	std::vector<Entity> background_cloud;
-	std::vector<Entity> background_tree;
-	Entity background_trees;
 	std::vector<Entity> tiles;
 
+	// Builds the level file of gs, see level_file.hpp, and its player
+	void build_level(GameState gs);
+	// Starts reading the level file of gs on the thread pool, so the switch
+	// to it only appends the finished arrays. No-op for states without one.
+	void stage_level(GameState gs);
+	GameState staged_state = Intro;
+	std::future<std::unique_ptr<LevelData>> staged_level;
 	void intro();
 	void firstCutscene();
 	void tutorial();
@@ -89,6 +120,18 @@ private:
 	void switch_state(GameState gs);
 	void cleanup();
 
+	// A transition runs from the start of the fade, or from the switch when
+	// there is none, to the frame after the switch
+	float transition_budget_ms = 1000.f / 30.f;
+	bool transition_tracking = false; // set by the first record_frame, skips startup
+	bool in_transition = false;
+	int transition_frames_after = -1; // frames recorded since the switch, -1 before it
+	float transition_max_ms = 0.f;
+	float transition_cleanup_ms = 0.f;
+	float transition_build_ms = 0.f;
+	bool transition_staged = false;
+	GameState transition_state = Intro;
+
 	// Render, player update frame
 	const float player_update_frame = 50.f;
 	float player_curr_frame = player_update_frame;
@@ -103,33 +146,13 @@ private:
 	const float camera_update_frame = 15.f;
 	float camera_curr_frame = camera_update_frame;
 
-	// Parallex background value
-	// larger the factor, slower the movement
-	const float cloud_width = 576.f, cloud_height = 324.f;
-	const float cloud_relative_speed_factor = 4.f; // relative to player's velocity
-	const float tree_width = 800.f, tree_height = 600.f;
-	const float tree_relative_speed_factor = 2.5f; // relative to player's velocity
-	float player_prev_position = -1000.f;
-	float player_position_derivative = 0.f; // real velocity
-
 	float ghost_spawn_cd = 0;
 	int ghost_spawn_limit = 0;
 	float set_ghost_spawn_cd = 0;
 
-	// music references
-	Mix_Chunk* player_death_sound;
-	Mix_Chunk* player_heal_sound;
-	Mix_Chunk* player_buff_sound;
-	Mix_Chunk* player_jump_sound;
-	Mix_Chunk* player_roll_sound;
-	Mix_Chunk* player_take_damage;
-	Mix_Chunk* enemy_take_damage;
-	Mix_Chunk* potion_disappear_sound;
-	Mix_Chunk* next_area_sound;
-	Mix_Chunk* boss_death_sound;
-	Mix_Chunk* background_music;
-	Mix_Chunk* boss_music;
-	Mix_Chunk* intro_music;
+	// music and sound effects
+	MusicSystem music;
+	SoundSystem sounds;
 
 	// C++ random number generator
 	std::default_random_engine rng;
@@ -0,0 +1,241 @@
+// Offline asset cooker, converts data/ into the pack read through asset_pack.hpp
+//
+//   asset_cook [data directory] [pack file]
+//
+// Textures are decoded to RGBA, OBJ meshes parsed, fonts rasterized at the
+// size the game uses and WAVs converted to the mixer's output format, so the
+// game does no parsing at all for anything found in the pack. Music is left
+// out, MusicSystem streams it from the files.
+
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+
+// internal
+#include "asset_pack.hpp"
+#include "font_atlas.hpp"
+#include "../ext/stb_image/stb_image.h"
+
+// stlib
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Must match RenderSystem::init and Mix_OpenAudio in WorldSystem::create_window
+const unsigned int font_pixel_size = 48;
+const int audio_frequency = 44100;
+const SDL_AudioFormat audio_format = AUDIO_S16SYS; // MIX_DEFAULT_FORMAT
+const int audio_channels = 2;
+
+// Streamed through Mix_LoadMUS, must match music_tracks in music_system.cpp
+const char* const music_track_names[] = { "intro", "background_music", "boss_music" };
+
+static bool is_music(const fs::path& file)
+{
+	for (const char* name : music_track_names)
+		if (file.stem() == name)
+			return true;
+	return false;
+}
+
+struct CookedEntry
+{
+	PackEntry entry;
+	std::vector<unsigned char> data;
+};
+
+static void append(std::vector<unsigned char>& out, const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	out.insert(out.end(), bytes, bytes + size);
+}
+
+static bool cook_texture(const std::string& path, CookedEntry& out)
+{
+	ivec2 size;
+	stbi_uc* pixels = stbi_load(path.c_str(), &size.x, &size.y, NULL, 4);
+	if (pixels == NULL)
+		return false;
+	append(out.data, pixels, (size_t)size.x * size.y * 4);
+	stbi_image_free(pixels);
+	out.entry.params[0] = size.x;
+	out.entry.params[1] = size.y;
+	return true;
+}
+
+static bool cook_mesh(const std::string& path, CookedEntry& out)
+{
+	Mesh mesh;
+	if (!Mesh::loadFromOBJFile(path, mesh.vertices, mesh.vertex_indices, mesh.original_size, mesh.samples))
+		return false;
+	append(out.data, &mesh.original_size, sizeof(vec2));
+	append(out.data, mesh.vertices.data(), sizeof(ColoredVertex) * mesh.vertices.size());
+	append(out.data, mesh.vertex_indices.data(), sizeof(uint16_t) * mesh.vertex_indices.size());
+	append(out.data, mesh.samples.data(), sizeof(vec2) * mesh.samples.size());
+	out.entry.params[0] = (uint32_t)mesh.vertices.size();
+	out.entry.params[1] = (uint32_t)mesh.vertex_indices.size();
+	out.entry.params[2] = (uint32_t)mesh.samples.size();
+	return true;
+}
+
+static bool cook_font(const std::string& path, CookedEntry& out)
+{
+	FontAtlas atlas;
+	if (!rasterize_font(path, font_pixel_size, atlas))
+		return false;
+	append(out.data, atlas.characters.data(), sizeof(Character) * atlas.characters.size());
+	append(out.data, atlas.pixels.data(), atlas.pixels.size());
+	out.entry.params[0] = atlas.size.x;
+	out.entry.params[1] = atlas.size.y;
+	out.entry.params[2] = font_pixel_size;
+	return true;
+}
+
+static bool cook_sound(const std::string& path, CookedEntry& out)
+{
+	SDL_AudioSpec spec;
+	Uint8* samples;
+	Uint32 length;
+	if (SDL_LoadWAV(path.c_str(), &spec, &samples, &length) == NULL)
+		return false;
+
+	SDL_AudioCVT cvt;
+	if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, audio_format, audio_channels, audio_frequency) < 0)
+	{
+		SDL_FreeWAV(samples);
+		return false;
+	}
+	std::vector<Uint8> buffer((size_t)length * (cvt.len_mult > 0 ? cvt.len_mult : 1));
+	memcpy(buffer.data(), samples, length);
+	SDL_FreeWAV(samples);
+	cvt.buf = buffer.data();
+	cvt.len = (int)length;
+	if (cvt.needed && SDL_ConvertAudio(&cvt) < 0)
+		return false;
+
+	append(out.data, buffer.data(), cvt.needed ? (size_t)cvt.len_cvt : (size_t)length);
+	out.entry.params[0] = audio_frequency;
+	out.entry.params[1] = audio_format;
+	out.entry.params[2] = audio_channels;
+	return true;
+}
+
+static size_t align16(size_t offset)
+{
+	return (offset + 15) & ~(size_t)15;
+}
+
+int main(int argc, char* argv[])
+{
+	const std::string data_dir = argc > 1 ? argv[1] : data_path();
+	const std::string pack_file = argc > 2 ? argv[2] : data_dir + "/assets.pack";
+
+	struct Folder
+	{
+		const char* name;
+		const char* extension;
+		PACK_ENTRY_TYPE type;
+		bool (*cook)(const std::string&, CookedEntry&);
+	};
+	const Folder folders[] = {
+		{ "textures", ".png", PACK_ENTRY_TYPE::TEXTURE, cook_texture },
+		{ "meshes", ".obj", PACK_ENTRY_TYPE::MESH, cook_mesh },
+		{ "fonts", ".ttf", PACK_ENTRY_TYPE::FONT, cook_font },
+		{ "audio", ".wav", PACK_ENTRY_TYPE::SOUND, cook_sound }
+	};
+
+	std::vector<CookedEntry> entries;
+	int failed = 0;
+	for (const Folder& folder : folders)
+	{
+		// Sorted so the same data always cooks to the same pack
+		std::vector<fs::path> files;
+		std::error_code error;
+		for (const fs::directory_entry& file : fs::directory_iterator(fs::path(data_dir) / folder.name, error))
+			if (file.is_regular_file() && file.path().extension() == folder.extension &&
+				!(folder.type == PACK_ENTRY_TYPE::SOUND && is_music(file.path())))
+				files.push_back(file.path());
+		std::sort(files.begin(), files.end());
+
+		for (const fs::path& file : files)
+		{
+			const std::string name = std::string(folder.name) + "/" + file.filename().string();
+			CookedEntry cooked = {};
+			if (name.size() >= sizeof(cooked.entry.name))
+			{
+				fprintf(stderr, "Skipping %s, the name is too long for the pack\n", name.c_str());
+				failed++;
+				continue;
+			}
+			if (!folder.cook(file.string(), cooked))
+			{
+				fprintf(stderr, "Failed to cook %s\n", file.string().c_str());
+				failed++;
+				continue;
+			}
+			strncpy(cooked.entry.name, name.c_str(), sizeof(cooked.entry.name) - 1);
+			cooked.entry.type = folder.type;
+			cooked.entry.size = cooked.data.size();
+			cooked.entry.hash = fnv1a(cooked.data.data(), cooked.data.size());
+			entries.push_back(std::move(cooked));
+		}
+	}
+
+	// Compare against the last cook so a rebuild says what actually changed
+	int changed = 0;
+	{
+		AssetPack previous;
+		previous.open(pack_file);
+		for (const CookedEntry& cooked : entries)
+		{
+			const PackEntry* old = previous.find(cooked.entry.name, cooked.entry.type);
+			if (old == nullptr || old->hash != cooked.entry.hash)
+			{
+				printf("  %s\n", cooked.entry.name);
+				changed++;
+			}
+		}
+	}
+
+	PackHeader header = { pack_magic, pack_version, (uint32_t)entries.size(), 0 };
+	size_t offset = align16(sizeof(PackHeader) + sizeof(PackEntry) * entries.size());
+	for (CookedEntry& cooked : entries)
+	{
+		cooked.entry.offset = offset;
+		offset = align16(offset + cooked.data.size());
+	}
+
+	// Written next to the pack and renamed over it, a failed cook never leaves half a pack
+	const std::string temp_file = pack_file + ".tmp";
+	FILE* file = fopen(temp_file.c_str(), "wb");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Could not open %s\n", temp_file.c_str());
+		return EXIT_FAILURE;
+	}
+	fwrite(&header, sizeof(header), 1, file);
+	for (const CookedEntry& cooked : entries)
+		fwrite(&cooked.entry, sizeof(PackEntry), 1, file);
+	const char padding[16] = { 0 };
+	for (const CookedEntry& cooked : entries)
+	{
+		fwrite(padding, 1, (size_t)cooked.entry.offset - (size_t)ftell(file), file);
+		fwrite(cooked.data.data(), 1, cooked.data.size(), file);
+	}
+	const bool written = ferror(file) == 0;
+	fclose(file);
+	std::error_code error;
+	if (!written || (fs::rename(temp_file, pack_file, error), error))
+	{
+		fprintf(stderr, "Could not write %s\n", pack_file.c_str());
+		fs::remove(temp_file, error);
+		return EXIT_FAILURE;
+	}
+
+	printf("Cooked %d entries (%d changed, %d failed), %.1f MB into %s\n", (int)entries.size(), changed, failed,
+		offset / (1024.f * 1024.f), pack_file.c_str());
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
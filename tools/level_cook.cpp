@@ -0,0 +1,76 @@
+// Offline level cooker, converts data/levels/*.level into the .lvl files read
+// through level_file.hpp
+//
+//   level_cook [levels directory]
+//
+// A .lvl records the hash of the text it was cooked from, the game cooks a
+// level in memory instead whenever the two no longer match.
+
+// internal
+#include "asset_pack.hpp"
+#include "level_file.hpp"
+
+// stlib
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char* argv[])
+{
+	const std::string levels_dir = argc > 1 ? argv[1] : level_path("");
+
+	// Sorted so the output is the same on every run
+	std::vector<fs::path> files;
+	std::error_code error;
+	for (const fs::directory_entry& file : fs::directory_iterator(fs::path(levels_dir), error))
+		if (file.is_regular_file() && file.path().extension() == ".level")
+			files.push_back(file.path());
+	std::sort(files.begin(), files.end());
+
+	int failed = 0;
+	for (const fs::path& file : files)
+	{
+		std::ifstream input(file, std::ios::binary);
+		const std::string text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		const std::string name = file.stem().string();
+
+		LevelData level;
+		if (!cook_level(text, name, level))
+		{
+			failed++;
+			continue;
+		}
+		const std::vector<unsigned char> bytes = write_cooked_level(level, fnv1a(text.data(), text.size()));
+
+		// Written next to the level and renamed over it, a failed cook never leaves half a file
+		fs::path cooked_file = file;
+		cooked_file.replace_extension(".lvl");
+		const fs::path temp_file = cooked_file.string() + ".tmp";
+		FILE* output = fopen(temp_file.string().c_str(), "wb");
+		const bool written = output != nullptr && fwrite(bytes.data(), 1, bytes.size(), output) == bytes.size();
+		if (output != nullptr)
+			fclose(output);
+		if (!written || (fs::rename(temp_file, cooked_file, error), error))
+		{
+			fprintf(stderr, "Could not write %s\n", cooked_file.string().c_str());
+			fs::remove(temp_file, error);
+			failed++;
+			continue;
+		}
+
+		uint32_t statics = 0;
+		for (uint32_t count : level.kind_count)
+			statics += count;
+		printf("  %s: %u statics (%u tiles in %d x %d cells), %u spawns, %u bytes\n", name.c_str(), statics,
+			level.kind_count[(int)LEVEL_STATIC::TILE], level.grid.dims.x, level.grid.dims.y,
+			(unsigned int)level.spawns.size(), (unsigned int)bytes.size());
+	}
+
+	printf("Cooked %d levels (%d failed) in %s\n", (int)files.size() - failed, failed, levels_dir.c_str());
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}